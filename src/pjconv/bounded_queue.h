@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-01
+ */
+
+
+#ifndef PJCONV_BOUNDED_QUEUE_H_
+#define PJCONV_BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace pjconv {
+
+/**
+ * A bounded lock-free queue for any number of producers and consumers.
+ *
+ * This is Dmitry Vyukov's array queue: each cell carries a sequence number
+ * that tells producers and consumers whose turn it is, so a push or a pop
+ * is one compare-and-swap on a position plus a release store on the cell.
+ * Neither blocks; callers decide how to wait when the queue is full or
+ * empty.
+ */
+template<typename T>
+class BoundedQueue {
+ public:
+  /**
+   * @param capacity the least number of elements the queue holds, rounded up to a power of two
+   */
+  explicit BoundedQueue(size_t capacity) : enqueue_pos_(0), dequeue_pos_(0) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const {
+    return mask_ + 1;
+  }
+
+  /**
+   * @return false if the queue is full
+   */
+  bool TryPush(const T& value) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @return false if the queue is empty
+   */
+  bool TryPop(T* value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          *value = cell.value;
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  BoundedQueue(const BoundedQueue&);
+  void operator=(const BoundedQueue&);
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  // Producers and consumers update their positions on separate cache lines
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_BOUNDED_QUEUE_H_
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-01
+ */
+
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/bounded_queue.h"
+
+namespace pjconv {
+
+TEST(BoundedQueue, FillsAndDrainsInOrder) {
+  BoundedQueue<int> queue(5);
+  ASSERT_EQ(8u, queue.capacity());
+  int value;
+  EXPECT_FALSE(queue.TryPop(&value));
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(queue.TryPush(i));
+    }
+    EXPECT_FALSE(queue.TryPush(8));
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(queue.TryPop(&value));
+      EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.TryPop(&value));
+  }
+}
+
+TEST(BoundedQueue, PassesEveryValueOnceBetweenThreads) {
+  BoundedQueue<int> queue(16);
+  const int kProducers = 3;
+  const int kConsumers = 3;
+  const int kValues = 20000;
+  std::vector<std::vector<int> > received(kConsumers);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.push_back(std::thread([&queue, p]() {
+      for (int i = p; i < kValues; i += kProducers) {
+        while (!queue.TryPush(i)) {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  std::atomic<int> remaining(kValues);
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.push_back(std::thread([&queue, &received, &remaining, c]() {
+      int value;
+      while (remaining.load() > 0) {
+        if (queue.TryPop(&value)) {
+          received[c].push_back(value);
+          --remaining;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  std::vector<int> seen(kValues, 0);
+  for (int c = 0; c < kConsumers; ++c) {
+    // Values from one producer arrive in the order it pushed them
+    std::vector<int> last(kProducers, -1);
+    for (size_t i = 0; i < received[c].size(); ++i) {
+      int value = received[c][i];
+      ++seen[value];
+      EXPECT_LT(last[value % kProducers], value);
+      last[value % kProducers] = value;
+    }
+  }
+  for (int i = 0; i < kValues; ++i) {
+    ASSERT_EQ(1, seen[i]) << i;
+  }
+}
+
+}  // namespace pjconv
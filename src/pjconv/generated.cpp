@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ */
+
+
+#include <mutex>
+#include <unordered_map>
+
+#include "pjconv/generated.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+struct Registered {
+  GeneratedPrototype prototype;
+  GeneratedJsonWriter writer;
+};
+
+typedef std::unordered_map<std::string, Registered> Registry;
+
+// Created on first use, as generated files register during static initialization
+Registry& GetRegistry(std::mutex** mutex) {
+  static std::mutex registry_mutex;
+  static Registry registry;
+  *mutex = &registry_mutex;
+  return registry;
+}
+
+}  // namespace
+
+void RegisterGeneratedJsonWriter(
+    const char* full_name,
+    GeneratedPrototype prototype,
+    GeneratedJsonWriter writer) {
+  std::mutex* mutex;
+  Registry& registry = GetRegistry(&mutex);
+  std::lock_guard<std::mutex> lock(*mutex);
+  Registered& entry = registry[full_name];
+  entry.prototype = prototype;
+  entry.writer = writer;
+}
+
+GeneratedJsonWriter FindGeneratedJsonWriter(const pb::Descriptor* type,
+                                            const pb::Message** prototype) {
+  std::mutex* mutex;
+  Registry& registry = GetRegistry(&mutex);
+  std::lock_guard<std::mutex> lock(*mutex);
+  Registry::const_iterator iter = registry.find(type->full_name());
+  if (iter == registry.end()) return NULL;
+  const pb::Message& instance = iter->second.prototype();
+  // A type of another pool, such as a dynamic one, may have the same name
+  if (instance.GetDescriptor() != type) return NULL;
+  *prototype = &instance;
+  return iter->second.writer;
+}
+
+}  // namespace pjconv
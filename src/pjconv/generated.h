@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ */
+
+
+#ifndef PJCONV_GENERATED_H_
+#define PJCONV_GENERATED_H_
+
+#include <cstring>
+#include <string>
+#include <google/protobuf/message.h>
+
+namespace pjconv {
+
+/**
+ * Where the generated JSON writer of a message type writes
+ *
+ * The code protoc-gen-pjconv generates calls the accessors of the message
+ * classes directly instead of going through reflection, and writes the
+ * same text as PJConverter::Write. It counts its fields and opens its
+ * profiler frames through the context as well, as the reflective writer
+ * does.
+ */
+class GeneratedJsonContext {
+ public:
+  /**
+   * @param output the string the JSON text is appended to
+   * @param convert_unset_fields whether to convert the unset fields
+   * @param flush_size pass the text on once the output holds this many bytes
+   * @param traced whether a ConversionProfiler traces the conversion
+   */
+  GeneratedJsonContext(std::string* output, bool convert_unset_fields, size_t flush_size,
+                       bool traced)
+      : output_(output), convert_unset_fields_(convert_unset_fields), flush_size_(flush_size),
+        traced_(traced) {
+  }
+  virtual ~GeneratedJsonContext() {
+  }
+
+  /** @return the string the JSON text is appended to */
+  std::string* output() const {
+    return output_;
+  }
+
+  /** @return whether to convert the unset fields in the protobuf message */
+  bool convert_unset_fields() const {
+    return convert_unset_fields_;
+  }
+
+  /** @return whether the conversion is traced, so writers open frames */
+  bool traced() const {
+    return traced_;
+  }
+
+  /**
+   * Count the fields a writer converted in a message for the conversion
+   * stats, each repeated field once
+   */
+  void CountFields(size_t fields);
+
+  /**
+   * Open a profiler frame in a traced conversion
+   *
+   * @param name the full name of a message type or the name of a field,
+   *     from its descriptor, so that it outlives the conversion
+   */
+  virtual void Enter(const std::string& name) = 0;
+
+  /** Close the frame opened last */
+  virtual void Leave() = 0;
+
+  /**
+   * Pass the text on if the output is full; writers call this after each
+   * member, so text written to a sink goes out in chunks
+   */
+  void MaybeFlush() {
+    if (output_->size() >= flush_size_) Flush();
+  }
+
+  /**
+   * Append a message of a type that has no generated writer
+   */
+  virtual void WriteNested(const google::protobuf::Message& message) = 0;
+
+ protected:
+  /** Pass the text in the output on and clear it */
+  virtual void Flush() = 0;
+
+ private:
+  GeneratedJsonContext(const GeneratedJsonContext&);
+  void operator=(const GeneratedJsonContext&);
+
+  std::string* output_;
+  bool convert_unset_fields_;
+  size_t flush_size_;
+  bool traced_;
+};
+
+/**
+ * Append a message as a JSON object; the message is of the generated class
+ * the writer is registered for
+ */
+typedef void (*GeneratedJsonWriter)(
+    const google::protobuf::Message& message,
+    GeneratedJsonContext* context);
+
+/**
+ * @return the default instance of a generated class
+ */
+typedef const google::protobuf::Message& (*GeneratedPrototype)();
+
+/**
+ * Make the converters write messages of a generated class with a generated
+ * writer. A converter looks the writer up when it first converts the type,
+ * so writers must be registered before that, as they are at startup.
+ *
+ * Registration only keeps the arguments, so it is safe during static
+ * initialization, before the descriptors of the class exist.
+ *
+ * @param full_name the full name of the message type
+ * @param prototype returns the default instance of the class
+ * @param writer the writer of the class
+ */
+void RegisterGeneratedJsonWriter(
+    const char* full_name,
+    GeneratedPrototype prototype,
+    GeneratedJsonWriter writer);
+
+/**
+ * @param type a message type
+ * @param prototype set to the default instance of the class the writer is for
+ * @return the registered writer of the type, or NULL if there is none,
+ *     such as when the type only shares its name with a generated one
+ */
+GeneratedJsonWriter FindGeneratedJsonWriter(
+    const google::protobuf::Descriptor* type,
+    const google::protobuf::Message** prototype);
+
+/**
+ * Append a string quoted and escaped as JSON
+ */
+void AppendJsonString(const char* data, size_t size, std::string* output);
+
+/**
+ * Append a double or a float as JSON, spelling NaN and the infinities the
+ * way Json::FastWriter does
+ */
+void AppendJsonDouble(double value, std::string* output);
+void AppendJsonFloat(float value, std::string* output);
+
+/**
+ * Append an integer as JSON
+ */
+void AppendJsonInt64(google::protobuf::int64 value, std::string* output);
+void AppendJsonUInt64(google::protobuf::uint64 value, std::string* output);
+
+/**
+ * Append a value of an open enum type that has no name, as the name
+ * reflection gives it
+ *
+ * @param type_name the name of the enum type, without its scope
+ */
+void AppendJsonUnknownEnum(const std::string& type_name, int number, std::string* output);
+
+inline void AppendJsonBool(bool value, std::string* output) {
+  if (value) {
+    output->append("true", 4);
+  } else {
+    output->append("false", 5);
+  }
+}
+
+/**
+ * Whether a field without presence counts as set, as Reflection::HasField
+ * decides: numbers by their bits, so -0.0 is set, and strings if not empty
+ */
+template<typename T>
+inline bool IsNonDefault(T value) {
+  return value != 0;
+}
+
+inline bool IsNonDefault(double value) {
+  google::protobuf::uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits != 0;
+}
+
+inline bool IsNonDefault(float value) {
+  google::protobuf::uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits != 0;
+}
+
+inline bool IsNonDefault(const std::string& value) {
+  return !value.empty();
+}
+
+}  // namespace pjconv
+#endif  // PJCONV_GENERATED_H_
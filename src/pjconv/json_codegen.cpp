@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ */
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+#include <google/protobuf/descriptor.pb.h>
+
+#include "pjconv/json_codegen.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+const char* const kKeywords[] = {
+  "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case",
+  "catch", "char", "class", "compl", "const", "const_cast", "continue",
+  "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+  "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+  "if", "inline", "int", "long", "mutable", "namespace", "new", "not",
+  "not_eq", "operator", "or", "or_eq", "private", "protected", "public",
+  "register", "reinterpret_cast", "return", "short", "signed", "sizeof",
+  "static", "static_cast", "struct", "switch", "template", "this", "throw",
+  "true", "try", "typedef", "typeid", "typename", "union", "unsigned",
+  "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+};
+
+bool FieldNameLess(const pb::FieldDescriptor* a, const pb::FieldDescriptor* b) {
+  return a->name() < b->name();
+}
+
+std::string StripProto(const std::string& name) {
+  size_t size = name.size();
+  if (size > 6 && name.compare(size - 6, 6, ".proto") == 0) return name.substr(0, size - 6);
+  return name;
+}
+
+// A file name as an identifier, the way protoc spells it
+std::string FilenameIdentifier(const std::string& name) {
+  std::string id;
+  for (size_t i = 0; i < name.size(); ++i) {
+    unsigned char c = name[i];
+    if (isalnum(c)) {
+      id.push_back(c);
+    } else {
+      char buf[4];
+      snprintf(buf, sizeof(buf), "_%02x", c);
+      id.append(buf);
+    }
+  }
+  return id;
+}
+
+// The name of the generated class of a type within its namespace
+template<typename Descriptor>
+std::string ClassName(const Descriptor* desc) {
+  std::string name = desc->full_name();
+  const std::string& package = desc->file()->package();
+  if (!package.empty()) name = name.substr(package.size() + 1);
+  std::replace(name.begin(), name.end(), '.', '_');
+  return name;
+}
+
+template<typename Descriptor>
+std::string QualifiedClassName(const Descriptor* desc) {
+  std::string name = "::";
+  const std::string& package = desc->file()->package();
+  for (size_t i = 0; i < package.size(); ++i) {
+    if (package[i] == '.') {
+      name.append("::");
+    } else {
+      name.push_back(package[i]);
+    }
+  }
+  if (!package.empty()) name.append("::");
+  return name + ClassName(desc);
+}
+
+// The name of the generated accessors of a field
+std::string FieldName(const pb::FieldDescriptor* field) {
+  std::string name = field->name();
+  for (size_t i = 0; i < name.size(); ++i) {
+    name[i] = tolower(static_cast<unsigned char>(name[i]));
+  }
+  const char* const* end = kKeywords + sizeof(kKeywords) / sizeof(kKeywords[0]);
+  if (std::find(kKeywords, end, name) != end) name.push_back('_');
+  return name;
+}
+
+// A C++ string literal; JSON names and enum value names are identifiers
+std::string Literal(const std::string& text) {
+  std::string literal = "\"";
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '"' || text[i] == '\\') literal.push_back('\\');
+    literal.push_back(text[i]);
+  }
+  literal.push_back('"');
+  return literal;
+}
+
+std::string Number(long long value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%lld", value);
+  return buf;
+}
+
+}  // namespace
+
+JsonCodeGenerator::JsonCodeGenerator(const pb::FileDescriptor* file) : file_(file) {
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    CollectMessages(file->message_type(i));
+  }
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    const pb::Descriptor* desc = messages_[i];
+    bool writable = !desc->options().map_entry();
+    for (int j = 0; j < desc->field_count() && writable; ++j) {
+      writable = !desc->field(j)->is_map() && !desc->field(j)->options().weak();
+    }
+    if (writable) writable_.insert(desc);
+  }
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    if (HasWriter(messages_[i])) CollectEnums(messages_[i]);
+  }
+}
+
+JsonCodeGenerator::~JsonCodeGenerator() {
+}
+
+void JsonCodeGenerator::CollectMessages(const pb::Descriptor* desc) {
+  messages_.push_back(desc);
+  for (int i = 0; i < desc->nested_type_count(); ++i) {
+    CollectMessages(desc->nested_type(i));
+  }
+}
+
+void JsonCodeGenerator::CollectEnums(const pb::Descriptor* desc) {
+  for (int i = 0; i < desc->field_count(); ++i) {
+    const pb::EnumDescriptor* type = desc->field(i)->enum_type();
+    if (!type || enum_functions_.count(type) > 0) continue;
+    // Enums of other packages may share a class name with one of this file
+    std::string base = "Append" + ClassName(type);
+    std::string name = base;
+    for (int n = 2; enum_function_names_.count(name) > 0; ++n) {
+      name = base + "_" + Number(n);
+    }
+    enums_.push_back(type);
+    enum_functions_[type] = name;
+    enum_function_names_.insert(name);
+  }
+}
+
+bool JsonCodeGenerator::HasWriter(const pb::Descriptor* desc) const {
+  return writable_.count(desc) > 0;
+}
+
+std::string JsonCodeGenerator::HeaderName() const {
+  return StripProto(file_->name()) + ".pjconv.h";
+}
+
+std::string JsonCodeGenerator::SourceName() const {
+  return StripProto(file_->name()) + ".pjconv.cc";
+}
+
+std::string JsonCodeGenerator::RegisterFunctionName() const {
+  return "pjconv_RegisterJsonWriters_" + FilenameIdentifier(file_->name());
+}
+
+std::string JsonCodeGenerator::GenerateHeader() const {
+  std::string guard = "PJCONV_GENERATED_" + FilenameIdentifier(file_->name()) + "__INCLUDED";
+  std::string out;
+  out += "// Generated by protoc-gen-pjconv.  DO NOT EDIT!\n";
+  out += "// source: " + file_->name() + "\n\n";
+  out += "#ifndef " + guard + "\n";
+  out += "#define " + guard + "\n\n";
+  out += "// Register the JSON writers of the messages of " + file_->name() + "\n";
+  out += "// with pjconv. Linking " + SourceName() + " into a program registers\n";
+  out += "// them at startup, but a static library leaves it out unless this is called.\n";
+  out += "void " + RegisterFunctionName() + "();\n\n";
+  out += "#endif  // " + guard + "\n";
+  return out;
+}
+
+std::string JsonCodeGenerator::GenerateSource() const {
+  std::string out;
+  out += "// Generated by protoc-gen-pjconv.  DO NOT EDIT!\n";
+  out += "// source: " + file_->name() + "\n\n";
+  out += "#include \"" + HeaderName() + "\"\n\n";
+  out += "#include <string>\n\n";
+  out += "#include \"" + StripProto(file_->name()) + ".pb.h\"\n";
+  out += "#include \"pjconv/generated.h\"\n\n";
+  out += "namespace {\n\n";
+
+  // Declared first, as messages can refer to each other in any order
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    const pb::Descriptor* desc = messages_[i];
+    if (!HasWriter(desc)) continue;
+    out += "void Write" + ClassName(desc) + "(const " + QualifiedClassName(desc) +
+        "& message, ::pjconv::GeneratedJsonContext* context);\n";
+  }
+  out += "\n";
+  for (size_t i = 0; i < enums_.size(); ++i) {
+    GenerateEnum(enums_[i], &out);
+  }
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    if (HasWriter(messages_[i])) GenerateMessage(messages_[i], &out);
+  }
+  out += "}  // namespace\n\n";
+
+  out += "void " + RegisterFunctionName() + "() {\n";
+  for (size_t i = 0; i < messages_.size(); ++i) {
+    const pb::Descriptor* desc = messages_[i];
+    if (!HasWriter(desc)) continue;
+    out += "  ::pjconv::RegisterGeneratedJsonWriter(\n";
+    out += "      " + Literal(desc->full_name()) + ", &" + ClassName(desc) + "Prototype, &Write" +
+        ClassName(desc) + "Message);\n";
+  }
+  out += "}\n\n";
+  out += "namespace {\n\n";
+  out += "struct StaticRegistration {\n";
+  out += "  StaticRegistration() {\n";
+  out += "    " + RegisterFunctionName() + "();\n";
+  out += "  }\n";
+  out += "} static_registration;\n\n";
+  out += "}  // namespace\n";
+  return out;
+}
+
+void JsonCodeGenerator::GenerateEnum(const pb::EnumDescriptor* desc, std::string* out) const {
+  *out += "void " + enum_functions_.find(desc)->second + "(int value, std::string* output) {\n";
+  *out += "  switch (value) {\n";
+  std::set<int> numbers;
+  for (int i = 0; i < desc->value_count(); ++i) {
+    const pb::EnumValueDescriptor* value = desc->value(i);
+    // Reflection names an aliased number after its first value
+    if (!numbers.insert(value->number()).second) continue;
+    std::string quoted = "\"" + value->name() + "\"";
+    // The smallest int has no literal of type int
+    std::string label = value->number() == -2147483647 - 1 ?
+        "-2147483647 - 1" : Number(value->number());
+    *out += "    case " + label + ":\n";
+    *out += "      output->append(" + Literal(quoted) + ", " + Number(quoted.size()) + ");\n";
+    *out += "      break;\n";
+  }
+  *out += "    default:\n";
+  *out += "      ::pjconv::AppendJsonUnknownEnum(" + Literal(desc->name()) + ", value, output);\n";
+  *out += "      break;\n";
+  *out += "  }\n";
+  *out += "}\n\n";
+}
+
+void JsonCodeGenerator::GenerateMessage(const pb::Descriptor* desc, std::string* out) const {
+  std::string name = ClassName(desc);
+  std::string qualified = QualifiedClassName(desc);
+  std::vector<const pb::FieldDescriptor*> fields;
+  bool singular = false;
+  for (int i = 0; i < desc->field_count(); ++i) {
+    fields.push_back(desc->field(i));
+    if (!desc->field(i)->is_repeated()) singular = true;
+  }
+  // The members in the key order of a Json::Value object
+  std::sort(fields.begin(), fields.end(), FieldNameLess);
+
+  *out += "// " + desc->full_name() + "\n";
+  *out += "void Write" + name + "(const " + qualified +
+      "& message, ::pjconv::GeneratedJsonContext* context) {\n";
+  *out += "  std::string* output = context->output();\n";
+  if (singular) *out += "  bool convert_unset_fields = context->convert_unset_fields();\n";
+  *out += "  bool traced = context->traced();\n";
+  *out += "  if (traced) context->Enter(" + qualified + "::descriptor()->full_name());\n";
+  *out += "  bool empty = true;\n";
+  *out += "  size_t fields = 0;\n";
+  for (size_t i = 0; i < fields.size(); ++i) {
+    GenerateField(fields[i], out);
+  }
+  *out += "  context->CountFields(fields);\n";
+  *out += "  if (empty) {\n";
+  *out += "    output->append(\"null\", 4);\n";
+  *out += "  } else {\n";
+  *out += "    output->push_back('}');\n";
+  *out += "  }\n";
+  *out += "  if (traced) context->Leave();\n";
+  *out += "}\n\n";
+
+  *out += "void Write" + name + "Message(const ::google::protobuf::Message& message,\n";
+  *out += "    ::pjconv::GeneratedJsonContext* context) {\n";
+  *out += "  Write" + name + "(static_cast<const " + qualified + "&>(message), context);\n";
+  *out += "}\n\n";
+  *out += "const ::google::protobuf::Message& " + name + "Prototype() {\n";
+  *out += "  return " + qualified + "::default_instance();\n";
+  *out += "}\n\n";
+}
+
+void JsonCodeGenerator::GenerateField(const pb::FieldDescriptor* field, std::string* out) const {
+  std::string name = FieldName(field);
+  std::string key = "\"" + field->name() + "\":";
+  if (field->is_repeated()) {
+    *out += "  if (message." + name + "_size() > 0) {\n";
+  } else if (field->has_presence()) {
+    *out += "  if (convert_unset_fields || message.has_" + name + "()) {\n";
+  } else {
+    *out += "  if (convert_unset_fields || ::pjconv::IsNonDefault(message." + name + "())) {\n";
+  }
+  *out += "    if (traced) context->Enter(" + QualifiedClassName(field->containing_type()) +
+      "::descriptor()->field(" + Number(field->index()) + ")->name());\n";
+  *out += "    output->append(empty ? " + Literal("{" + key) + " : " + Literal("," + key) + ", " +
+      Number(key.size() + 1) + ");\n";
+  *out += "    empty = false;\n";
+  *out += "    ++fields;\n";
+  if (field->is_repeated()) {
+    *out += "    output->push_back('[');\n";
+    *out += "    for (int i = 0; i < message." + name + "_size(); ++i) {\n";
+    *out += "      if (i > 0) output->push_back(',');\n";
+    GenerateValue(field, "message." + name + "(i)", "      ", out);
+    *out += "    }\n";
+    *out += "    output->push_back(']');\n";
+  } else {
+    GenerateValue(field, "message." + name + "()", "    ", out);
+  }
+  *out += "    if (traced) context->Leave();\n";
+  *out += "    context->MaybeFlush();\n";
+  *out += "  }\n";
+}
+
+void JsonCodeGenerator::GenerateValue(const pb::FieldDescriptor* field, const std::string& value,
+                                      const std::string& indent, std::string* out) const {
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      *out += indent + "::pjconv::AppendJsonInt64(" + value + ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      *out += indent + "::pjconv::AppendJsonUInt64(" + value + ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      *out += indent + "::pjconv::AppendJsonDouble(" + value + ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      *out += indent + "::pjconv::AppendJsonFloat(" + value + ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      *out += indent + "::pjconv::AppendJsonBool(" + value + ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      *out += indent + enum_functions_.find(field->enum_type())->second + "(" + value +
+          ", output);\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      *out += indent + "{\n";
+      *out += indent + "  const std::string& value = " + value + ";\n";
+      *out += indent + "  ::pjconv::AppendJsonString(value.data(), value.size(), output);\n";
+      *out += indent + "}\n";
+      break;
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      if (HasWriter(field->message_type())) {
+        *out += indent + "Write" + ClassName(field->message_type()) + "(" + value + ", context);\n";
+      } else {
+        *out += indent + "context->WriteNested(" + value + ");\n";
+      }
+      break;
+  }
+}
+
+}  // namespace pjconv
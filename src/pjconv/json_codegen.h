@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ */
+
+
+#ifndef PJCONV_JSON_CODEGEN_H_
+#define PJCONV_JSON_CODEGEN_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+
+namespace pjconv {
+
+/**
+ * Generates the C++ code protoc-gen-pjconv emits for a .proto file: a JSON
+ * writer for each message type that calls the generated accessors of its
+ * class instead of reflection.
+ *
+ * The writers write what JsonWriter writes. Types with map fields have no
+ * writer and are left to reflection, as is every type from another file;
+ * the writers hand such submessages back through GeneratedJsonContext.
+ * The generated source registers its writers when the program starts, and
+ * the generated header declares a function that does the same, for
+ * programs that link the code from a static library.
+ */
+class JsonCodeGenerator {
+ public:
+  /**
+   * @param file the file to generate code for, such as foo/bar.proto
+   */
+  explicit JsonCodeGenerator(const google::protobuf::FileDescriptor* file);
+  ~JsonCodeGenerator();
+
+  /** @return the name of the generated header, such as foo/bar.pjconv.h */
+  std::string HeaderName() const;
+  /** @return the name of the generated source, such as foo/bar.pjconv.cc */
+  std::string SourceName() const;
+  /** @return the name of the function that registers the writers */
+  std::string RegisterFunctionName() const;
+
+  std::string GenerateHeader() const;
+  std::string GenerateSource() const;
+
+ private:
+  JsonCodeGenerator(const JsonCodeGenerator&);
+  void operator=(const JsonCodeGenerator&);
+
+  void CollectMessages(const google::protobuf::Descriptor* desc);
+  void CollectEnums(const google::protobuf::Descriptor* desc);
+  bool HasWriter(const google::protobuf::Descriptor* desc) const;
+
+  void GenerateEnum(const google::protobuf::EnumDescriptor* desc, std::string* out) const;
+  void GenerateMessage(const google::protobuf::Descriptor* desc, std::string* out) const;
+  void GenerateField(const google::protobuf::FieldDescriptor* field, std::string* out) const;
+  void GenerateValue(const google::protobuf::FieldDescriptor* field, const std::string& value,
+                     const std::string& indent, std::string* out) const;
+
+  const google::protobuf::FileDescriptor* file_;
+  /** The message types of the file, outer ones first */
+  std::vector<const google::protobuf::Descriptor*> messages_;
+  /** The types with writers */
+  std::set<const google::protobuf::Descriptor*> writable_;
+  /** The enum types of the fields of the types with writers, in order of use */
+  std::vector<const google::protobuf::EnumDescriptor*> enums_;
+  /** The names of the functions that append the values of the enum types */
+  std::map<const google::protobuf::EnumDescriptor*, std::string> enum_functions_;
+  std::set<std::string> enum_function_names_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_CODEGEN_H_
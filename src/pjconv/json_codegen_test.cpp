@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/text_format.h>
+#include <gtest/gtest.h>
+
+#include "pjconv/generated.h"
+#include "pjconv/json_codegen.h"
+#include "pjconv/pjconv.h"
+#include "pjconv/profiler.h"
+#include "pjconv/proto/addressbook.pb.h"
+#include "pjconv/stats.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+const pb::FileDescriptor* BuildFile(const char* text, pb::DescriptorPool* pool) {
+  pb::FileDescriptorProto file;
+  EXPECT_TRUE(pb::TextFormat::ParseFromString(text, &file));
+  return pool->BuildFile(file);
+}
+
+bool Contains(const std::string& text, const std::string& part) {
+  return text.find(part) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(JsonCodeGenerator, NamesAfterTheFile) {
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* file = BuildFile(
+      "name: 'foo/bar-baz.proto' package: 'a.b' "
+      "message_type { name: 'M' "
+      "  field { name: 'class' number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 } "
+      "  nested_type { name: 'N' } "
+      "}", &pool);
+  ASSERT_TRUE(file != NULL);
+  JsonCodeGenerator generator(file);
+  EXPECT_EQ("foo/bar-baz.pjconv.h", generator.HeaderName());
+  EXPECT_EQ("foo/bar-baz.pjconv.cc", generator.SourceName());
+  EXPECT_EQ("pjconv_RegisterJsonWriters_foo_2fbar_2dbaz_2eproto",
+            generator.RegisterFunctionName());
+
+  std::string header = generator.GenerateHeader();
+  EXPECT_TRUE(Contains(header, "void pjconv_RegisterJsonWriters_foo_2fbar_2dbaz_2eproto();"));
+  std::string source = generator.GenerateSource();
+  EXPECT_TRUE(Contains(source, "#include \"foo/bar-baz.pb.h\""));
+  EXPECT_TRUE(Contains(source, "void WriteM(const ::a::b::M& message,"));
+  EXPECT_TRUE(Contains(source, "void WriteM_N(const ::a::b::M_N& message,"));
+  // Accessors named after C++ keywords get an underscore
+  EXPECT_TRUE(Contains(source, "message.has_class_()"));
+  EXPECT_TRUE(Contains(source, "\"a.b.M.N\", &M_NPrototype, &WriteM_NMessage"));
+  EXPECT_TRUE(Contains(source, "if (traced) context->Enter(::a::b::M_N::descriptor()->full_name());"));
+  EXPECT_TRUE(Contains(source, "context->CountFields(fields);"));
+}
+
+TEST(JsonCodeGenerator, FollowsPresenceAndLeavesMapsToReflection) {
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* file = BuildFile(
+      "name: 'event.proto' package: 'ev' syntax: 'proto3' "
+      "message_type { name: 'Event' "
+      "  field { name: 'id' number: 1 label: LABEL_OPTIONAL type: TYPE_INT64 } "
+      "  field { name: 'text' number: 2 label: LABEL_OPTIONAL type: TYPE_STRING oneof_index: 0 } "
+      "  field { name: 'level' number: 3 label: LABEL_OPTIONAL type: TYPE_ENUM "
+      "          type_name: '.ev.Level' } "
+      "  field { name: 'tagged' number: 4 label: LABEL_OPTIONAL type: TYPE_MESSAGE "
+      "          type_name: '.ev.Tagged' } "
+      "  oneof_decl { name: 'body' } "
+      "} "
+      "message_type { name: 'Tagged' "
+      "  field { name: 'tags' number: 1 label: LABEL_REPEATED type: TYPE_MESSAGE "
+      "          type_name: '.ev.Tagged.TagsEntry' } "
+      "  nested_type { name: 'TagsEntry' options { map_entry: true } "
+      "    field { name: 'key' number: 1 label: LABEL_OPTIONAL type: TYPE_STRING } "
+      "    field { name: 'value' number: 2 label: LABEL_OPTIONAL type: TYPE_STRING } "
+      "  } "
+      "} "
+      "enum_type { name: 'Level' options { allow_alias: true } "
+      "  value { name: 'LOW' number: 0 } value { name: 'LEAST' number: 0 } "
+      "  value { name: 'HIGH' number: -2147483648 } }", &pool);
+  ASSERT_TRUE(file != NULL);
+  std::string source = JsonCodeGenerator(file).GenerateSource();
+  // Fields without presence are set when they are not zero
+  EXPECT_TRUE(Contains(source, "::pjconv::IsNonDefault(message.id())"));
+  EXPECT_TRUE(Contains(source, "message.has_text()"));
+  EXPECT_TRUE(Contains(source, "message.has_tagged()"));
+  // An alias is written as the first name of its number
+  EXPECT_TRUE(Contains(source, "\"\\\"LOW\\\"\""));
+  EXPECT_FALSE(Contains(source, "LEAST"));
+  EXPECT_TRUE(Contains(source, "case -2147483647 - 1:"));
+  EXPECT_TRUE(Contains(source, "::pjconv::AppendJsonUnknownEnum(\"Level\", value, output);"));
+  // A type with a map field has no writer
+  EXPECT_FALSE(Contains(source, "void WriteTagged("));
+  EXPECT_TRUE(Contains(source, "context->WriteNested(message.tagged());"));
+}
+
+TEST(GeneratedJsonWriter, RegistersAtStartup) {
+  // add_pjconv_proto links the registration in without a call to it
+  const pb::Message* prototype = NULL;
+  EXPECT_TRUE(FindGeneratedJsonWriter(tutorial::Person::descriptor(), &prototype) != NULL);
+  EXPECT_EQ(&tutorial::Person::default_instance(), prototype);
+  EXPECT_TRUE(FindGeneratedJsonWriter(
+      tutorial::Person::PhoneNumber::descriptor(), &prototype) != NULL);
+  EXPECT_EQ(&tutorial::Person::PhoneNumber::default_instance(), prototype);
+}
+
+TEST(GeneratedJsonWriter, MatchesReflection) {
+  const pb::Message* prototype = NULL;
+  ASSERT_TRUE(FindGeneratedJsonWriter(tutorial::AddressBook::descriptor(), &prototype) != NULL);
+  EXPECT_EQ(&tutorial::AddressBook::default_instance(), prototype);
+
+  tutorial::AddressBook book;
+  tutorial::Person* person = book.add_person();
+  person->set_name("A \"quoted\"\n name \xE4\xB8\xAD");
+  person->set_id(-7);
+  tutorial::Person::PhoneNumber* phone = person->add_phone();
+  phone->set_number("555");
+  phone->set_type(tutorial::Person::WORK);
+  person->add_phone()->set_number("556");
+  person = book.add_person();
+  person->set_name("B");
+  person->set_id(2147483647);
+  person->set_email("b@example.com");
+  book.add_person();
+
+  // The same type in another pool only shares its name, so it goes
+  // through reflection
+  pb::FileDescriptorProto file;
+  tutorial::AddressBook::descriptor()->file()->CopyTo(&file);
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* copy = pool.BuildFile(file);
+  ASSERT_TRUE(copy != NULL);
+  const pb::Descriptor* dynamic_type = copy->FindMessageTypeByName("AddressBook");
+  EXPECT_TRUE(FindGeneratedJsonWriter(dynamic_type, &prototype) == NULL);
+  pb::DynamicMessageFactory factory(&pool);
+  std::unique_ptr<pb::Message> dynamic(factory.GetPrototype(dynamic_type)->New());
+  ASSERT_TRUE(dynamic->ParsePartialFromString(book.SerializePartialAsString()));
+
+  PJConverter conv;
+  for (int unset = 0; unset < 2; ++unset) {
+    ConvertOptions options;
+    options.convert_unset_fields = unset != 0;
+    std::string expected;
+    ASSERT_TRUE(conv.Write(*dynamic, &expected, options));
+    std::string json;
+    ASSERT_TRUE(conv.Write(book, &json, options));
+    EXPECT_EQ(expected, json);
+    test::StringSink sink;
+    ASSERT_TRUE(conv.Write(book, &sink, options));
+    EXPECT_EQ(expected, sink.text);
+  }
+
+  // A projection leaves fields out, which a generated writer cannot
+  std::vector<std::string> paths(1, "person.name");
+  std::unique_ptr<Projection> projection(conv.NewProjection(book.GetDescriptor(), paths));
+  ASSERT_TRUE(projection.get() != NULL);
+  ConvertOptions options;
+  options.projection = projection.get();
+  std::string json;
+  ASSERT_TRUE(conv.Write(book, &json, options));
+  EXPECT_EQ("{\"person\":[{\"name\":\"A \\\"quoted\\\"\\n name \xE4\xB8\xAD\"},"
+            "{\"name\":\"B\"},{\"name\":\"\"}]}", json);
+}
+
+TEST(GeneratedJsonWriter, CountsAndTracesLikeReflection) {
+  tutorial::AddressBook book;
+  tutorial::Person* person = book.add_person();
+  person->set_name("A");
+  person->set_id(1);
+  person->add_phone()->set_number("555");
+  book.add_person()->set_email("b@example.com");
+
+  pb::FileDescriptorProto file;
+  tutorial::AddressBook::descriptor()->file()->CopyTo(&file);
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* copy = pool.BuildFile(file);
+  ASSERT_TRUE(copy != NULL);
+  pb::DynamicMessageFactory factory(&pool);
+  std::unique_ptr<pb::Message> dynamic(
+      factory.GetPrototype(copy->FindMessageTypeByName("AddressBook"))->New());
+  ASSERT_TRUE(dynamic->ParsePartialFromString(book.SerializePartialAsString()));
+
+  PJConverter conv;
+  ConversionProfiler reflective(1);
+  ConversionProfiler generated(1);
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  options.profiler = &reflective;
+  std::string json;
+#ifdef PJCONV_STATS
+  SetConversionStatsEnabled(true);
+  ConversionStats before = GetConversionStats();
+#endif
+  ASSERT_TRUE(conv.Write(*dynamic, &json, options));
+#ifdef PJCONV_STATS
+  ConversionStats after = GetConversionStats();
+  EXPECT_EQ(before.fields_visited + 6, after.fields_visited);
+  before = after;
+#endif
+  options.profiler = &generated;
+  test::StringSink sink;
+  ASSERT_TRUE(conv.Write(book, &sink, options));
+#ifdef PJCONV_STATS
+  after = GetConversionStats();
+  EXPECT_EQ(before.fields_visited + 6, after.fields_visited);
+  SetConversionStatsEnabled(false);
+#endif
+  EXPECT_EQ(json, sink.text);
+  EXPECT_EQ(reflective.ToFolded(ConversionProfiler::kBytes),
+            generated.ToFolded(ConversionProfiler::kBytes));
+  EXPECT_NE(std::string::npos, generated.ToFolded(ConversionProfiler::kBytes).find(
+      "to_json;tutorial.AddressBook;person;tutorial.Person;phone;"
+      "tutorial.Person.PhoneNumber;number "));
+}
+
+}  // namespace pjconv
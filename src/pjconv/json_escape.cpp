@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-08
+ */
+
+
+#include "pjconv/json_escape.h"
+#include "pjconv/simd.h"
+
+namespace pjconv {
+
+namespace {
+
+FindEscapeFunc Choose() {
+  FindEscapeFunc func = FindEscapeAvx2();
+  if (!func) func = FindEscapeSse2();
+  return func ? func : FindEscapeScalar;
+}
+
+}  // namespace
+
+size_t FindEscape(const char* data, size_t size) {
+  // Short strings are not worth a call through a pointer
+  if (size < 16) return FindStringByteScalar<true>(data, size);
+  static const FindEscapeFunc find = Choose();
+  return find(data, size);
+}
+
+size_t FindEscapeScalar(const char* data, size_t size) {
+  return FindStringByteScalar<true>(data, size);
+}
+
+FindEscapeFunc FindEscapeSse2() {
+  return FindStringByteSse2(true);
+}
+
+FindEscapeFunc FindEscapeAvx2() {
+  return FindStringByteAvx2(true);
+}
+
+}  // namespace pjconv
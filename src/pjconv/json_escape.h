@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-08
+ */
+
+
+#ifndef PJCONV_JSON_ESCAPE_H_
+#define PJCONV_JSON_ESCAPE_H_
+
+#include <cstddef>
+
+namespace pjconv {
+
+/**
+ * Find the first byte of a string that JSON requires to be escaped: a
+ * quote, a backslash or a control byte below 0x20.
+ *
+ * Scans 32 bytes at a time with AVX2 or 16 with SSE2, chosen once by the
+ * CPU the process runs on, and a byte at a time elsewhere.
+ *
+ * @return the offset of the byte, or size if there is none
+ */
+size_t FindEscape(const char* data, size_t size);
+
+/**
+ * The implementations FindEscape chooses from, for tests. The SIMD ones
+ * are NULL when they are not compiled in or the CPU lacks them.
+ */
+typedef size_t (*FindEscapeFunc)(const char* data, size_t size);
+size_t FindEscapeScalar(const char* data, size_t size);
+FindEscapeFunc FindEscapeSse2();
+FindEscapeFunc FindEscapeAvx2();
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_ESCAPE_H_
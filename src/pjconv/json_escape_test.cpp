@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-08
+ */
+
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/json_escape.h"
+
+namespace pjconv {
+
+namespace {
+
+std::vector<FindEscapeFunc> Implementations() {
+  std::vector<FindEscapeFunc> funcs;
+  funcs.push_back(FindEscapeScalar);
+  funcs.push_back(FindEscape);
+  if (FindEscapeSse2()) funcs.push_back(FindEscapeSse2());
+  if (FindEscapeAvx2()) funcs.push_back(FindEscapeAvx2());
+  return funcs;
+}
+
+}  // namespace
+
+TEST(FindEscape, FindsEveryEscapedByteAtEveryOffset) {
+  std::vector<FindEscapeFunc> funcs = Implementations();
+  const char kEscaped[] = { '"', '\\', '\0', '\n', '\x1f' };
+  const char kPlain[] = { ' ', 'a', '~', '\x7f', '\x80', '\xff', '\x20', '\x5b' };
+  for (size_t size = 0; size <= 100; ++size) {
+    std::string clean(size, 'x');
+    for (size_t i = 0; i < size; ++i) {
+      clean[i] = kPlain[i % sizeof(kPlain)];
+    }
+    for (size_t f = 0; f < funcs.size(); ++f) {
+      ASSERT_EQ(size, funcs[f](clean.data(), size)) << "func " << f << " size " << size;
+    }
+    for (size_t pos = 0; pos < size; ++pos) {
+      for (size_t e = 0; e < sizeof(kEscaped); ++e) {
+        std::string text = clean;
+        text[pos] = kEscaped[e];
+        // A later escaped byte must not hide the first one
+        if (pos + 1 < size) text[size - 1] = '"';
+        for (size_t f = 0; f < funcs.size(); ++f) {
+          ASSERT_EQ(pos, funcs[f](text.data(), size))
+              << "func " << f << " size " << size << " byte " << e;
+        }
+      }
+    }
+  }
+}
+
+TEST(FindEscape, ReadsNoFurtherThanSize) {
+  std::vector<FindEscapeFunc> funcs = Implementations();
+  std::string text(64, 'x');
+  text += '"';
+  for (size_t size = 0; size <= 64; ++size) {
+    for (size_t f = 0; f < funcs.size(); ++f) {
+      EXPECT_EQ(size, funcs[f](text.data() + 64 - size, size));
+    }
+  }
+}
+
+}  // namespace pjconv
@@ -0,0 +1,990 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-27
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <google/protobuf/descriptor.h>
+
+#include "pjconv/json_parser.h"
+#include "pjconv/json_scan.h"
+#include "pjconv/number_format.h"
+#include "pjconv/profile_trace.h"
+#include "pjconv/stats_scope.h"
+#include "pjconv/wire_format.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+// Same nesting limit as Json::Reader
+const int kMaxDepth = 1000;
+
+const size_t kNoLink = static_cast<size_t>(-1);
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool ParseHex4(const char* p, unsigned* code) {
+  unsigned value = 0;
+  for (int i = 0; i < 4; ++i) {
+    char c = p[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      value |= c - 'A' + 10;
+    } else {
+      return false;
+    }
+  }
+  *code = value;
+  return true;
+}
+
+// Decode the hex digits of a \u escape, and those of the low half when
+// it starts a surrogate pair
+// @return the end of the escape, or NULL if it is not a code point
+const char* DecodeUnicodeEscape(const char* p, const char* end, unsigned* code) {
+  if (end - p < 4 || !ParseHex4(p, code)) return NULL;
+  p += 4;
+  // The low half of a pair means nothing on its own
+  if (*code >= 0xDC00 && *code <= 0xDFFF) return NULL;
+  if (*code >= 0xD800 && *code < 0xDC00) {
+    // A high surrogate must be followed by the low half of the pair
+    unsigned low;
+    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !ParseHex4(p + 2, &low) ||
+        low < 0xDC00 || low > 0xDFFF) {
+      return NULL;
+    }
+    p += 6;
+    *code = 0x10000 + ((*code - 0xD800) << 10) + (low - 0xDC00);
+  }
+  return p;
+}
+
+void AppendUtf8(unsigned code, std::string* out) {
+  if (code < 0x80) {
+    out->push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (code >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  }
+}
+
+// Decode an integral number into its sign and magnitude. As with
+// Json::Value::isIntegral, a number written with a fraction or an exponent
+// is accepted when its value is integral.
+bool DecodeIntegral(const char* data, size_t size, bool* negative, pb::uint64* magnitude) {
+  const char* p = data;
+  const char* end = data + size;
+  *negative = p != end && *p == '-';
+  if (*negative) ++p;
+  pb::uint64 value = 0;
+  const pb::uint64 kMax = std::numeric_limits<pb::uint64>::max();
+  for (; p != end && IsDigit(*p); ++p) {
+    unsigned digit = *p - '0';
+    if (value > (kMax - digit) / 10) break;
+    value = value * 10 + digit;
+  }
+  if (p == end) {
+    *magnitude = value;
+    return true;
+  }
+  // A fraction, an exponent or more than 64 bits: go through double
+  double d;
+  if (!ParseDouble(data, size, &d)) return false;
+  if (!(d > -9223372036854775809.0 && d < 18446744073709551616.0) || d != std::floor(d)) {
+    return false;
+  }
+  *negative = d < 0;
+  *magnitude = static_cast<pb::uint64>(*negative ? -d : d);
+  return true;
+}
+
+bool ToInt64(const char* data, size_t size, pb::int64 min, pb::int64 max, pb::int64* value) {
+  bool negative;
+  pb::uint64 magnitude;
+  if (!DecodeIntegral(data, size, &negative, &magnitude)) return false;
+  if (negative) {
+    if (magnitude > static_cast<pb::uint64>(-(min + 1)) + 1) return false;
+    *value = static_cast<pb::int64>(0 - magnitude);
+  } else {
+    if (magnitude > static_cast<pb::uint64>(max)) return false;
+    *value = static_cast<pb::int64>(magnitude);
+  }
+  return true;
+}
+
+void AppendTag(int number, int wire, std::string* bytes) {
+  AppendVarint((static_cast<pb::uint32>(number) << 3) | wire, bytes);
+}
+
+// Put the length of what follows the byte at mark, kept for it, in place
+void PatchLength(size_t mark, std::string* bytes) {
+  size_t size = bytes->size() - mark - 1;
+  if (size < 0x80) {
+    (*bytes)[mark] = static_cast<char>(size);
+    return;
+  }
+  char varint[10];
+  size_t n = EncodeVarint(size, varint) - varint;
+  bytes->insert(mark + 1, n - 1, '\0');
+  memcpy(&(*bytes)[mark], varint, n);
+}
+
+bool ToUInt64(const char* data, size_t size, pb::uint64 max, pb::uint64* value) {
+  bool negative;
+  pb::uint64 magnitude;
+  if (!DecodeIntegral(data, size, &negative, &magnitude)) return false;
+  if ((negative && magnitude != 0) || magnitude > max) return false;
+  *value = magnitude;
+  return true;
+}
+
+}  // namespace
+
+JsonParser::JsonParser(PlanCache* plans)
+    : plans_(plans), begin_(NULL), pos_(NULL), end_(NULL), depth_(0) {
+}
+
+JsonParser::~JsonParser() {
+}
+
+bool JsonParser::Parse(const char* json, size_t length, pb::Message* message,
+                       const Projection* projection) {
+  message->Clear();
+  const MessagePlan* plan = plans_->Get(message->GetDescriptor(), projection);
+  if (!plan) return false;
+  begin_ = json;
+  pos_ = json;
+  end_ = json + length;
+  depth_ = 0;
+  SkipWhitespace();
+  bool ok;
+  if (pos_ != end_ && *pos_ == '{') {
+    ok = ParseObject(*plan, message);
+  } else {
+    // Any other document converts to an empty message
+    ok = SkipValue();
+  }
+  if (ok) {
+    SkipWhitespace();
+    ok = pos_ == end_;
+  }
+  if (!ok) message->Clear();
+  return ok;
+}
+
+bool JsonParser::ParseToWire(const char* json, size_t length, const pb::Descriptor* desc,
+                             std::string* bytes, const Projection* projection) {
+  const MessagePlan* plan = plans_->Get(desc, projection);
+  if (!plan) return false;
+  begin_ = json;
+  pos_ = json;
+  end_ = json + length;
+  depth_ = 0;
+  wire_values_.clear();
+  wire_nodes_.clear();
+  wire_links_.clear();
+  wire_strings_.clear();
+  size_t root = NewWireNode(*plan);
+  SkipWhitespace();
+  bool ok;
+  if (pos_ != end_ && *pos_ == '{') {
+    ok = ParseWireObject(root);
+  } else {
+    ok = SkipValue();
+  }
+  if (ok) {
+    SkipWhitespace();
+    ok = pos_ == end_;
+  }
+  if (!ok) return false;
+
+  // Group the values by node, then by field number as SerializeToString orders them
+  std::sort(wire_values_.begin(), wire_values_.end());
+  for (size_t i = 0; i < wire_values_.size();) {
+    WireNode& node = wire_nodes_[wire_values_[i].node];
+    node.begin = i;
+    while (i < wire_values_.size() && &wire_nodes_[wire_values_[i].node] == &node) ++i;
+    node.end = i;
+  }
+  size_t start = bytes->size();
+  if (!WriteWireMessage(root, bytes)) {
+    bytes->resize(start);
+    return false;
+  }
+  return true;
+}
+
+bool JsonParser::ParseObject(const MessagePlan& plan, pb::Message* message) {
+  if (++depth_ > kMaxDepth) return false;
+  ProfileTrace* trace = ProfileTrace::Current();
+  if (trace) trace->Enter(plan.descriptor->full_name(), pos_ - begin_);
+  ++pos_;
+  const pb::Reflection* ref = message->GetReflection();
+  size_t members = 0;
+  size_t unknown = 0;
+  SkipWhitespace();
+  if (!Consume('}')) {
+    for (;;) {
+      const char* key;
+      size_t key_size;
+      SkipWhitespace();
+      if (pos_ == end_ || *pos_ != '"' || !ReadString(&key, &key_size)) return false;
+      SkipWhitespace();
+      if (!Consume(':')) return false;
+      SkipWhitespace();
+      const FieldPlan* field = plan.Find(key, key_size);
+      bool ok;
+      if (!field) {
+        ++unknown;
+        ok = SkipValue();
+      } else {
+        if (trace) trace->Enter(field->field->name(), pos_ - begin_);
+        if (field->repeated) {
+          ok = ParseRepeatedField(*field, message, ref);
+        } else {
+          ok = ParseValue(*field, message, ref, false);
+        }
+        if (trace) trace->Leave(pos_ - begin_);
+      }
+      if (!ok) return false;
+      ++members;
+      SkipWhitespace();
+      if (Consume(',')) continue;
+      if (Consume('}')) break;
+      return false;
+    }
+  }
+  StatsScope::CountFields(members - unknown);
+  StatsScope::CountUnknownKeys(unknown);
+  if (trace) trace->Leave(pos_ - begin_);
+  --depth_;
+  return true;
+}
+
+bool JsonParser::ParseRepeatedField(
+    const FieldPlan& field,
+    pb::Message* message,
+    const pb::Reflection* ref) {
+  if (pos_ == end_ || *pos_ != '[') return SkipValue();
+  if (++depth_ > kMaxDepth) return false;
+  ++pos_;
+  SkipWhitespace();
+  if (!Consume(']')) {
+    for (;;) {
+      SkipWhitespace();
+      if (!ParseValue(field, message, ref, true)) return false;
+      SkipWhitespace();
+      if (Consume(',')) continue;
+      if (Consume(']')) break;
+      return false;
+    }
+  }
+  --depth_;
+  return true;
+}
+
+bool JsonParser::ParseValue(
+    const FieldPlan& field,
+    pb::Message* message,
+    const pb::Reflection* ref,
+    bool repeated) {
+  if (pos_ == end_) return false;
+  if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+    pb::Message* submessage = repeated ?
+        ref->AddMessage(message, field.field) : ref->MutableMessage(message, field.field);
+    if (*pos_ == '{') return ParseObject(*field.message, submessage);
+    return SkipValue();
+  }
+  if (*pos_ == '{' || *pos_ == '[') {
+    StatsScope::CountDroppedValue();
+    return SkipValue();
+  }
+  Token token;
+  if (!ReadScalar(&token) || !CheckUtf8(token, field)) return false;
+  SetScalar(token, field, message, ref, repeated);
+  return true;
+}
+
+bool JsonParser::ParseWireObject(size_t node) {
+  if (++depth_ > kMaxDepth) return false;
+  ++pos_;
+  const MessagePlan& plan = *wire_nodes_[node].plan;
+  size_t members = 0;
+  size_t unknown = 0;
+  SkipWhitespace();
+  if (!Consume('}')) {
+    for (;;) {
+      const char* key;
+      size_t key_size;
+      SkipWhitespace();
+      if (pos_ == end_ || *pos_ != '"' || !ReadString(&key, &key_size)) return false;
+      SkipWhitespace();
+      if (!Consume(':')) return false;
+      SkipWhitespace();
+      const FieldPlan* field = plan.Find(key, key_size);
+      bool ok;
+      if (!field) {
+        ++unknown;
+        ok = SkipValue();
+      } else if (field->repeated) {
+        ok = ParseWireRepeatedField(node, *field);
+      } else {
+        ok = ParseWireValue(node, *field, false);
+      }
+      if (!ok) return false;
+      ++members;
+      SkipWhitespace();
+      if (Consume(',')) continue;
+      if (Consume('}')) break;
+      return false;
+    }
+  }
+  StatsScope::CountFields(members - unknown);
+  StatsScope::CountUnknownKeys(unknown);
+  --depth_;
+  return true;
+}
+
+bool JsonParser::ParseWireRepeatedField(size_t node, const FieldPlan& field) {
+  if (pos_ == end_ || *pos_ != '[') return SkipValue();
+  if (++depth_ > kMaxDepth) return false;
+  ++pos_;
+  SkipWhitespace();
+  if (!Consume(']')) {
+    for (;;) {
+      SkipWhitespace();
+      if (!ParseWireValue(node, field, true)) return false;
+      SkipWhitespace();
+      if (Consume(',')) continue;
+      if (Consume(']')) break;
+      return false;
+    }
+  }
+  --depth_;
+  return true;
+}
+
+bool JsonParser::ParseWireValue(size_t node, const FieldPlan& field, bool repeated) {
+  if (pos_ == end_) return false;
+  if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+    // As with MutableMessage, any value makes the message present
+    size_t child = wire_values_[AddWireValue(node, field, 0, repeated)].bits;
+    if (*pos_ == '{') return ParseWireObject(child);
+    return SkipValue();
+  }
+  if (*pos_ == '{' || *pos_ == '[') {
+    StatsScope::CountDroppedValue();
+    return SkipValue();
+  }
+  Token token;
+  if (!ReadScalar(&token) || !CheckUtf8(token, field)) return false;
+  pb::uint64 bits;
+  if (!DecodeScalar(token, field, &bits)) {
+    StatsScope::CountDroppedValue();
+    return true;
+  }
+  WireValue& value = wire_values_[AddWireValue(node, field, bits, repeated)];
+  if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_STRING) {
+    if (token.data == scratch_.data()) {
+      // Decoded escapes are overwritten by the next string, so keep a copy
+      value.offset = wire_strings_.size();
+      wire_strings_.append(token.data, token.size);
+    } else {
+      value.data = token.data;
+    }
+  }
+  return true;
+}
+
+size_t JsonParser::AddWireValue(size_t node, const FieldPlan& field, pb::uint64 bits,
+                                bool repeated) {
+  size_t seq = wire_values_.size();
+  int number = field.field->number();
+  size_t since = 0;
+  const pb::OneofDescriptor* oneof = field.field->containing_oneof();
+  if (oneof) {
+    // Setting a member of a oneof clears the others
+    int key = -1 - oneof->index();
+    size_t link = FindWireLink(node, key);
+    if (link == kNoLink) {
+      link = AddWireLink(node, key, number, seq);
+    } else if (wire_links_[link].target != static_cast<size_t>(number)) {
+      wire_links_[link].target = number;
+      wire_links_[link].since = seq;
+    }
+    since = wire_links_[link].since;
+  }
+  if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+    if (repeated) {
+      bits = NewWireNode(*field.message);
+    } else {
+      // A singular message merges all its values, unless its oneof moved on in between
+      size_t link = FindWireLink(node, number);
+      if (link != kNoLink && wire_links_[link].since >= since) {
+        bits = wire_links_[link].target;
+      } else {
+        bits = NewWireNode(*field.message);
+        if (link == kNoLink) {
+          AddWireLink(node, number, bits, seq);
+        } else {
+          wire_links_[link].target = bits;
+          wire_links_[link].since = seq;
+        }
+      }
+    }
+  }
+  WireValue value = {node, number, seq, &field, bits, NULL, 0};
+  wire_values_.push_back(value);
+  return seq;
+}
+
+size_t JsonParser::NewWireNode(const MessagePlan& plan) {
+  WireNode node = {&plan, 0, 0, kNoLink};
+  wire_nodes_.push_back(node);
+  return wire_nodes_.size() - 1;
+}
+
+size_t JsonParser::FindWireLink(size_t node, int key) const {
+  size_t link = wire_nodes_[node].links;
+  while (link != kNoLink && wire_links_[link].key != key) link = wire_links_[link].next;
+  return link;
+}
+
+size_t JsonParser::AddWireLink(size_t node, int key, size_t target, size_t since) {
+  WireLink link = {key, target, since, wire_nodes_[node].links};
+  wire_links_.push_back(link);
+  wire_nodes_[node].links = wire_links_.size() - 1;
+  return wire_nodes_[node].links;
+}
+
+bool JsonParser::WriteWireMessage(size_t node, std::string* bytes) {
+  const WireNode& message = wire_nodes_[node];
+  int required = 0;
+  for (size_t i = message.begin; i < message.end;) {
+    size_t first = i;
+    int number = wire_values_[i].number;
+    while (i < message.end && wire_values_[i].number == number) ++i;
+    const FieldPlan& field = *wire_values_[first].field;
+    const pb::FieldDescriptor* desc = field.field;
+    bool group = desc->type() == pb::FieldDescriptor::TYPE_GROUP;
+
+    if (field.repeated) {
+      if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+        for (size_t j = first; j < i; ++j) {
+          if (group) {
+            AppendTag(number, kStartGroup, bytes);
+            if (!WriteWireMessage(wire_values_[j].bits, bytes)) return false;
+            AppendTag(number, kEndGroup, bytes);
+          } else {
+            AppendTag(number, kLengthDelimited, bytes);
+            if (!WriteWireNested(wire_values_[j].bits, bytes)) return false;
+          }
+        }
+      } else if (desc->is_packed()) {
+        AppendTag(number, kLengthDelimited, bytes);
+        size_t mark = bytes->size();
+        bytes->push_back('\0');
+        for (size_t j = first; j < i; ++j) {
+          WriteWireScalar(wire_values_[j], bytes);
+        }
+        PatchLength(mark, bytes);
+      } else {
+        for (size_t j = first; j < i; ++j) {
+          AppendTag(number, WireTypeOf(desc->type()), bytes);
+          WriteWireScalar(wire_values_[j], bytes);
+        }
+      }
+      continue;
+    }
+
+    // The last value wins, if its oneof still has it
+    const WireValue& last = wire_values_[i - 1];
+    const pb::OneofDescriptor* oneof = desc->containing_oneof();
+    if (oneof &&
+        wire_links_[FindWireLink(node, -1 - oneof->index())].target != static_cast<size_t>(number)) {
+      continue;
+    }
+    if (desc->is_required()) ++required;
+    if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (group) {
+        AppendTag(number, kStartGroup, bytes);
+        if (!WriteWireMessage(last.bits, bytes)) return false;
+        AppendTag(number, kEndGroup, bytes);
+      } else {
+        AppendTag(number, kLengthDelimited, bytes);
+        if (!WriteWireNested(last.bits, bytes)) return false;
+      }
+    } else if (desc->has_presence() || last.bits != 0) {
+      // A field without presence is not written when it holds zero or ""
+      AppendTag(number, WireTypeOf(desc->type()), bytes);
+      WriteWireScalar(last, bytes);
+    }
+  }
+  // SerializeToString fails on a missing required field
+  return required == message.plan->required_count;
+}
+
+bool JsonParser::WriteWireNested(size_t node, std::string* bytes) {
+  // One byte for the length, which is moved along when it needs more
+  size_t mark = bytes->size();
+  bytes->push_back('\0');
+  if (!WriteWireMessage(node, bytes)) return false;
+  PatchLength(mark, bytes);
+  return true;
+}
+
+void JsonParser::WriteWireScalar(const WireValue& value, std::string* bytes) {
+  pb::uint64 bits = value.bits;
+  switch (value.field->field->type()) {
+    case pb::FieldDescriptor::TYPE_SINT32: {
+      pb::uint32 n = static_cast<pb::uint32>(bits);
+      AppendVarint((n << 1) ^ (0 - (n >> 31)), bytes);
+      break;
+    }
+    case pb::FieldDescriptor::TYPE_SINT64:
+      AppendVarint((bits << 1) ^ (0 - (bits >> 63)), bytes);
+      break;
+    case pb::FieldDescriptor::TYPE_FIXED32:
+    case pb::FieldDescriptor::TYPE_SFIXED32:
+    case pb::FieldDescriptor::TYPE_FLOAT:
+      AppendFixed(bits, 4, bytes);
+      break;
+    case pb::FieldDescriptor::TYPE_FIXED64:
+    case pb::FieldDescriptor::TYPE_SFIXED64:
+    case pb::FieldDescriptor::TYPE_DOUBLE:
+      AppendFixed(bits, 8, bytes);
+      break;
+    case pb::FieldDescriptor::TYPE_STRING:
+    case pb::FieldDescriptor::TYPE_BYTES:
+      AppendVarint(bits, bytes);
+      if (value.data) {
+        bytes->append(value.data, bits);
+      } else {
+        bytes->append(wire_strings_, value.offset, bits);
+      }
+      break;
+    default:
+      // Negative int32 and enum values are sign-extended to ten bytes
+      AppendVarint(bits, bytes);
+      break;
+  }
+}
+
+bool JsonParser::DecodeScalar(const Token& token, const FieldPlan& field, pb::uint64* bits) {
+  bool number = token.type == Token::kNumber;
+  switch (field.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32: {
+      pb::int64 value;
+      if (!number || !ToInt64(token.data, token.size, std::numeric_limits<pb::int32>::min(),
+                              std::numeric_limits<pb::int32>::max(), &value)) {
+        return false;
+      }
+      *bits = static_cast<pb::uint64>(value);
+      return true;
+    }
+    case pb::FieldDescriptor::CPPTYPE_INT64: {
+      pb::int64 value;
+      if (!number || !ToInt64(token.data, token.size, std::numeric_limits<pb::int64>::min(),
+                              std::numeric_limits<pb::int64>::max(), &value)) {
+        return false;
+      }
+      *bits = static_cast<pb::uint64>(value);
+      return true;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+      return number && ToUInt64(token.data, token.size, std::numeric_limits<pb::uint32>::max(),
+                                bits);
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      return number && ToUInt64(token.data, token.size, std::numeric_limits<pb::uint64>::max(),
+                                bits);
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE: {
+      double value;
+      if (!number || !ParseDouble(token.data, token.size, &value)) return false;
+      memcpy(bits, &value, sizeof(value));
+      return true;
+    }
+    case pb::FieldDescriptor::CPPTYPE_FLOAT: {
+      float value;
+      if (!number || !ParseFloat(token.data, token.size, &value)) return false;
+      pb::uint32 value_bits;
+      memcpy(&value_bits, &value, sizeof(value));
+      *bits = value_bits;
+      return true;
+    }
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      if (token.type != Token::kTrue && token.type != Token::kFalse) return false;
+      *bits = token.type == Token::kTrue;
+      return true;
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      const pb::EnumValueDescriptor* value = NULL;
+      if (token.type == Token::kString) {
+        value = field.enums->FindByName(token.data, token.size);
+      } else if (number) {
+        pb::int64 n;
+        if (ToInt64(token.data, token.size, std::numeric_limits<pb::int32>::min(),
+                    std::numeric_limits<pb::int32>::max(), &n)) {
+          value = field.enums->FindByNumber(static_cast<int>(n));
+        }
+      }
+      if (!value) return false;
+      *bits = static_cast<pb::uint64>(static_cast<pb::int64>(value->number()));
+      return true;
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      *bits = token.size;
+      return token.type == Token::kString;
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+  return false;
+}
+
+void JsonParser::SetScalar(
+    const Token& token,
+    const FieldPlan& field_plan,
+    pb::Message* message,
+    const pb::Reflection* ref,
+    bool repeated) {
+  pb::uint64 bits;
+  if (!DecodeScalar(token, field_plan, &bits)) {
+    StatsScope::CountDroppedValue();
+    return;
+  }
+  const pb::FieldDescriptor* field = field_plan.field;
+  switch (field_plan.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32: {
+      pb::int32 value = static_cast<pb::int32>(bits);
+      if (repeated) {
+        ref->AddInt32(message, field, value);
+      } else {
+        ref->SetInt32(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_INT64: {
+      pb::int64 value = static_cast<pb::int64>(bits);
+      if (repeated) {
+        ref->AddInt64(message, field, value);
+      } else {
+        ref->SetInt64(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT32: {
+      pb::uint32 value = static_cast<pb::uint32>(bits);
+      if (repeated) {
+        ref->AddUInt32(message, field, value);
+      } else {
+        ref->SetUInt32(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      if (repeated) {
+        ref->AddUInt64(message, field, bits);
+      } else {
+        ref->SetUInt64(message, field, bits);
+      }
+      break;
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE: {
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      if (repeated) {
+        ref->AddDouble(message, field, value);
+      } else {
+        ref->SetDouble(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_FLOAT: {
+      pb::uint32 value_bits = static_cast<pb::uint32>(bits);
+      float value;
+      memcpy(&value, &value_bits, sizeof(value));
+      if (repeated) {
+        ref->AddFloat(message, field, value);
+      } else {
+        ref->SetFloat(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      if (repeated) {
+        ref->AddBool(message, field, bits != 0);
+      } else {
+        ref->SetBool(message, field, bits != 0);
+      }
+      break;
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      int value = static_cast<int>(bits);
+      if (repeated) {
+        ref->AddEnumValue(message, field, value);
+      } else {
+        ref->SetEnumValue(message, field, value);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      if (repeated) {
+        ref->AddString(message, field, std::string(token.data, token.size));
+      } else {
+        ref->SetString(message, field, std::string(token.data, token.size));
+      }
+      break;
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+bool JsonParser::CheckUtf8(const Token& token, const FieldPlan& field) {
+  // Bytes fields keep the bytes the writer copied out, UTF-8 or not
+  return token.type != Token::kString ||
+      field.field->type() != pb::FieldDescriptor::TYPE_STRING ||
+      ValidateUtf8(token.data, token.size);
+}
+
+bool JsonParser::ReadScalar(Token* token) {
+  if (pos_ == end_) return false;
+  switch (*pos_) {
+    case '"':
+      token->type = Token::kString;
+      return ReadString(&token->data, &token->size);
+    case 't':
+      token->type = Token::kTrue;
+      return ReadLiteral("true", 4);
+    case 'f':
+      token->type = Token::kFalse;
+      return ReadLiteral("false", 5);
+    case 'n':
+      token->type = Token::kNull;
+      return ReadLiteral("null", 4);
+    default:
+      return ReadNumber(token);
+  }
+}
+
+bool JsonParser::ReadString(const char** data, size_t* size) {
+  ++pos_;
+  const char* start = pos_;
+  pos_ += FindQuoteOrBackslash(pos_, end_ - pos_);
+  if (pos_ == end_) return false;
+  if (*pos_ == '"') {
+    // No escapes: hand out the bytes of the input
+    *data = start;
+    *size = pos_ - start;
+    ++pos_;
+    return true;
+  }
+  scratch_.assign(start, pos_);
+  for (;;) {
+    size_t run = FindQuoteOrBackslash(pos_, end_ - pos_);
+    scratch_.append(pos_, run);
+    pos_ += run;
+    if (pos_ == end_) return false;
+    char c = *pos_++;
+    if (c == '"') {
+      *data = scratch_.data();
+      *size = scratch_.size();
+      return true;
+    }
+    if (pos_ == end_) return false;
+    c = *pos_++;
+    switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        scratch_.push_back(c);
+        break;
+      case 'b': scratch_.push_back('\b'); break;
+      case 'f': scratch_.push_back('\f'); break;
+      case 'n': scratch_.push_back('\n'); break;
+      case 'r': scratch_.push_back('\r'); break;
+      case 't': scratch_.push_back('\t'); break;
+      case 'u': {
+        unsigned code;
+        pos_ = DecodeUnicodeEscape(pos_, end_, &code);
+        if (!pos_) return false;
+        AppendUtf8(code, &scratch_);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+bool JsonParser::ReadNumber(Token* token) {
+  const char* p = pos_;
+  if (p != end_ && *p == '-') ++p;
+  if (p == end_ || !IsDigit(*p)) return false;
+  while (p != end_ && IsDigit(*p)) ++p;
+  if (p != end_ && *p == '.') {
+    ++p;
+    if (p == end_ || !IsDigit(*p)) return false;
+    while (p != end_ && IsDigit(*p)) ++p;
+  }
+  if (p != end_ && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != end_ && (*p == '+' || *p == '-')) ++p;
+    if (p == end_ || !IsDigit(*p)) return false;
+    while (p != end_ && IsDigit(*p)) ++p;
+  }
+  token->type = Token::kNumber;
+  token->data = pos_;
+  token->size = p - pos_;
+  pos_ = p;
+  return true;
+}
+
+bool JsonParser::ReadLiteral(const char* literal, size_t size) {
+  if (static_cast<size_t>(end_ - pos_) < size || memcmp(pos_, literal, size) != 0) return false;
+  pos_ += size;
+  return true;
+}
+
+bool JsonParser::SkipValue() {
+  // Keep the closing bracket of each open array or object instead of
+  // recursing, so skipping never decodes anything but checks the structure
+  skip_stack_.clear();
+  for (;;) {
+    // A value is expected here
+    SkipWhitespace();
+    if (pos_ == end_) return false;
+    char c = *pos_;
+    if (c == '{' || c == '[') {
+      ++pos_;
+      char close = c == '{' ? '}' : ']';
+      SkipWhitespace();
+      if (!Consume(close)) {
+        if (depth_ + static_cast<int>(skip_stack_.size()) >= kMaxDepth) return false;
+        skip_stack_.push_back(close);
+        if (close == '}' && !SkipKey()) return false;
+        continue;
+      }
+    } else if (c == '"') {
+      if (!SkipString()) return false;
+    } else {
+      Token token;
+      if (!ReadScalar(&token)) return false;
+    }
+    // A value has ended: close what it ends, or go on to the next member
+    for (;;) {
+      if (skip_stack_.empty()) return true;
+      SkipWhitespace();
+      if (Consume(',')) {
+        if (skip_stack_.back() == '}' && !SkipKey()) return false;
+        break;
+      }
+      if (!Consume(skip_stack_.back())) return false;
+      skip_stack_.pop_back();
+    }
+  }
+}
+
+bool JsonParser::SkipKey() {
+  SkipWhitespace();
+  if (pos_ == end_ || *pos_ != '"' || !SkipString()) return false;
+  SkipWhitespace();
+  return Consume(':');
+}
+
+bool JsonParser::SkipString() {
+  ++pos_;
+  for (;;) {
+    pos_ += FindQuoteOrBackslash(pos_, end_ - pos_);
+    if (pos_ == end_) return false;
+    if (*pos_++ == '"') return true;
+    if (pos_ == end_) return false;
+    // The escapes are checked as ReadString decodes them
+    switch (*pos_++) {
+      case '"':
+      case '\\':
+      case '/':
+      case 'b':
+      case 'f':
+      case 'n':
+      case 'r':
+      case 't':
+        break;
+      case 'u': {
+        unsigned code;
+        pos_ = DecodeUnicodeEscape(pos_, end_, &code);
+        if (!pos_) return false;
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+void JsonParser::SkipWhitespace() {
+  for (;;) {
+    while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+      ++pos_;
+    }
+    // Json::Reader accepts C and C++ style comments as well
+    if (end_ - pos_ < 2 || pos_[0] != '/') return;
+    if (pos_[1] == '/') {
+      while (pos_ != end_ && *pos_ != '\n') ++pos_;
+    } else if (pos_[1] == '*') {
+      const char* p = pos_ + 2;
+      while (end_ - p >= 2 && !(p[0] == '*' && p[1] == '/')) ++p;
+      // An unclosed comment is left unread, so the token expected there is missing
+      if (end_ - p < 2) return;
+      pos_ = p + 2;
+    } else {
+      return;
+    }
+  }
+}
+
+bool JsonParser::Consume(char c) {
+  if (pos_ != end_ && *pos_ == c) {
+    ++pos_;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace pjconv
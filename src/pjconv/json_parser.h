@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-27
+ */
+
+#ifndef PJCONV_JSON_PARSER_H_
+#define PJCONV_JSON_PARSER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <google/protobuf/message.h>
+
+#include "pjconv/plan.h"
+
+namespace pjconv {
+
+/**
+ * Parses JSON text straight into a protobuf message.
+ *
+ * The input is tokenized in place and every value is handed to the
+ * reflection setters as soon as it is lexed, so no Json::Value is built.
+ * Keys that do not name a field have their values skipped by counting
+ * brackets and stepping over strings, without decoding them.
+ *
+ * Values follow the rules of PJConverter::Convert(const Json::Value&, ...):
+ * values whose JSON type does not fit the field are dropped. Unlike
+ * Json::Reader, the parser rejects values of string fields that are not
+ * well-formed UTF-8; values of bytes fields may hold any bytes, as the
+ * writers copy them out as they are.
+ *
+ * A parser keeps scratch buffers between calls, so reusing one instance
+ * avoids allocations; an instance must not be used by two threads at once.
+ */
+class JsonParser {
+ public:
+  /**
+   * @param plans the cache of conversion plans
+   */
+  explicit JsonParser(PlanCache* plans);
+  ~JsonParser();
+
+  /**
+   * Parse a JSON document into a protobuf message
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param message the output protobuf message, cleared before parsing
+   * @param projection if not NULL, the members of the fields it leaves out
+   *        are skipped like unknown ones
+   * @return true if the input is a well-formed JSON document; on failure
+   *         the message is cleared
+   */
+  bool Parse(const char* json, size_t length, google::protobuf::Message* message,
+             const Projection* projection = NULL);
+
+  /**
+   * Parse a JSON document straight into the protobuf wire format
+   *
+   * The bytes are those SerializeToString gives for the message Parse
+   * fills from the same text, but no message is built: the values are
+   * gathered per message and written in field number order, and the
+   * length of each embedded message is patched in once it is written.
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param desc the type of the message
+   * @param bytes the string the serialized message is appended to
+   * @param projection if not NULL, the members of the fields it leaves out
+   *        are skipped like unknown ones
+   * @return true if the input is a well-formed JSON document and every
+   *         selected required field is set; on failure the string is left
+   *         as it was
+   */
+  bool ParseToWire(const char* json, size_t length, const google::protobuf::Descriptor* desc,
+                   std::string* bytes, const Projection* projection = NULL);
+
+ private:
+  /**
+   * A scalar token; strings point either into the input or into scratch_
+   */
+  struct Token {
+    enum Type { kString, kNumber, kTrue, kFalse, kNull };
+    Type type;
+    const char* data;
+    size_t size;
+  };
+
+  /**
+   * A value bound for the wire, in the message node it belongs to. Numbers
+   * hold the bits of their C++ type and messages the node of their fields.
+   */
+  struct WireValue {
+    size_t node;
+    int number;
+    /** The order in which the values were parsed */
+    size_t seq;
+    const FieldPlan* field;
+    google::protobuf::uint64 bits;
+    /** The bytes of a string: in the input, or at offset in wire_strings_ if NULL */
+    const char* data;
+    size_t offset;
+
+    bool operator<(const WireValue& other) const {
+      if (node != other.node) return node < other.node;
+      if (number != other.number) return number < other.number;
+      return seq < other.seq;
+    }
+  };
+
+  /** A message being encoded, and its values once they are sorted */
+  struct WireNode {
+    const MessagePlan* plan;
+    size_t begin;
+    size_t end;
+    /** The first of the node's links, or kNoLink */
+    size_t links;
+  };
+
+  /**
+   * What a node remembers of its fields: the submessage a singular message
+   * field merges into, or the member of a oneof set last
+   */
+  struct WireLink {
+    /** The field number, or -1 minus the index of the oneof */
+    int key;
+    /** The node of the submessage, or the number of the oneof member */
+    size_t target;
+    /** The seq of the value that created or switched the link */
+    size_t since;
+    size_t next;
+  };
+
+  bool ParseObject(const MessagePlan& plan, google::protobuf::Message* message);
+  bool ParseRepeatedField(const FieldPlan& field,
+                          google::protobuf::Message* message,
+                          const google::protobuf::Reflection* ref);
+  bool ParseValue(const FieldPlan& field,
+                  google::protobuf::Message* message,
+                  const google::protobuf::Reflection* ref,
+                  bool repeated);
+  /** @return false if the token is a string of a string field and not UTF-8 */
+  bool CheckUtf8(const Token& token, const FieldPlan& field);
+  bool DecodeScalar(const Token& token, const FieldPlan& field, google::protobuf::uint64* bits);
+  void SetScalar(const Token& token,
+                 const FieldPlan& field,
+                 google::protobuf::Message* message,
+                 const google::protobuf::Reflection* ref,
+                 bool repeated);
+
+  bool ParseWireObject(size_t node);
+  bool ParseWireRepeatedField(size_t node, const FieldPlan& field);
+  bool ParseWireValue(size_t node, const FieldPlan& field, bool repeated);
+  size_t AddWireValue(size_t node, const FieldPlan& field, google::protobuf::uint64 bits,
+                      bool repeated);
+  size_t NewWireNode(const MessagePlan& plan);
+  size_t FindWireLink(size_t node, int key) const;
+  size_t AddWireLink(size_t node, int key, size_t target, size_t since);
+  bool WriteWireMessage(size_t node, std::string* bytes);
+  bool WriteWireNested(size_t node, std::string* bytes);
+  void WriteWireScalar(const WireValue& value, std::string* bytes);
+
+  bool ReadScalar(Token* token);
+  bool ReadString(const char** data, size_t* size);
+  bool ReadNumber(Token* token);
+  bool ReadLiteral(const char* literal, size_t size);
+  bool SkipValue();
+  /** Skip an object key and the colon after it */
+  bool SkipKey();
+  bool SkipString();
+  void SkipWhitespace();
+  bool Consume(char c);
+
+  PlanCache* plans_;
+  /** The start of the text, which the profiled bytes are counted from */
+  const char* begin_;
+  const char* pos_;
+  const char* end_;
+  int depth_;
+  std::string scratch_;
+  /** The closing brackets of the arrays and objects SkipValue is in */
+  std::string skip_stack_;
+  std::vector<WireValue> wire_values_;
+  std::vector<WireNode> wire_nodes_;
+  std::vector<WireLink> wire_links_;
+  /** The strings that had escapes, decoded */
+  std::string wire_strings_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_PARSER_H_
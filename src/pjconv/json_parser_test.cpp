@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-27
+ */
+
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "pjconv/json_parser.h"
+#include "pjconv/json_writer.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+bool Parse(const std::string& json, pb::Message* message) {
+  PlanCache plans;
+  JsonParser parser(&plans);
+  return parser.Parse(json.data(), json.size(), message);
+}
+
+TEST(JsonParser, RoundTripsAllTypes) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  test::BuildTypes(m.get());
+  PlanCache plans;
+  std::string json;
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(*m);
+
+  std::unique_ptr<pb::Message> m2(test::NewTypes());
+  ASSERT_TRUE(Parse(json, m2.get())) << json;
+  EXPECT_EQ(m->DebugString(), m2->DebugString());
+}
+
+TEST(JsonParser, KeepsBytesThatAreNotUtf8) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  const pb::FieldDescriptor* by = m->GetDescriptor()->FindFieldByName("by");
+  m->GetReflection()->SetString(m.get(), by, std::string("\xff\xc3(\xed\xa0\x80\0\x80", 8));
+  PlanCache plans;
+  std::string json;
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(*m);
+
+  std::unique_ptr<pb::Message> m2(test::NewTypes());
+  ASSERT_TRUE(Parse(json, m2.get())) << json;
+  EXPECT_EQ(m->SerializeAsString(), m2->SerializeAsString());
+  // Only the values of string fields have to be UTF-8
+  EXPECT_FALSE(Parse("{\"s\":\"\xff\"}", m2.get()));
+  EXPECT_FALSE(Parse("{\"r_s\":[\"a\",\"\xc3\"]}", m2.get()));
+  EXPECT_TRUE(Parse("{\"x\":\"\xff\",\"\xc3\":1,\"by\":\"\\u00ff\xff\"}", m2.get()));
+  EXPECT_EQ("\xc3\xbf\xff", m2->GetReflection()->GetString(*m2, by));
+}
+
+TEST(JsonParser, ParsesAddressBook) {
+  tutorial::AddressBook ab;
+  ASSERT_TRUE(Parse("{\"person\":[{\"name\":\"bin3\",\"id\":3,\"phone\":["
+                    "{\"number\":\"10000\",\"type\":\"WORK\"},{\"number\":\"10001\",\"type\":0}]},"
+                    "{\"name\":\"pb\"}]}", &ab));
+  ASSERT_EQ(2, ab.person_size());
+  EXPECT_EQ("bin3", ab.person(0).name());
+  EXPECT_EQ(3, ab.person(0).id());
+  ASSERT_EQ(2, ab.person(0).phone_size());
+  EXPECT_EQ(tutorial::Person::WORK, ab.person(0).phone(0).type());
+  EXPECT_EQ(tutorial::Person::MOBILE, ab.person(0).phone(1).type());
+  EXPECT_EQ("pb", ab.person(1).name());
+  EXPECT_FALSE(ab.person(1).has_id());
+}
+
+TEST(JsonParser, SkipsUnknownKeys) {
+  tutorial::Person person;
+  ASSERT_TRUE(Parse("{\"x\":{\"a\":[1,{\"b\":\"}]\\\"\"},null],\"c\":true},"
+                    "\"name\":\"n\",\"y\":[],\"z\":-1.5e3}", &person));
+  EXPECT_EQ("n", person.name());
+}
+
+TEST(JsonParser, AcceptsCamelCaseNames) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ASSERT_TRUE(Parse("{\"rI32\":[1,2],\"packedI32\":[3],\"r_s\":[\"a\"]}", m.get()));
+  EXPECT_EQ("r_i32: 1\nr_i32: 2\nr_s: \"a\"\npacked_i32: 3\n", m->DebugString());
+}
+
+TEST(JsonParser, DropsMismatchedValues) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ASSERT_TRUE(Parse("{\"i32\":\"1\",\"u32\":-1,\"i64\":1.5,\"b\":1,\"s\":2,\"d\":\"x\","
+                    "\"color\":\"PINK\",\"r_i32\":[1,\"2\",3000000000,4],\"inner\":5}", m.get()));
+  EXPECT_EQ("inner {\n}\nr_i32: 1\nr_i32: 4\n", m->DebugString());
+}
+
+TEST(JsonParser, AcceptsIntegralReals) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ASSERT_TRUE(Parse("{\"i32\":3.0,\"i64\":-2e3,\"u64\":18446744073709551615,\"d\":1,"
+                    "\"color\":2}", m.get()));
+  EXPECT_EQ("i32: 3\ni64: -2000\nu64: 18446744073709551615\nd: 1\ncolor: BLUE\n",
+            m->DebugString());
+}
+
+TEST(JsonParser, DecodesEscapes) {
+  tutorial::Person person;
+  ASSERT_TRUE(Parse("{\"name\":\"a\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\\u00e9\\ud83d\\ude00\"}",
+                    &person));
+  EXPECT_EQ("a\"\\/\b\f\n\r\tA\xc3\xa9\xf0\x9f\x98\x80", person.name());
+}
+
+TEST(JsonParser, DecodesLongStrings) {
+  // Runs longer than a vector block on both sides of the escapes
+  std::string name(100, 'n');
+  name += "\xe4\xb8\xad\"";
+  name += std::string(40, 'm');
+  name += "\\";
+  std::string json = "{\"unknown\":\"" + std::string(70, 'u') + "\\\"" + std::string(50, 'v') +
+      "\",\"name\":\"" + std::string(100, 'n') + "\xe4\xb8\xad\\\"" + std::string(40, 'm') +
+      "\\\\\",\"id\":1}";
+  tutorial::Person person;
+  ASSERT_TRUE(Parse(json, &person));
+  EXPECT_EQ(name, person.name());
+  EXPECT_EQ(1, person.id());
+}
+
+TEST(JsonParser, AcceptsCommentsAndWhitespace) {
+  tutorial::Person person;
+  ASSERT_TRUE(Parse(" /* c */ {\n\t\"name\" : \"n\" , // c\r\n \"id\" : 1 }\n", &person));
+  EXPECT_EQ("n", person.name());
+  EXPECT_EQ(1, person.id());
+}
+
+TEST(JsonParser, DoesNotReadPastLength) {
+  std::string json = "{\"name\":\"n\"}{\"id\":1}";
+  tutorial::Person person;
+  PlanCache plans;
+  JsonParser parser(&plans);
+  ASSERT_TRUE(parser.Parse(json.data(), 12, &person));
+  EXPECT_EQ("n", person.name());
+  EXPECT_FALSE(person.has_id());
+}
+
+TEST(JsonParser, RejectsMalformedInput) {
+  const char* inputs[] = {
+    "", "{", "{\"name\"}", "{\"name\":}", "{\"name\":\"n\",}", "{\"name\":\"n\"} x",
+    "{\"name\":\"\\x\"}", "{\"id\":01.}", "{\"id\":tru}", "{\"x\":[1,}", "{\"x\":{]",
+    "{\"name\":\"\\ud800\"}", "[", "{\"name\":\"\xc3\"}", "{\"email\":\"\xed\xa0\x80\"}",
+    "{\"name\":\"\\udc00\"}", "{\"name\":\"n\"} /*", "{\"name\":\"n\" /* }",
+  };
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+    tutorial::Person person;
+    person.set_name("old");
+    EXPECT_FALSE(Parse(inputs[i], &person)) << inputs[i];
+    EXPECT_FALSE(person.has_name()) << inputs[i];
+  }
+}
+
+// Skipped values are checked as strictly as the parsed ones
+const char* const kMalformedSkipped[] = {
+  "[}", "{\"x\": [1 2 3]}", "{\"x\": {]}", "{\"x\": {,,,}}", "{\"x\": {\"a\" \"b\" 1}}",
+  "{\"x\": [1,]}", "{\"x\": [,1]}", "{\"x\": {\"a\":1,}}", "{\"x\": {1:2}}", "{\"x\": 1 2}",
+  "{\"x\": \"\\q\"}", "{\"x\": \"\\udc00\"}", "{\"x\": \"\\ud800x\"}", "[1 /* 2]",
+};
+
+TEST(JsonParser, RejectsMalformedSkippedValues) {
+  for (size_t i = 0; i < sizeof(kMalformedSkipped) / sizeof(kMalformedSkipped[0]); ++i) {
+    tutorial::Person person;
+    EXPECT_FALSE(Parse(kMalformedSkipped[i], &person)) << kMalformedSkipped[i];
+  }
+  tutorial::Person person;
+  EXPECT_TRUE(Parse("{\"x\": {\"a\": [1, {}, [], \"\\u00e9\\ud83d\\ude00\"], \"b\": {\"c\": null}},"
+                    " \"id\": 2}", &person));
+  EXPECT_EQ(2, person.id());
+}
+
+TEST(JsonParser, ConvertsNonObjectToEmptyMessage) {
+  tutorial::Person person;
+  EXPECT_TRUE(Parse("[1,2]", &person));
+  EXPECT_EQ("", person.DebugString());
+}
+
+// ParseToWire must give the bytes of Parse followed by SerializeToString
+void ExpectWireMatches(const pb::Message& prototype, const std::string& json) {
+  std::unique_ptr<pb::Message> message(prototype.New());
+  bool parsed = Parse(json, message.get()) && message->IsInitialized();
+  PlanCache plans;
+  JsonParser parser(&plans);
+  std::string bytes = "x";
+  EXPECT_EQ(parsed, parser.ParseToWire(json.data(), json.size(), prototype.GetDescriptor(),
+                                       &bytes)) << json;
+  if (parsed) {
+    EXPECT_EQ("x" + message->SerializeAsString(), bytes) << json;
+  } else {
+    EXPECT_EQ("x", bytes);
+  }
+}
+
+TEST(JsonParser, ParsesToWireAllTypes) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  test::BuildTypes(m.get());
+  PlanCache plans;
+  ConvertOptions options;
+  for (int unset = 0; unset < 2; ++unset) {
+    options.convert_unset_fields = unset;
+    std::string json;
+    JsonWriter writer(&plans, options, &json);
+    writer.WriteMessage(*m);
+    ExpectWireMatches(*m, json);
+  }
+  tutorial::AddressBook ab;
+  ExpectWireMatches(ab, "{\"person\":[{\"name\":\"bin3\",\"id\":3,\"phone\":["
+                        "{\"number\":\"10000\",\"type\":\"WORK\"},{\"number\":\"1\"}]}]}");
+}
+
+TEST(JsonParser, ParsesToWireLikeReflection) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  // Repeated keys, values of the wrong type, escapes and non-object messages
+  ExpectWireMatches(*m, "{\"i32\":1,\"i32\":-2,\"inner\":{\"x\":1},\"inner\":{\"tag\":\"a\\n\"},"
+                        "\"r_i32\":[1],\"r_i32\":[2,-3],\"r_i32\":4,\"packed_i32\":[1,-1,\"2\"],"
+                        "\"s\":\"\\u00e9\\t\",\"r_s\":[\"\\\"\",\"b\",\"\\/\"],"
+                        "\"color\":\"BLUE\",\"color\":7,\"si32\":-5,\"u32\":-1,"
+                        "\"r_inner\":[1,{\"x\":2},{}],\"b\":\"true\",\"f\":0.1}");
+  ExpectWireMatches(*m, "{\"inner\":5}");
+  ExpectWireMatches(*m, "[1]");
+
+  // Embedded messages longer than one length byte
+  std::string long_tag(300, 'x');
+  ExpectWireMatches(*m, "{\"inner\":{\"tag\":\"" + long_tag + "\"},\"r_inner\":[{\"tag\":\"" +
+                        long_tag + long_tag + "\",\"x\":1},{\"tag\":\"\\\\" + long_tag + "\"}],"
+                        "\"packed_i32\":[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,"
+                        "27,28,29,30,31,32,33,34,35,36,37,38,39,40,-1,-2,-3,-4,-5,-6,-7,-8,-9]}");
+
+  // Fields without presence, and a oneof whose members replace each other
+  std::unique_ptr<pb::Message> event(test::NewEvent());
+  ExpectWireMatches(*event, "{\"id\":0,\"name\":\"\",\"level\":\"HIGH\",\"score\":-0.0,"
+                            "\"codes\":[-1,0,1],\"child\":{\"id\":1},\"text\":\"t\"}");
+  ExpectWireMatches(*event, "{\"child\":{\"id\":1},\"text\":\"t\",\"child\":{\"score\":2}}");
+  ExpectWireMatches(*event, "{\"child\":{\"id\":1},\"level\":0,\"child\":{\"score\":2}}");
+  ExpectWireMatches(*event, "{\"text\":\"\",\"level\":\"LOW\"}");
+}
+
+TEST(JsonParser, ParseToWireRejects) {
+  tutorial::AddressBook ab;
+  // Malformed input, and a person without the required id
+  ExpectWireMatches(ab, "{\"person\":[{\"name\":\"x\",\"id\":1}");
+  ExpectWireMatches(ab, "{\"person\":[{\"name\":\"x\"}]}");
+  ExpectWireMatches(ab, "{\"person\":[{\"name\":\"\xff\",\"id\":1}]}");
+  // Only the values of string fields have to be UTF-8
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ExpectWireMatches(*m, "{\"s\":\"\xff\"}");
+  ExpectWireMatches(*m, "{\"by\":\"\xff\xc3(\",\"x\":\"\xff\"}");
+  for (size_t i = 0; i < sizeof(kMalformedSkipped) / sizeof(kMalformedSkipped[0]); ++i) {
+    ExpectWireMatches(ab, kMalformedSkipped[i]);
+  }
+}
+
+}  // namespace pjconv
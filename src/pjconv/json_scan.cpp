@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-15
+ */
+
+
+#include <cstring>
+
+#include "pjconv/json_scan.h"
+#include "pjconv/simd.h"
+
+namespace pjconv {
+
+namespace {
+
+#ifdef PJCONV_HAVE_X86_SIMD
+
+// UTF-8 validation after Keiser and Lemire, "Validating UTF-8 in less than
+// one instruction per byte". Three table lookups on the nibbles of each
+// byte and the byte before it flag every error that two bytes can show;
+// the continuations that a three or four byte sequence still needs are
+// checked against the bytes two and three back.
+const unsigned char kTooShort = 1 << 0;
+const unsigned char kTooLong = 1 << 1;
+const unsigned char kOverlong3 = 1 << 2;
+const unsigned char kTooLarge = 1 << 3;
+const unsigned char kSurrogate = 1 << 4;
+const unsigned char kOverlong2 = 1 << 5;
+const unsigned char kTooLarge1000 = 1 << 6;
+const unsigned char kOverlong4 = 1 << 6;
+const unsigned char kTwoConts = 1 << 7;
+const unsigned char kCarry = kTooShort | kTooLong | kTwoConts;
+
+// Indexed by the high nibble of the previous byte
+const unsigned char kByte1High[16] = {
+  kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+  kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+  kTooShort | kOverlong2,
+  kTooShort,
+  kTooShort | kOverlong3 | kSurrogate,
+  kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+// Indexed by the low nibble of the previous byte
+const unsigned char kByte1Low[16] = {
+  kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+  kCarry | kOverlong2,
+  kCarry,
+  kCarry,
+  kCarry | kTooLarge,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+  kCarry | kTooLarge | kTooLarge1000,
+  kCarry | kTooLarge | kTooLarge1000,
+};
+
+// Indexed by the high nibble of the current byte
+const unsigned char kByte2High[16] = {
+  kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+  kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+  kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+  kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+  kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+  kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+// A block ending with these bytes needs more continuations than it has
+const unsigned char kIncomplete[32] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+__attribute__((target("ssse3")))
+bool Utf8Ssse3(const char* data, size_t size) {
+  const __m128i byte_1_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte1High));
+  const __m128i byte_1_low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte1Low));
+  const __m128i byte_2_high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte2High));
+  const __m128i incomplete = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kIncomplete + 16));
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  __m128i prev = _mm_setzero_si128();
+  __m128i prev_incomplete = _mm_setzero_si128();
+  __m128i error = _mm_setzero_si128();
+  for (size_t i = 0; i < size; i += 16) {
+    __m128i input;
+    if (i + 16 <= size) {
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    } else {
+      // Pad the last block with ASCII
+      char tail[16] = {0};
+      memcpy(tail, data + i, size - i);
+      input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+    }
+    if (_mm_movemask_epi8(input) == 0) {
+      // All ASCII: only a sequence left open by the block before can fail
+      error = _mm_or_si128(error, prev_incomplete);
+    } else {
+      __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+      __m128i special = _mm_and_si128(
+          _mm_and_si128(
+              _mm_shuffle_epi8(byte_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+              _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+          _mm_shuffle_epi8(byte_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+      __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+      __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+      __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80)),
+                                    _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80)));
+      __m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80)));
+      error = _mm_or_si128(error, _mm_xor_si128(must23_80, special));
+      prev_incomplete = _mm_subs_epu8(input, incomplete);
+    }
+    prev = input;
+  }
+  error = _mm_or_si128(error, prev_incomplete);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xffff;
+}
+
+// _mm256_alignr_epi8 works within each 128-bit lane, so first line the
+// previous block's high lane up below the current block's low lane
+#define PJCONV_PREV256(input, prev, n) \
+  _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+__attribute__((target("avx2")))
+bool Utf8Avx2(const char* data, size_t size) {
+  const __m256i byte_1_high = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte1High)));
+  const __m256i byte_1_low = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte1Low)));
+  const __m256i byte_2_high = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(kByte2High)));
+  const __m256i incomplete = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kIncomplete));
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  __m256i prev = _mm256_setzero_si256();
+  __m256i prev_incomplete = _mm256_setzero_si256();
+  __m256i error = _mm256_setzero_si256();
+  for (size_t i = 0; i < size; i += 32) {
+    __m256i input;
+    if (i + 32 <= size) {
+      input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    } else {
+      char tail[32] = {0};
+      memcpy(tail, data + i, size - i);
+      input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+    }
+    if (_mm256_movemask_epi8(input) == 0) {
+      error = _mm256_or_si256(error, prev_incomplete);
+    } else {
+      __m256i prev1 = PJCONV_PREV256(input, prev, 1);
+      __m256i special = _mm256_and_si256(
+          _mm256_and_si256(
+              _mm256_shuffle_epi8(byte_1_high,
+                                  _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+              _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+          _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+      __m256i prev2 = PJCONV_PREV256(input, prev, 2);
+      __m256i prev3 = PJCONV_PREV256(input, prev, 3);
+      __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xe0 - 0x80)),
+                                       _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xf0 - 0x80)));
+      __m256i must23_80 = _mm256_and_si256(must23, _mm256_set1_epi8(static_cast<char>(0x80)));
+      error = _mm256_or_si256(error, _mm256_xor_si256(must23_80, special));
+      prev_incomplete = _mm256_subs_epu8(input, incomplete);
+    }
+    prev = input;
+  }
+  error = _mm256_or_si256(error, prev_incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+#undef PJCONV_PREV256
+
+#endif  // PJCONV_HAVE_X86_SIMD
+
+FindQuoteFunc ChooseFindQuote() {
+  FindQuoteFunc func = FindQuoteOrBackslashAvx2();
+  if (!func) func = FindQuoteOrBackslashSse2();
+  return func ? func : FindQuoteOrBackslashScalar;
+}
+
+ValidateUtf8Func ChooseValidateUtf8() {
+  ValidateUtf8Func func = ValidateUtf8Avx2();
+  if (!func) func = ValidateUtf8Ssse3();
+  return func ? func : ValidateUtf8Scalar;
+}
+
+}  // namespace
+
+size_t FindQuoteOrBackslash(const char* data, size_t size) {
+  // Short runs are not worth a call through a pointer
+  if (size < 16) return FindStringByteScalar<false>(data, size);
+  static const FindQuoteFunc find = ChooseFindQuote();
+  return find(data, size);
+}
+
+bool ValidateUtf8(const char* data, size_t size) {
+  static const ValidateUtf8Func validate = ChooseValidateUtf8();
+  return validate(data, size);
+}
+
+size_t FindQuoteOrBackslashScalar(const char* data, size_t size) {
+  return FindStringByteScalar<false>(data, size);
+}
+
+FindQuoteFunc FindQuoteOrBackslashSse2() {
+  return FindStringByteSse2(false);
+}
+
+FindQuoteFunc FindQuoteOrBackslashAvx2() {
+  return FindStringByteAvx2(false);
+}
+
+bool ValidateUtf8Scalar(const char* data, size_t size) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+  while (p != end) {
+    unsigned char c = *p++;
+    if (c < 0x80) continue;
+    int more;
+    // The range of the second byte depends on the first
+    unsigned char low = 0x80;
+    unsigned char high = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+      more = 1;
+    } else if (c >= 0xe0 && c <= 0xef) {
+      more = 2;
+      if (c == 0xe0) low = 0xa0;
+      if (c == 0xed) high = 0x9f;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+      more = 3;
+      if (c == 0xf0) low = 0x90;
+      if (c == 0xf4) high = 0x8f;
+    } else {
+      return false;
+    }
+    if (end - p < more || *p < low || *p > high) return false;
+    for (++p; --more > 0; ++p) {
+      if (*p < 0x80 || *p > 0xbf) return false;
+    }
+  }
+  return true;
+}
+
+ValidateUtf8Func ValidateUtf8Ssse3() {
+#ifdef PJCONV_HAVE_X86_SIMD
+  if (CpuHasSsse3()) return Utf8Ssse3;
+#endif
+  return NULL;
+}
+
+ValidateUtf8Func ValidateUtf8Avx2() {
+#ifdef PJCONV_HAVE_X86_SIMD
+  if (CpuHasAvx2()) return Utf8Avx2;
+#endif
+  return NULL;
+}
+
+}  // namespace pjconv
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-15
+ */
+
+
+#ifndef PJCONV_JSON_SCAN_H_
+#define PJCONV_JSON_SCAN_H_
+
+#include <cstddef>
+
+namespace pjconv {
+
+/**
+ * Bulk scans of JSON input, vectorized with AVX2 or SSE where the CPU the
+ * process runs on has them and done a byte at a time elsewhere.
+ */
+
+/**
+ * Find the end of a run of plain string bytes: the first quote or backslash
+ *
+ * @return the offset of the byte, or size if there is none
+ */
+size_t FindQuoteOrBackslash(const char* data, size_t size);
+
+/**
+ * @return whether the bytes are well-formed UTF-8: no stray continuation
+ * bytes, truncated or overlong sequences, surrogates or code points above
+ * U+10FFFF
+ */
+bool ValidateUtf8(const char* data, size_t size);
+
+/**
+ * The implementations the scans choose from, for tests. The SIMD ones are
+ * NULL when they are not compiled in or the CPU lacks them.
+ */
+typedef size_t (*FindQuoteFunc)(const char* data, size_t size);
+typedef bool (*ValidateUtf8Func)(const char* data, size_t size);
+size_t FindQuoteOrBackslashScalar(const char* data, size_t size);
+FindQuoteFunc FindQuoteOrBackslashSse2();
+FindQuoteFunc FindQuoteOrBackslashAvx2();
+bool ValidateUtf8Scalar(const char* data, size_t size);
+ValidateUtf8Func ValidateUtf8Ssse3();
+ValidateUtf8Func ValidateUtf8Avx2();
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_SCAN_H_
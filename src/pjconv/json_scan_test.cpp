@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-15
+ */
+
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/json_scan.h"
+
+namespace pjconv {
+
+namespace {
+
+std::vector<ValidateUtf8Func> Validators() {
+  std::vector<ValidateUtf8Func> funcs;
+  funcs.push_back(ValidateUtf8Scalar);
+  funcs.push_back(ValidateUtf8);
+  if (ValidateUtf8Ssse3()) funcs.push_back(ValidateUtf8Ssse3());
+  if (ValidateUtf8Avx2()) funcs.push_back(ValidateUtf8Avx2());
+  return funcs;
+}
+
+// Check a sequence alone and at every offset of a longer ASCII text, so it
+// lands on every position of a block and straddles block boundaries
+void ExpectUtf8(bool valid, const std::string& sequence) {
+  std::vector<ValidateUtf8Func> funcs = Validators();
+  for (size_t f = 0; f < funcs.size(); ++f) {
+    for (size_t offset = 0; offset <= 70; ++offset) {
+      std::string text = std::string(offset, 'a') + sequence + std::string(offset % 7, 'b');
+      ASSERT_EQ(valid, funcs[f](text.data(), text.size()))
+          << "func " << f << " offset " << offset << " sequence " << ::testing::PrintToString(sequence);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(FindQuoteOrBackslash, FindsTheFirstAtEveryOffset) {
+  std::vector<FindQuoteFunc> funcs;
+  funcs.push_back(FindQuoteOrBackslashScalar);
+  funcs.push_back(FindQuoteOrBackslash);
+  if (FindQuoteOrBackslashSse2()) funcs.push_back(FindQuoteOrBackslashSse2());
+  if (FindQuoteOrBackslashAvx2()) funcs.push_back(FindQuoteOrBackslashAvx2());
+  for (size_t size = 0; size <= 80; ++size) {
+    // Control bytes and non-ASCII do not end a run
+    std::string text(size, '\n');
+    for (size_t i = 0; i < size; i += 3) {
+      text[i] = '\xe9';
+    }
+    for (size_t f = 0; f < funcs.size(); ++f) {
+      ASSERT_EQ(size, funcs[f](text.data(), size));
+    }
+    for (size_t pos = 0; pos < size; ++pos) {
+      for (int quote = 0; quote < 2; ++quote) {
+        std::string hit = text;
+        hit[pos] = quote ? '"' : '\\';
+        hit[size - 1] = hit[size - 1] == '\n' ? '"' : hit[size - 1];
+        for (size_t f = 0; f < funcs.size(); ++f) {
+          ASSERT_EQ(pos, funcs[f](hit.data(), size)) << "func " << f << " size " << size;
+        }
+      }
+    }
+  }
+}
+
+TEST(ValidateUtf8, AcceptsWellFormedSequences) {
+  ExpectUtf8(true, "");
+  ExpectUtf8(true, "plain ascii \x7f");
+  ExpectUtf8(true, "\xc2\x80");
+  ExpectUtf8(true, "\xdf\xbf");
+  ExpectUtf8(true, "\xe0\xa0\x80");
+  ExpectUtf8(true, "\xed\x9f\xbf");
+  ExpectUtf8(true, "\xee\x80\x80");
+  ExpectUtf8(true, "\xef\xbf\xbf");
+  ExpectUtf8(true, "\xf0\x90\x80\x80");
+  ExpectUtf8(true, "\xf4\x8f\xbf\xbf");
+  ExpectUtf8(true, "caf\xc3\xa9 \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80");
+}
+
+TEST(ValidateUtf8, RejectsMalformedSequences) {
+  ExpectUtf8(false, "\x80");
+  ExpectUtf8(false, "\xbf");
+  ExpectUtf8(false, "\xc0\x80");
+  ExpectUtf8(false, "\xc1\xbf");
+  ExpectUtf8(false, "\xc2");
+  ExpectUtf8(false, "\xc2\x41");
+  ExpectUtf8(false, "\xc2\x80\x80");
+  ExpectUtf8(false, "\xe0\x80\x80");
+  ExpectUtf8(false, "\xe0\x9f\xbf");
+  ExpectUtf8(false, "\xed\xa0\x80");
+  ExpectUtf8(false, "\xed\xbf\xbf");
+  ExpectUtf8(false, "\xe1\x80");
+  ExpectUtf8(false, "\xe1\x80\x41");
+  ExpectUtf8(false, "\xf0\x80\x80\x80");
+  ExpectUtf8(false, "\xf0\x8f\xbf\xbf");
+  ExpectUtf8(false, "\xf4\x90\x80\x80");
+  ExpectUtf8(false, "\xf5\x80\x80\x80");
+  ExpectUtf8(false, "\xf0\x90\x80");
+  ExpectUtf8(false, "\xff");
+  ExpectUtf8(false, "\xfe");
+}
+
+TEST(ValidateUtf8, AgreesWithScalarOnRandomBytes) {
+  std::vector<ValidateUtf8Func> funcs = Validators();
+  // Mostly valid text with a few random bytes dropped in
+  const char* pieces[] = { "a", "\xc3\xa9", "\xe4\xb8\xad", "\xf0\x9f\x98\x80", " " };
+  srand(3);
+  int invalid = 0;
+  for (int round = 0; round < 2000; ++round) {
+    std::string text;
+    int count = rand() % 40;
+    for (int i = 0; i < count; ++i) {
+      text += pieces[rand() % 5];
+    }
+    for (int i = rand() % 3; i > 0 && !text.empty(); --i) {
+      text[rand() % text.size()] = static_cast<char>(rand() % 256);
+    }
+    bool expected = ValidateUtf8Scalar(text.data(), text.size());
+    if (!expected) ++invalid;
+    for (size_t f = 0; f < funcs.size(); ++f) {
+      ASSERT_EQ(expected, funcs[f](text.data(), text.size()))
+          << "func " << f << " text " << ::testing::PrintToString(text);
+    }
+  }
+  EXPECT_GT(invalid, 100);
+}
+
+}  // namespace pjconv
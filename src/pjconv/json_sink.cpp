@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-29
+ */
+
+
+#include <cstring>
+
+#include "pjconv/json_sink.h"
+
+namespace pjconv {
+
+ZeroCopyStreamSink::ZeroCopyStreamSink(google::protobuf::io::ZeroCopyOutputStream* output)
+    : output_(output), buffer_(NULL), available_(0) {
+}
+
+ZeroCopyStreamSink::~ZeroCopyStreamSink() {
+  if (available_ > 0) output_->BackUp(available_);
+}
+
+bool ZeroCopyStreamSink::Append(const char* data, size_t size) {
+  while (size > 0) {
+    if (available_ == 0) {
+      void* buffer;
+      if (!output_->Next(&buffer, &available_)) {
+        available_ = 0;
+        return false;
+      }
+      buffer_ = static_cast<char*>(buffer);
+      continue;
+    }
+    size_t n = size < static_cast<size_t>(available_) ? size : available_;
+    memcpy(buffer_, data, n);
+    buffer_ += n;
+    available_ -= static_cast<int>(n);
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+}  // namespace pjconv
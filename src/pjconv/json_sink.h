@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-29
+ */
+
+
+#ifndef PJCONV_JSON_SINK_H_
+#define PJCONV_JSON_SINK_H_
+
+#include <cstddef>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace pjconv {
+
+/**
+ * Receives JSON text in chunks as it is written
+ */
+class JsonSink {
+ public:
+  virtual ~JsonSink() {
+  }
+
+  /**
+   * Take the next chunk of text, which is only valid during the call
+   *
+   * @return false to stop writing, such as when the destination failed
+   */
+  virtual bool Append(const char* data, size_t size) = 0;
+};
+
+/**
+ * Copies JSON text into the buffers of a ZeroCopyOutputStream. The unused
+ * end of the last buffer is given back to the stream on destruction.
+ */
+class ZeroCopyStreamSink : public JsonSink {
+ public:
+  explicit ZeroCopyStreamSink(google::protobuf::io::ZeroCopyOutputStream* output);
+  virtual ~ZeroCopyStreamSink();
+
+  virtual bool Append(const char* data, size_t size);
+
+ private:
+  ZeroCopyStreamSink(const ZeroCopyStreamSink&);
+  void operator=(const ZeroCopyStreamSink&);
+
+  google::protobuf::io::ZeroCopyOutputStream* output_;
+  char* buffer_;
+  int available_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_SINK_H_
@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-20
+ */
+
+#include <cmath>
+#include <google/protobuf/descriptor.h>
+#include <json/json.h>
+
+#include "pjconv/json_writer.h"
+#include "pjconv/json_escape.h"
+#include "pjconv/number_format.h"
+#include "pjconv/stats_scope.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+// The sink gets the text in chunks of about this size
+const size_t kFlushSize = 16 << 10;
+
+// The length of a string once quoted and escaped as WriteString does
+size_t StringSize(const std::string& value) {
+  size_t size = value.size() + 2;
+  const char* p = value.data();
+  const char* end = p + value.size();
+  for (;;) {
+    p += FindEscape(p, end - p);
+    if (p == end) break;
+    switch (*p++) {
+      case '"': case '\\': case '\b': case '\f': case '\n': case '\r': case '\t':
+        size += 1;
+        break;
+      default:
+        // \u00XX
+        size += 5;
+        break;
+    }
+  }
+  return size;
+}
+
+size_t EnumSize(const FieldPlan& field, const pb::EnumValueDescriptor* value) {
+  size_t index = value->index();
+  if (index < field.enums->quoted_names.size() && value->type()->value(index) == value) {
+    return field.enums->quoted_names[index].size();
+  }
+  return StringSize(value->name());
+}
+
+size_t DoubleSize(double value) {
+  if (!std::isfinite(value)) return Json::valueToString(value).size();
+  char buf[kMaxNumberSize];
+  return FormatDouble(value, buf) - buf;
+}
+
+size_t FloatSize(float value) {
+  if (!std::isfinite(value)) return Json::valueToString(value).size();
+  char buf[kMaxNumberSize];
+  return FormatFloat(value, buf) - buf;
+}
+
+size_t UInt64Size(pb::uint64 value) {
+  size_t size = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++size;
+  }
+  return size;
+}
+
+size_t Int64Size(pb::int64 value) {
+  // Negated in unsigned arithmetic, so the smallest int64 does not overflow
+  if (value < 0) return 1 + UInt64Size(0 - static_cast<pb::uint64>(value));
+  return UInt64Size(value);
+}
+
+// The chunk buffer of the last writer on this thread, kept for its capacity
+std::string& SpareBuffer() {
+  static thread_local std::string buffer;
+  return buffer;
+}
+
+}  // namespace
+
+void GeneratedJsonContext::CountFields(size_t fields) {
+  StatsScope::CountFields(fields);
+}
+
+void AppendJsonString(const char* data, size_t size, std::string* output) {
+  output->push_back('"');
+  const char* p = data;
+  const char* end = p + size;
+  for (;;) {
+    // Copy the run up to the next byte to escape in one go
+    size_t run = FindEscape(p, end - p);
+    output->append(p, run);
+    p += run;
+    if (p == end) break;
+    unsigned char c = static_cast<unsigned char>(*p++);
+    switch (c) {
+      case '"':  output->append("\\\"", 2); break;
+      case '\\': output->append("\\\\", 2); break;
+      case '\b': output->append("\\b", 2); break;
+      case '\f': output->append("\\f", 2); break;
+      case '\n': output->append("\\n", 2); break;
+      case '\r': output->append("\\r", 2); break;
+      case '\t': output->append("\\t", 2); break;
+      default: {
+        char buf[6] = {'\\', 'u', '0', '0', kHexDigits[c >> 4], kHexDigits[c & 0xf]};
+        output->append(buf, sizeof(buf));
+        break;
+      }
+    }
+  }
+  output->push_back('"');
+}
+
+void AppendJsonDouble(double value, std::string* output) {
+  if (!std::isfinite(value)) {
+    // Json::FastWriter's spellings of NaN and the infinities
+    output->append(Json::valueToString(value));
+    return;
+  }
+  char buf[kMaxNumberSize];
+  output->append(buf, FormatDouble(value, buf) - buf);
+}
+
+void AppendJsonFloat(float value, std::string* output) {
+  if (!std::isfinite(value)) {
+    output->append(Json::valueToString(value));
+    return;
+  }
+  // Shortest as a float, so 0.1f is written 0.1 rather than 0.10000000149011612
+  char buf[kMaxNumberSize];
+  output->append(buf, FormatFloat(value, buf) - buf);
+}
+
+void AppendJsonInt64(pb::int64 value, std::string* output) {
+  char buf[kMaxNumberSize];
+  output->append(buf, FormatInt64(value, buf) - buf);
+}
+
+void AppendJsonUInt64(pb::uint64 value, std::string* output) {
+  char buf[kMaxNumberSize];
+  output->append(buf, FormatUInt64(value, buf) - buf);
+}
+
+void AppendJsonUnknownEnum(const std::string& type_name, int number, std::string* output) {
+  char buf[kMaxNumberSize];
+  std::string name = "UNKNOWN_ENUM_VALUE_" + type_name + "_";
+  name.append(buf, FormatInt64(number, buf) - buf);
+  AppendJsonString(name.data(), name.size(), output);
+}
+
+void AppendJsonEnum(const EnumTable& enums, const pb::EnumValueDescriptor* value,
+                    std::string* output) {
+  size_t index = value->index();
+  if (index < enums.quoted_names.size() && value->type()->value(index) == value) {
+    output->append(enums.quoted_names[index]);
+  } else {
+    // An unknown value of an open enum is not part of the descriptor
+    AppendJsonString(value->name().data(), value->name().size(), output);
+  }
+}
+
+JsonWriter::JsonWriter(PlanCache* plans, const ConvertOptions& options, std::string* output)
+    : plans_(plans), options_(options), output_(output), sink_(NULL), flushed_(0),
+      failed_(false) {
+}
+
+JsonWriter::JsonWriter(PlanCache* plans, const ConvertOptions& options, JsonSink* sink)
+    : plans_(plans), options_(options), output_(&buffer_), sink_(sink), flushed_(0),
+      failed_(false) {
+  // Swapped rather than shared, so a sink that writes JSON itself is safe
+  buffer_.swap(SpareBuffer());
+  buffer_.clear();
+}
+
+JsonWriter::~JsonWriter() {
+  if (sink_) SpareBuffer().swap(buffer_);
+}
+
+bool JsonWriter::WriteMessage(const pb::Message& message) {
+  const MessagePlan* plan = plans_->Get(message.GetDescriptor(), options_.projection);
+  if (!plan) return false;
+  WriteMessage(*plan, message);
+  return Flush();
+}
+
+bool JsonWriter::Flush() {
+  if (sink_ && !failed_ && !buffer_.empty()) {
+    failed_ = !sink_->Append(buffer_.data(), buffer_.size());
+    StatsScope::CountBytesOut(buffer_.size());
+    flushed_ += buffer_.size();
+  }
+  buffer_.clear();
+  return !failed_;
+}
+
+/**
+ * Lets generated writers hand the messages they cannot write back
+ */
+class JsonWriter::Generated : public GeneratedJsonContext {
+ public:
+  Generated(JsonWriter* writer, ProfileTrace* trace)
+      : GeneratedJsonContext(writer->output_, writer->options_.convert_unset_fields,
+                             writer->sink_ ? kFlushSize : static_cast<size_t>(-1), trace != NULL),
+        writer_(writer), trace_(trace) {
+  }
+
+  virtual void WriteNested(const pb::Message& message) {
+    writer_->WriteMessage(*writer_->plans_->Get(message.GetDescriptor()), message);
+  }
+
+  virtual void Enter(const std::string& name) {
+    trace_->Enter(name, writer_->written());
+  }
+
+  virtual void Leave() {
+    trace_->Leave(writer_->written());
+  }
+
+ protected:
+  virtual void Flush() {
+    writer_->Flush();
+  }
+
+ private:
+  JsonWriter* writer_;
+  ProfileTrace* trace_;
+};
+
+void JsonWriter::WriteMessage(const MessagePlan& plan, const pb::Message& message) {
+  const pb::Reflection* ref = message.GetReflection();
+  ProfileTrace* trace = ProfileTrace::Current();
+  // Dynamic messages of the type have their own reflection. Generated
+  // writers open the frames of their messages themselves, nested ones too
+  if (plan.generated && ref == plan.generated_reflection) {
+    Generated context(this, trace);
+    plan.generated(message, &context);
+    return;
+  }
+  if (trace) trace->Enter(plan.descriptor->full_name(), written());
+  bool empty = true;
+  size_t fields = 0;
+  if (!options_.convert_unset_fields && PresentFields::Worthwhile(plan)) {
+    PresentFields present(plan, message);
+    for (; fields < present.size(); ++fields) {
+      if (!WriteMember(present[fields], message, ref, trace, &empty)) return;
+    }
+  } else {
+    for (size_t i = 0; i < plan.fields.size(); ++i) {
+      const FieldPlan& field = plan.fields[i];
+      if (field.repeated) {
+        if (ref->FieldSize(message, field.field) == 0) continue;
+      } else if (!options_.convert_unset_fields && !ref->HasField(message, field.field)) {
+        continue;
+      }
+      ++fields;
+      if (!WriteMember(field, message, ref, trace, &empty)) return;
+    }
+  }
+  StatsScope::CountFields(fields);
+  if (empty) {
+    // A Json::Value that never got a member stays null
+    output_->append("null", 4);
+  } else {
+    output_->push_back('}');
+  }
+  if (trace) trace->Leave(written());
+}
+
+bool JsonWriter::WriteMember(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref,
+    ProfileTrace* trace,
+    bool* empty) {
+  if (trace) trace->Enter(field.field->name(), written());
+  // The brace waits for the first member, so nothing written is ever taken
+  // back and the text can go to the sink at any field
+  output_->push_back(*empty ? '{' : ',');
+  *empty = false;
+  output_->append(field.key);
+  if (field.repeated) {
+    WriteRepeatedField(field, message, ref);
+  } else {
+    WriteSingleField(field, message, ref);
+  }
+  if (trace) trace->Leave(written());
+  return !sink_ || buffer_.size() < kFlushSize || Flush();
+}
+
+void JsonWriter::WriteSingleField(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref) {
+  switch (field.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+      WriteInt64(ref->GetInt32(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      WriteInt64(ref->GetInt64(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+      WriteUInt64(ref->GetUInt32(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      WriteUInt64(ref->GetUInt64(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      WriteDouble(ref->GetDouble(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      WriteFloat(ref->GetFloat(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      WriteBool(ref->GetBool(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      WriteEnum(field, ref->GetEnum(message, field.field));
+      break;
+    case pb::FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      WriteString(ref->GetStringReference(message, field.field, &scratch));
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      WriteMessage(*field.message, ref->GetMessage(message, field.field));
+      break;
+  }
+}
+
+void JsonWriter::WriteRepeatedField(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref) {
+  int n = ref->FieldSize(message, field.field);
+  output_->push_back('[');
+  for (int i = 0; i < n; ++i) {
+    if (i > 0) output_->push_back(',');
+    switch (field.cpp_type) {
+      case pb::FieldDescriptor::CPPTYPE_INT32:
+        WriteInt64(ref->GetRepeatedInt32(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_INT64:
+        WriteInt64(ref->GetRepeatedInt64(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_UINT32:
+        WriteUInt64(ref->GetRepeatedUInt32(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_UINT64:
+        WriteUInt64(ref->GetRepeatedUInt64(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+        WriteDouble(ref->GetRepeatedDouble(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_FLOAT:
+        WriteFloat(ref->GetRepeatedFloat(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_BOOL:
+        WriteBool(ref->GetRepeatedBool(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_ENUM:
+        WriteEnum(field, ref->GetRepeatedEnum(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        WriteString(ref->GetRepeatedStringReference(message, field.field, i, &scratch));
+        break;
+      }
+      case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+        WriteMessage(*field.message, ref->GetRepeatedMessage(message, field.field, i));
+        break;
+    }
+  }
+  output_->push_back(']');
+}
+
+void JsonWriter::WriteEnum(const FieldPlan& field, const pb::EnumValueDescriptor* value) {
+  AppendJsonEnum(*field.enums, value, output_);
+}
+
+void JsonWriter::WriteString(const std::string& value) {
+  AppendJsonString(value.data(), value.size(), output_);
+}
+
+void JsonWriter::WriteDouble(double value) {
+  AppendJsonDouble(value, output_);
+}
+
+void JsonWriter::WriteFloat(float value) {
+  AppendJsonFloat(value, output_);
+}
+
+void JsonWriter::WriteBool(bool value) {
+  AppendJsonBool(value, output_);
+}
+
+void JsonWriter::WriteInt64(pb::int64 value) {
+  AppendJsonInt64(value, output_);
+}
+
+void JsonWriter::WriteUInt64(pb::uint64 value) {
+  AppendJsonUInt64(value, output_);
+}
+
+JsonSizer::JsonSizer(PlanCache* plans, const ConvertOptions& options)
+    : plans_(plans), options_(options) {
+}
+
+size_t JsonSizer::MessageSize(const pb::Message& message) const {
+  const MessagePlan* plan = plans_->Get(message.GetDescriptor(), options_.projection);
+  return plan ? MessageSize(*plan, message) : 0;
+}
+
+// Mirrors JsonWriter::WriteMessage; the two must change together
+size_t JsonSizer::MessageSize(const MessagePlan& plan, const pb::Message& message) const {
+  const pb::Reflection* ref = message.GetReflection();
+  size_t size = 0;
+  if (!options_.convert_unset_fields && PresentFields::Worthwhile(plan)) {
+    PresentFields present(plan, message);
+    for (size_t i = 0; i < present.size(); ++i) {
+      size += MemberSize(present[i], message, ref);
+    }
+  } else {
+    for (size_t i = 0; i < plan.fields.size(); ++i) {
+      const FieldPlan& field = plan.fields[i];
+      if (field.repeated) {
+        if (ref->FieldSize(message, field.field) == 0) continue;
+      } else if (!options_.convert_unset_fields && !ref->HasField(message, field.field)) {
+        continue;
+      }
+      size += MemberSize(field, message, ref);
+    }
+  }
+  // "null", or the closing brace
+  return size == 0 ? 4 : size + 1;
+}
+
+size_t JsonSizer::MemberSize(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref) const {
+  // The brace or the comma before the member
+  size_t size = 1 + field.key.size();
+  if (field.repeated) {
+    return size + RepeatedFieldSize(field, message, ref);
+  }
+  return size + SingleFieldSize(field, message, ref);
+}
+
+size_t JsonSizer::SingleFieldSize(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref) const {
+  switch (field.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+      return Int64Size(ref->GetInt32(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      return Int64Size(ref->GetInt64(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+      return UInt64Size(ref->GetUInt32(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      return UInt64Size(ref->GetUInt64(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      return DoubleSize(ref->GetDouble(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      return FloatSize(ref->GetFloat(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      return ref->GetBool(message, field.field) ? 4 : 5;
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      return EnumSize(field, ref->GetEnum(message, field.field));
+    case pb::FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      return StringSize(ref->GetStringReference(message, field.field, &scratch));
+    }
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      return MessageSize(*field.message, ref->GetMessage(message, field.field));
+  }
+  return 0;
+}
+
+size_t JsonSizer::RepeatedFieldSize(
+    const FieldPlan& field,
+    const pb::Message& message,
+    const pb::Reflection* ref) const {
+  int n = ref->FieldSize(message, field.field);
+  // The brackets and the commas between the elements
+  size_t size = 1 + n;
+  for (int i = 0; i < n; ++i) {
+    switch (field.cpp_type) {
+      case pb::FieldDescriptor::CPPTYPE_INT32:
+        size += Int64Size(ref->GetRepeatedInt32(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_INT64:
+        size += Int64Size(ref->GetRepeatedInt64(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_UINT32:
+        size += UInt64Size(ref->GetRepeatedUInt32(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_UINT64:
+        size += UInt64Size(ref->GetRepeatedUInt64(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+        size += DoubleSize(ref->GetRepeatedDouble(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_FLOAT:
+        size += FloatSize(ref->GetRepeatedFloat(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_BOOL:
+        size += ref->GetRepeatedBool(message, field.field, i) ? 4 : 5;
+        break;
+      case pb::FieldDescriptor::CPPTYPE_ENUM:
+        size += EnumSize(field, ref->GetRepeatedEnum(message, field.field, i));
+        break;
+      case pb::FieldDescriptor::CPPTYPE_STRING: {
+        std::string scratch;
+        size += StringSize(ref->GetRepeatedStringReference(message, field.field, i, &scratch));
+        break;
+      }
+      case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+        size += MessageSize(*field.message, ref->GetRepeatedMessage(message, field.field, i));
+        break;
+    }
+  }
+  return size;
+}
+
+}  // namespace pjconv
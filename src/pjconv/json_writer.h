@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-20
+ */
+
+#ifndef PJCONV_JSON_WRITER_H_
+#define PJCONV_JSON_WRITER_H_
+
+#include <string>
+#include <google/protobuf/message.h>
+
+#include "pjconv/generated.h"
+#include "pjconv/json_sink.h"
+#include "pjconv/options.h"
+#include "pjconv/plan.h"
+#include "pjconv/profile_trace.h"
+
+namespace pjconv {
+
+/**
+ * Append an enum value as its quoted name
+ *
+ * @param enums the values of the enum type
+ * @param value a value of the type, or the placeholder of an unknown one
+ */
+void AppendJsonEnum(const EnumTable& enums, const google::protobuf::EnumValueDescriptor* value,
+                    std::string* output);
+
+/**
+ * Writes a protobuf message as compact JSON text directly into a string or
+ * a sink, walking the message once without building an intermediate
+ * Json::Value.
+ *
+ * The output is byte-identical to Json::FastWriter applied to the
+ * Json::Value produced by PJConverter for the same message, so members are
+ * written in the key order of a Json::Value object (by field name). The
+ * one exception is floating point numbers, which are written with the
+ * fewest digits that read back to the same value instead of with 17.
+ */
+class JsonWriter {
+ public:
+  /**
+   * @param plans the cache of conversion plans
+   * @param options the options of the conversion
+   * @param output the string the JSON text is appended to
+   */
+  JsonWriter(PlanCache* plans, const ConvertOptions& options, std::string* output);
+
+  /**
+   * @param plans the cache of conversion plans
+   * @param options the options of the conversion
+   * @param sink the sink the JSON text is passed to in chunks
+   */
+  JsonWriter(PlanCache* plans, const ConvertOptions& options, JsonSink* sink);
+  ~JsonWriter();
+
+  /**
+   * Append a protobuf message as a JSON object
+   *
+   * @param message the input protobuf message
+   * @return false if the sink stopped the writing, or the projection of
+   *     the options is of another type
+   */
+  bool WriteMessage(const google::protobuf::Message& message);
+
+ private:
+  JsonWriter(const JsonWriter&);
+  void operator=(const JsonWriter&);
+
+  class Generated;
+
+  void WriteMessage(const MessagePlan& plan, const google::protobuf::Message& message);
+  bool Flush();
+
+  /** @return the bytes of text written so far */
+  size_t written() const {
+    return flushed_ + output_->size();
+  }
+
+  /** @return false if the sink stopped the writing */
+  bool WriteMember(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref,
+      ProfileTrace* trace,
+      bool* empty);
+
+  void WriteSingleField(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref);
+
+  void WriteRepeatedField(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref);
+
+  void WriteEnum(const FieldPlan& field, const google::protobuf::EnumValueDescriptor* value);
+  void WriteString(const std::string& value);
+  void WriteDouble(double value);
+  void WriteFloat(float value);
+  void WriteBool(bool value);
+  void WriteInt64(google::protobuf::int64 value);
+  void WriteUInt64(google::protobuf::uint64 value);
+
+  PlanCache* plans_;
+  const ConvertOptions& options_;
+  std::string* output_;
+  /** Where the text goes in chunks, or NULL when it stays in output_ */
+  JsonSink* sink_;
+  /** The text not yet passed to the sink; output_ points at it */
+  std::string buffer_;
+  /** The text passed to the sink so far */
+  size_t flushed_;
+  bool failed_;
+};
+
+/**
+ * Computes the exact length of the text JsonWriter writes for a message,
+ * walking the fields the same way but producing no bytes, so the output
+ * can be allocated once or checked against a limit beforehand.
+ */
+class JsonSizer {
+ public:
+  /**
+   * @param plans the cache of conversion plans
+   * @param options the options of the conversion
+   */
+  JsonSizer(PlanCache* plans, const ConvertOptions& options);
+
+  /**
+   * @param message the input protobuf message
+   * @return the number of bytes WriteMessage would append, or 0 if the
+   *     projection of the options is of another type
+   */
+  size_t MessageSize(const google::protobuf::Message& message) const;
+
+ private:
+  size_t MessageSize(const MessagePlan& plan, const google::protobuf::Message& message) const;
+
+  size_t MemberSize(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref) const;
+
+  size_t SingleFieldSize(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref) const;
+
+  size_t RepeatedFieldSize(
+      const FieldPlan& field,
+      const google::protobuf::Message& message,
+      const google::protobuf::Reflection* ref) const;
+
+  PlanCache* plans_;
+  const ConvertOptions& options_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_JSON_WRITER_H_
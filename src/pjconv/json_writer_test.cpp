@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-20
+ */
+
+#include <limits>
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "pjconv/json_writer.h"
+#include "pjconv/pjconv.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+// The Json::Value path followed by Json::FastWriter, which JsonWriter must reproduce
+std::string FastWrite(const pb::Message& message, bool convert_unset_fields) {
+  PJConverter conv;
+  Json::Value value;
+  conv.Convert(message, &value, convert_unset_fields);
+  Json::FastWriter writer;
+  return writer.write(value);
+}
+
+std::string DirectWrite(const pb::Message& message, bool convert_unset_fields) {
+  PlanCache plans;
+  std::string json;
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(message);
+  return json + "\n";
+}
+
+TEST(JsonWriter, MatchesFastWriterOnAddressBook) {
+  tutorial::AddressBook ab;
+  test::BuildAddressBook(&ab);
+  EXPECT_EQ(FastWrite(ab, true), DirectWrite(ab, true));
+  EXPECT_EQ(FastWrite(ab, false), DirectWrite(ab, false));
+}
+
+// FastWriter writes doubles with 17 digits, JsonWriter with the fewest that round-trip
+std::string ShortenDoubles(std::string json) {
+  const std::string kLong = "1.0000000000000001e+300";
+  size_t pos = json.find(kLong);
+  if (pos != std::string::npos) json.replace(pos, kLong.size(), "1e+300");
+  return json;
+}
+
+TEST(JsonWriter, MatchesFastWriterOnAllTypes) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  test::BuildTypes(m.get());
+  EXPECT_EQ(ShortenDoubles(FastWrite(*m, true)), DirectWrite(*m, true));
+  EXPECT_EQ(ShortenDoubles(FastWrite(*m, false)), DirectWrite(*m, false));
+}
+
+TEST(JsonWriter, WritesShortestFloatingPoint) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  const pb::Descriptor* desc = m->GetDescriptor();
+  const pb::Reflection* ref = m->GetReflection();
+  ref->AddDouble(m.get(), desc->FindFieldByName("r_d"), 0.1);
+  ref->AddDouble(m.get(), desc->FindFieldByName("r_d"), std::numeric_limits<double>::infinity());
+  ref->AddDouble(m.get(), desc->FindFieldByName("r_d"), std::numeric_limits<double>::quiet_NaN());
+  ref->AddFloat(m.get(), desc->FindFieldByName("r_f"), 0.1f);
+  ref->AddFloat(m.get(), desc->FindFieldByName("r_f"), -std::numeric_limits<float>::infinity());
+  EXPECT_EQ("{\"r_d\":[0.1,1e+9999,null],\"r_f\":[0.1,-1e+9999]}\n", DirectWrite(*m, false));
+}
+
+TEST(JsonWriter, EmptyMessageIsNull) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  EXPECT_EQ("null\n", DirectWrite(*m, false));
+  EXPECT_EQ(FastWrite(*m, true), DirectWrite(*m, true));
+}
+
+TEST(JsonWriter, EscapesStrings) {
+  tutorial::Person person;
+  person.set_name(std::string("a\"b\\c\n\x01", 7));
+  person.set_id(-1);
+  PlanCache plans;
+  std::string json;
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(person);
+  EXPECT_EQ("{\"id\":-1,\"name\":\"a\\\"b\\\\c\\n\\u0001\"}", json);
+}
+
+TEST(JsonWriter, EscapesLongStringsLikeFastWriter) {
+  // Long clean runs between escaped bytes take the vectorized path
+  std::string text;
+  for (int i = 0; i < 300; ++i) {
+    text += std::string(i % 70, 'a' + i % 26);
+    text += "\"\\\t\x02/"[i % 5];
+  }
+  tutorial::Person person;
+  person.set_name(text);
+  person.set_id(1);
+  PlanCache plans;
+  std::string json;
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(person);
+
+  Json::Value value;
+  value["id"] = 1;
+  value["name"] = text;
+  Json::FastWriter fast;
+  EXPECT_EQ(fast.write(value), json + "\n");
+}
+
+TEST(JsonWriter, AppendsToOutput) {
+  tutorial::Person person;
+  person.set_name("x");
+  PlanCache plans;
+  std::string json = "[";
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  JsonWriter writer(&plans, options, &json);
+  writer.WriteMessage(person);
+  EXPECT_EQ("[{\"name\":\"x\"}", json);
+}
+
+void ExpectSizeMatches(const pb::Message& message, bool convert_unset_fields) {
+  PlanCache plans;
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  std::string json;
+  JsonWriter(&plans, options, &json).WriteMessage(message);
+  EXPECT_EQ(json.size(), JsonSizer(&plans, options).MessageSize(message)) << json;
+}
+
+TEST(JsonSizer, MatchesWriter) {
+  tutorial::AddressBook ab;
+  test::BuildAddressBook(&ab);
+  ExpectSizeMatches(ab, true);
+  ExpectSizeMatches(ab, false);
+
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ExpectSizeMatches(*m, true);
+  ExpectSizeMatches(*m, false);
+  test::BuildTypes(m.get());
+  const pb::Descriptor* desc = m->GetDescriptor();
+  const pb::Reflection* ref = m->GetReflection();
+  ref->AddDouble(m.get(), desc->FindFieldByName("r_d"), std::numeric_limits<double>::quiet_NaN());
+  ref->AddFloat(m.get(), desc->FindFieldByName("r_f"), -std::numeric_limits<float>::infinity());
+  ref->AddInt64(m.get(), desc->FindFieldByName("r_i64"), std::numeric_limits<pb::int64>::min());
+  ref->AddUInt64(m.get(), desc->FindFieldByName("r_u64"), std::numeric_limits<pb::uint64>::max());
+  ExpectSizeMatches(*m, true);
+  ExpectSizeMatches(*m, false);
+
+  tutorial::Person person;
+  person.set_name(std::string("a\"b\\c\n\x01\x1f/\xc3\xa9", 10));
+  person.set_id(0);
+  ExpectSizeMatches(person, false);
+}
+
+// Collects the chunks; optionally writes a message of its own from inside
+class ChunkSink : public JsonSink {
+ public:
+  ChunkSink(size_t max_chunks, PlanCache* plans)
+      : chunks(0), max_chunks_(max_chunks), plans_(plans) {
+  }
+
+  virtual bool Append(const char* data, size_t size) {
+    text.append(data, size);
+    ++chunks;
+    if (plans_) {
+      tutorial::Person person;
+      person.set_id(chunks);
+      ConvertOptions options;
+      options.convert_unset_fields = false;
+      std::string nested;
+      JsonWriter writer(plans_, options, &nested);
+      writer.WriteMessage(person);
+      ChunkSink inner(2, NULL);
+      JsonWriter sink_writer(plans_, options, &inner);
+      EXPECT_TRUE(sink_writer.WriteMessage(person));
+      EXPECT_EQ(nested, inner.text);
+    }
+    return chunks < max_chunks_;
+  }
+
+  std::string text;
+  size_t chunks;
+
+ private:
+  size_t max_chunks_;
+  PlanCache* plans_;
+};
+
+TEST(JsonWriter, WritesToSinkInChunks) {
+  tutorial::AddressBook ab;
+  for (int i = 0; i < 2000; ++i) {
+    tutorial::Person* person = ab.add_person();
+    person->set_name("person");
+    person->set_id(i);
+    person->set_email("person@example.com");
+  }
+  PlanCache plans;
+  ConvertOptions options;
+  std::string expected;
+  JsonWriter(&plans, options, &expected).WriteMessage(ab);
+
+  // A sink that writes JSON itself must not disturb the outer writer
+  ChunkSink sink(1000, &plans);
+  EXPECT_TRUE(JsonWriter(&plans, options, &sink).WriteMessage(ab));
+  EXPECT_EQ(expected, sink.text);
+  EXPECT_GT(sink.chunks, 1u);
+
+  ChunkSink failing(1, NULL);
+  EXPECT_FALSE(JsonWriter(&plans, options, &failing).WriteMessage(ab));
+  EXPECT_EQ(1u, failing.chunks);
+  EXPECT_EQ(0u, expected.find(failing.text));
+
+  // An empty message is still null when nothing is buffered to take back
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  options.convert_unset_fields = false;
+  ChunkSink empty(1000, NULL);
+  EXPECT_TRUE(JsonWriter(&plans, options, &empty).WriteMessage(*m));
+  EXPECT_EQ("null", empty.text);
+}
+
+}  // namespace pjconv
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-09
+ */
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+
+#include "pjconv/message_generator.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+MessageGenerator::MessageGenerator(const GeneratorOptions& options)
+    : options_(options), state_(options.seed) {
+}
+
+void MessageGenerator::Fill(pb::Message* message) {
+  message->Clear();
+  FillMessage(message, 0);
+}
+
+bool MessageGenerator::WriteDelimited(
+    const pb::Message& prototype,
+    size_t count,
+    pb::io::ZeroCopyOutputStream* output) {
+  std::unique_ptr<pb::Message> message(prototype.New());
+  std::string bytes;
+  pb::io::CodedOutputStream coded(output);
+  for (size_t i = 0; i < count && !coded.HadError(); ++i) {
+    Fill(message.get());
+    // Required fields below the maximum depth may be unset
+    bytes.clear();
+    message->SerializePartialToString(&bytes);
+    coded.WriteVarint32(static_cast<pb::uint32>(bytes.size()));
+    coded.WriteString(bytes);
+  }
+  return !coded.HadError();
+}
+
+void MessageGenerator::FillMessage(pb::Message* message, int depth) {
+  const pb::Descriptor* desc = message->GetDescriptor();
+  // At most one field of a oneof is set
+  for (int i = 0; i < desc->oneof_decl_count(); ++i) {
+    const pb::OneofDescriptor* oneof = desc->oneof_decl(i);
+    if (!Chance(options_.field_density)) continue;
+    const pb::FieldDescriptor* field = oneof->field(Next() % oneof->field_count());
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE && depth >= options_.max_depth) {
+      continue;
+    }
+    SetValue(message, field, depth);
+  }
+  for (int i = 0; i < desc->field_count(); ++i) {
+    const pb::FieldDescriptor* field = desc->field(i);
+    if (field->containing_oneof()) continue;
+    if (field->cpp_type() == pb::FieldDescriptor::CPPTYPE_MESSAGE && depth >= options_.max_depth) {
+      continue;
+    }
+    if (field->is_repeated()) {
+      if (!Chance(options_.field_density)) continue;
+      for (size_t n = Length(options_.repeated_length); n > 0; --n) {
+        SetValue(message, field, depth);
+      }
+    } else if (field->is_required() || Chance(options_.field_density)) {
+      SetValue(message, field, depth);
+    }
+  }
+}
+
+void MessageGenerator::SetValue(pb::Message* message, const pb::FieldDescriptor* field, int depth) {
+  const pb::Reflection* ref = message->GetReflection();
+  bool repeated = field->is_repeated();
+  switch (field->cpp_type()) {
+    case pb::FieldDescriptor::CPPTYPE_INT32: {
+      pb::int32 value = static_cast<pb::int32>(Bits(31));
+      if (Next() & 1) value = -value - 1;
+      repeated ? ref->AddInt32(message, field, value) : ref->SetInt32(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_INT64: {
+      pb::int64 value = static_cast<pb::int64>(Bits(63));
+      if (Next() & 1) value = -value - 1;
+      repeated ? ref->AddInt64(message, field, value) : ref->SetInt64(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT32: {
+      pb::uint32 value = static_cast<pb::uint32>(Bits(32));
+      repeated ? ref->AddUInt32(message, field, value) : ref->SetUInt32(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_UINT64: {
+      pb::uint64 value = Bits(64);
+      repeated ? ref->AddUInt64(message, field, value) : ref->SetUInt64(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE: {
+      // A whole number scaled by a power of two, so every digit it has is exact
+      double value = std::ldexp(static_cast<double>(Bits(53)), -static_cast<int>(Next() % 53));
+      if (Next() & 1) value = -value;
+      repeated ? ref->AddDouble(message, field, value) : ref->SetDouble(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_FLOAT: {
+      float value = std::ldexp(static_cast<float>(Bits(24)), -static_cast<int>(Next() % 24));
+      if (Next() & 1) value = -value;
+      repeated ? ref->AddFloat(message, field, value) : ref->SetFloat(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_BOOL: {
+      bool value = (Next() & 1) != 0;
+      repeated ? ref->AddBool(message, field, value) : ref->SetBool(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      const pb::EnumDescriptor* type = field->enum_type();
+      const pb::EnumValueDescriptor* value = type->value(Next() % type->value_count());
+      repeated ? ref->AddEnum(message, field, value) : ref->SetEnum(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING: {
+      std::string value;
+      String(field->type() == pb::FieldDescriptor::TYPE_BYTES, &value);
+      repeated ? ref->AddString(message, field, value) : ref->SetString(message, field, value);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      FillMessage(repeated ? ref->AddMessage(message, field) : ref->MutableMessage(message, field),
+                  depth + 1);
+      break;
+  }
+}
+
+unsigned long long MessageGenerator::Next() {
+  // splitmix64, which gives the same numbers on every platform
+  unsigned long long z = (state_ += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+bool MessageGenerator::Chance(double p) {
+  return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+unsigned long long MessageGenerator::Bits(int bits) {
+  // Draw the width first, so small numbers are as common as large ones
+  int width = static_cast<int>(Next() % (bits + 1));
+  return width == 0 ? 0 : Next() >> (64 - width);
+}
+
+size_t MessageGenerator::Length(const LengthDistribution& distribution) {
+  if (distribution.max <= distribution.min) return distribution.min;
+  if (distribution.shape == LengthDistribution::UNIFORM) {
+    return distribution.min + Next() % (distribution.max - distribution.min + 1);
+  }
+  double extra = distribution.mean - distribution.min;
+  if (extra <= 0) return distribution.min;
+  // The number of failures before a success of chance 1 / (1 + extra)
+  double u = 1.0 - static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+  double length = std::floor(std::log(u) / std::log(extra / (1.0 + extra)));
+  if (length >= static_cast<double>(distribution.max - distribution.min)) return distribution.max;
+  return distribution.min + static_cast<size_t>(length);
+}
+
+void MessageGenerator::String(bool bytes, std::string* value) {
+  size_t length = Length(options_.string_length);
+  value->resize(length);
+  for (size_t i = 0; i < length; ++i) {
+    (*value)[i] = bytes ? static_cast<char>(Next() & 0xff) : static_cast<char>(' ' + Next() % 95);
+  }
+}
+
+}  // namespace pjconv
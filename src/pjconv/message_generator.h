@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-09
+ */
+
+#ifndef PJCONV_MESSAGE_GENERATOR_H_
+#define PJCONV_MESSAGE_GENERATOR_H_
+
+#include <cstddef>
+#include <string>
+#include <google/protobuf/message.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace pjconv {
+
+/**
+ * How the lengths of repeated fields or of strings are drawn
+ */
+struct LengthDistribution {
+  enum Shape {
+    /** Every length from min to max is as likely */
+    UNIFORM,
+    /** Short lengths are the most likely, with a long tail up to max */
+    GEOMETRIC,
+  };
+
+  LengthDistribution(size_t min_length, size_t max_length, Shape length_shape = UNIFORM,
+                     double mean_length = 0)
+      : min(min_length), max(max_length), shape(length_shape), mean(mean_length) {
+  }
+
+  size_t min;
+  size_t max;
+  Shape shape;
+  /** The mean length of a GEOMETRIC distribution before it is cut at max */
+  double mean;
+};
+
+/**
+ * Options of a MessageGenerator
+ */
+struct GeneratorOptions {
+  GeneratorOptions()
+      : seed(1),
+        field_density(0.5),
+        repeated_length(0, 4),
+        string_length(0, 16),
+        max_depth(4) {
+  }
+
+  /** The generator makes the same messages from the same seed */
+  unsigned long long seed;
+  /**
+   * The chance of setting each optional field, each oneof and each
+   * repeated field; required fields are always set
+   */
+  double field_density;
+  /** The number of elements of a repeated field that is set */
+  LengthDistribution repeated_length;
+  /** The length of a string or bytes value */
+  LengthDistribution string_length;
+  /**
+   * The depth of the deepest submessage; message fields below it are left
+   * unset even if they are required, which bounds recursive types
+   */
+  int max_depth;
+};
+
+/**
+ * Fills messages of any type with random values, to make load and
+ * benchmark data of a given shape from nothing but a descriptor.
+ *
+ * Numbers take every magnitude, enums their declared values and strings
+ * printable ASCII. A generator is not thread-safe; use one per thread.
+ */
+class MessageGenerator {
+ public:
+  explicit MessageGenerator(const GeneratorOptions& options = GeneratorOptions());
+
+  /**
+   * Clear a message and fill it with the next random values
+   *
+   * @param message the message to fill, of any type
+   */
+  void Fill(google::protobuf::Message* message);
+
+  /**
+   * Write random messages as length-delimited records, that is each one's
+   * size as a varint followed by the message
+   *
+   * @param prototype the type of the messages
+   * @param count the number of messages
+   * @param output the stream the records are written to
+   * @return true if all records are written, false if the stream failed
+   */
+  bool WriteDelimited(
+      const google::protobuf::Message& prototype,
+      size_t count,
+      google::protobuf::io::ZeroCopyOutputStream* output);
+
+ private:
+  MessageGenerator(const MessageGenerator&);
+  void operator=(const MessageGenerator&);
+
+  void FillMessage(google::protobuf::Message* message, int depth);
+  /** Set a singular field, or add an element to a repeated one */
+  void SetValue(
+      google::protobuf::Message* message,
+      const google::protobuf::FieldDescriptor* field,
+      int depth);
+
+  unsigned long long Next();
+  /** @return true with the given chance */
+  bool Chance(double p);
+  /** @return a number of every magnitude up to the given number of bits */
+  unsigned long long Bits(int bits);
+  size_t Length(const LengthDistribution& distribution);
+  void String(bool bytes, std::string* value);
+
+  GeneratorOptions options_;
+  unsigned long long state_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_MESSAGE_GENERATOR_H_
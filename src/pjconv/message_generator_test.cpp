@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-09
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <gtest/gtest.h>
+
+#include "pjconv/message_generator.h"
+#include "pjconv/pjconv.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+TEST(MessageGenerator, RepeatsItsSeed) {
+  GeneratorOptions options;
+  options.seed = 7;
+  MessageGenerator a(options);
+  MessageGenerator b(options);
+  options.seed = 8;
+  MessageGenerator c(options);
+  std::unique_ptr<pb::Message> x(test::NewTypes());
+  std::unique_ptr<pb::Message> y(test::NewTypes());
+  int differ = 0;
+  for (int i = 0; i < 20; ++i) {
+    a.Fill(x.get());
+    b.Fill(y.get());
+    EXPECT_EQ(x->SerializeAsString(), y->SerializeAsString());
+    c.Fill(y.get());
+    if (x->SerializeAsString() != y->SerializeAsString()) ++differ;
+  }
+  EXPECT_GT(differ, 0);
+}
+
+TEST(MessageGenerator, FollowsDensity) {
+  GeneratorOptions options;
+  options.field_density = 0;
+  MessageGenerator sparse(options);
+  tutorial::Person person;
+  sparse.Fill(&person);
+  // Required fields are set all the same
+  EXPECT_TRUE(person.has_name());
+  EXPECT_TRUE(person.has_id());
+  EXPECT_FALSE(person.has_email());
+  EXPECT_EQ(0, person.phone_size());
+
+  options.field_density = 1;
+  options.repeated_length = LengthDistribution(3, 3);
+  options.string_length = LengthDistribution(5, 5);
+  MessageGenerator dense(options);
+  std::unique_ptr<pb::Message> types(test::NewTypes());
+  dense.Fill(types.get());
+  const pb::Descriptor* desc = types->GetDescriptor();
+  const pb::Reflection* ref = types->GetReflection();
+  for (int i = 0; i < desc->field_count(); ++i) {
+    const pb::FieldDescriptor* field = desc->field(i);
+    if (field->is_repeated()) {
+      EXPECT_EQ(3, ref->FieldSize(*types, field)) << field->name();
+    } else {
+      EXPECT_TRUE(ref->HasField(*types, field)) << field->name();
+    }
+  }
+  EXPECT_EQ(5u, ref->GetString(*types, desc->FindFieldByName("s")).size());
+}
+
+TEST(MessageGenerator, StopsAtMaxDepth) {
+  GeneratorOptions options;
+  options.field_density = 1;
+  options.max_depth = 0;
+  MessageGenerator generator(options);
+  tutorial::AddressBook book;
+  generator.Fill(&book);
+  EXPECT_EQ(0, book.person_size());
+
+  options.max_depth = 1;
+  options.repeated_length = LengthDistribution(1, 1);
+  MessageGenerator deeper(options);
+  deeper.Fill(&book);
+  ASSERT_EQ(1, book.person_size());
+  // The phone numbers would be at depth 2
+  EXPECT_EQ(0, book.person(0).phone_size());
+  EXPECT_TRUE(book.person(0).has_name());
+}
+
+TEST(MessageGenerator, SetsOneFieldOfAOneof) {
+  GeneratorOptions options;
+  options.field_density = 1;
+  MessageGenerator generator(options);
+  std::unique_ptr<pb::Message> event(test::NewEvent());
+  const pb::Descriptor* desc = event->GetDescriptor();
+  for (int i = 0; i < 20; ++i) {
+    generator.Fill(event.get());
+    const pb::Reflection* ref = event->GetReflection();
+    EXPECT_TRUE(ref->HasOneof(*event, desc->oneof_decl(0)));
+  }
+}
+
+TEST(MessageGenerator, DrawsGeometricLengths) {
+  GeneratorOptions options;
+  options.field_density = 1;
+  options.string_length = LengthDistribution(2, 40, LengthDistribution::GEOMETRIC, 6);
+  MessageGenerator generator(options);
+  tutorial::Person person;
+  size_t total = 0;
+  size_t longest = 0;
+  const int n = 2000;
+  for (int i = 0; i < n; ++i) {
+    generator.Fill(&person);
+    size_t length = person.name().size();
+    EXPECT_GE(length, 2u);
+    EXPECT_LE(length, 40u);
+    total += length;
+    longest = std::max(longest, length);
+  }
+  EXPECT_NEAR(6.0, static_cast<double>(total) / n, 0.5);
+  EXPECT_GT(longest, 20u);
+}
+
+TEST(MessageGenerator, WritesDelimitedRecords) {
+  GeneratorOptions options;
+  options.seed = 3;
+  std::string data;
+  {
+    pb::io::StringOutputStream output(&data);
+    MessageGenerator generator(options);
+    ASSERT_TRUE(generator.WriteDelimited(tutorial::AddressBook::default_instance(), 10, &output));
+  }
+  MessageGenerator generator(options);
+  tutorial::AddressBook expected;
+  pb::io::CodedInputStream input(reinterpret_cast<const pb::uint8*>(data.data()),
+                                 static_cast<int>(data.size()));
+  for (int i = 0; i < 10; ++i) {
+    generator.Fill(&expected);
+    pb::uint32 size;
+    ASSERT_TRUE(input.ReadVarint32(&size));
+    std::string bytes;
+    ASSERT_TRUE(input.ReadString(&bytes, size));
+    EXPECT_EQ(expected.SerializePartialAsString(), bytes);
+  }
+  const void* rest;
+  int rest_size;
+  EXPECT_FALSE(input.GetDirectBufferPointer(&rest, &rest_size));
+}
+
+TEST(MessageGenerator, MessagesSurviveJson) {
+  GeneratorOptions options;
+  options.field_density = 0.7;
+  MessageGenerator generator(options);
+  PJConverter conv;
+  std::unique_ptr<pb::Message> types(test::NewTypes());
+  std::unique_ptr<pb::Message> back(test::NewTypes());
+  for (int i = 0; i < 200; ++i) {
+    generator.Fill(types.get());
+    std::string json;
+    ASSERT_TRUE(conv.Convert(*types, &json, false, false));
+    ASSERT_TRUE(conv.Convert(json, back.get())) << json;
+    EXPECT_EQ(types->SerializeAsString(), back->SerializeAsString()) << json;
+  }
+}
+
+}  // namespace pjconv
@@ -0,0 +1,717 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-22
+ */
+
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <locale.h>
+
+#include "pjconv/number_format.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int CountDigits(pb::uint64 value) {
+  int count = 1;
+  for (;;) {
+    if (value < 10) return count;
+    if (value < 100) return count + 1;
+    if (value < 1000) return count + 2;
+    if (value < 10000) return count + 3;
+    value /= 10000;
+    count += 4;
+  }
+}
+
+// Grisu2 after Florian Loitsch, "Printing Floating-Point Numbers Quickly
+// and Accurately with Integers". The value and its rounding boundaries are
+// scaled by a cached power of ten into a range where 64-bit integers hold
+// them exactly enough, and digits are generated until the result falls
+// between the boundaries. The range is shrunk for the error of the
+// scaling, so shorter digits that lie just outside it, such as a boundary
+// that rounds to the value because its significand is even, are noted and
+// checked afterwards by reading them back.
+
+/**
+ * A floating point number f * 2^e with a 64-bit significand
+ */
+struct DiyFp {
+  DiyFp(pb::uint64 f_, int e_) : f(f_), e(e_) {
+  }
+
+  pb::uint64 f;
+  int e;
+};
+
+DiyFp Multiply(const DiyFp& x, const DiyFp& y) {
+  // The upper 64 bits of the 128-bit product, rounded
+  const pb::uint64 kMask = 0xFFFFFFFFULL;
+  pb::uint64 a = x.f >> 32;
+  pb::uint64 b = x.f & kMask;
+  pb::uint64 c = y.f >> 32;
+  pb::uint64 d = y.f & kMask;
+  pb::uint64 ac = a * c;
+  pb::uint64 bc = b * c;
+  pb::uint64 ad = a * d;
+  pb::uint64 bd = b * d;
+  pb::uint64 middle = (bd >> 32) + (ad & kMask) + (bc & kMask) + (1ULL << 31);
+  return DiyFp(ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64);
+}
+
+DiyFp Normalize(DiyFp x) {
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    --x.e;
+  }
+  return x;
+}
+
+/**
+ * A value and the midpoints to its neighbours, normalized to one exponent
+ */
+struct Boundaries {
+  Boundaries() : w(0, 0), minus(0, 0), plus(0, 0) {
+  }
+
+  DiyFp w;
+  DiyFp minus;
+  DiyFp plus;
+};
+
+// The boundaries of a finite positive value with the given significand
+// bits, exponent bits and precision
+Boundaries ComputeBoundaries(pb::uint64 fraction, int biased_exponent, int precision,
+                             int max_exponent) {
+  const int kBias = max_exponent - 1 + (precision - 1);
+  const pb::uint64 kHiddenBit = 1ULL << (precision - 1);
+  DiyFp v = biased_exponent == 0 ? DiyFp(fraction, 1 - kBias) :
+      DiyFp(fraction + kHiddenBit, biased_exponent - kBias);
+  // At a power of two the gap below is half the gap above
+  bool lower_is_closer = fraction == 0 && biased_exponent > 1;
+  DiyFp plus(2 * v.f + 1, v.e - 1);
+  DiyFp minus = lower_is_closer ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+
+  Boundaries result;
+  result.plus = Normalize(plus);
+  result.minus = DiyFp(minus.f << (minus.e - result.plus.e), result.plus.e);
+  result.w = Normalize(v);
+  return result;
+}
+
+struct CachedPower {
+  pb::uint64 f;
+  int e;
+  int k;
+};
+
+// 10^k for k = -300, -292, ..., 324, normalized and rounded to 64 bits
+const CachedPower kCachedPowers[] = {
+  { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+  { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+  { 0xBE5691EF416BD60CULL, -1007, -284 },
+  { 0x8DD01FAD907FFC3CULL, -980, -276 },
+  { 0xD3515C2831559A83ULL, -954, -268 },
+  { 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+  { 0xEA9C227723EE8BCBULL, -901, -252 },
+  { 0xAECC49914078536DULL, -874, -244 },
+  { 0x823C12795DB6CE57ULL, -847, -236 },
+  { 0xC21094364DFB5637ULL, -821, -228 },
+  { 0x9096EA6F3848984FULL, -794, -220 },
+  { 0xD77485CB25823AC7ULL, -768, -212 },
+  { 0xA086CFCD97BF97F4ULL, -741, -204 },
+  { 0xEF340A98172AACE5ULL, -715, -196 },
+  { 0xB23867FB2A35B28EULL, -688, -188 },
+  { 0x84C8D4DFD2C63F3BULL, -661, -180 },
+  { 0xC5DD44271AD3CDBAULL, -635, -172 },
+  { 0x936B9FCEBB25C996ULL, -608, -164 },
+  { 0xDBAC6C247D62A584ULL, -582, -156 },
+  { 0xA3AB66580D5FDAF6ULL, -555, -148 },
+  { 0xF3E2F893DEC3F126ULL, -529, -140 },
+  { 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+  { 0x87625F056C7C4A8BULL, -475, -124 },
+  { 0xC9BCFF6034C13053ULL, -449, -116 },
+  { 0x964E858C91BA2655ULL, -422, -108 },
+  { 0xDFF9772470297EBDULL, -396, -100 },
+  { 0xA6DFBD9FB8E5B88FULL, -369, -92 },
+  { 0xF8A95FCF88747D94ULL, -343, -84 },
+  { 0xB94470938FA89BCFULL, -316, -76 },
+  { 0x8A08F0F8BF0F156BULL, -289, -68 },
+  { 0xCDB02555653131B6ULL, -263, -60 },
+  { 0x993FE2C6D07B7FACULL, -236, -52 },
+  { 0xE45C10C42A2B3B06ULL, -210, -44 },
+  { 0xAA242499697392D3ULL, -183, -36 },
+  { 0xFD87B5F28300CA0EULL, -157, -28 },
+  { 0xBCE5086492111AEBULL, -130, -20 },
+  { 0x8CBCCC096F5088CCULL, -103, -12 },
+  { 0xD1B71758E219652CULL, -77, -4 },
+  { 0x9C40000000000000ULL, -50, 4 },
+  { 0xE8D4A51000000000ULL, -24, 12 },
+  { 0xAD78EBC5AC620000ULL, 3, 20 },
+  { 0x813F3978F8940984ULL, 30, 28 },
+  { 0xC097CE7BC90715B3ULL, 56, 36 },
+  { 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+  { 0xD5D238A4ABE98068ULL, 109, 52 },
+  { 0x9F4F2726179A2245ULL, 136, 60 },
+  { 0xED63A231D4C4FB27ULL, 162, 68 },
+  { 0xB0DE65388CC8ADA8ULL, 189, 76 },
+  { 0x83C7088E1AAB65DBULL, 216, 84 },
+  { 0xC45D1DF942711D9AULL, 242, 92 },
+  { 0x924D692CA61BE758ULL, 269, 100 },
+  { 0xDA01EE641A708DEAULL, 295, 108 },
+  { 0xA26DA3999AEF774AULL, 322, 116 },
+  { 0xF209787BB47D6B85ULL, 348, 124 },
+  { 0xB454E4A179DD1877ULL, 375, 132 },
+  { 0x865B86925B9BC5C2ULL, 402, 140 },
+  { 0xC83553C5C8965D3DULL, 428, 148 },
+  { 0x952AB45CFA97A0B3ULL, 455, 156 },
+  { 0xDE469FBD99A05FE3ULL, 481, 164 },
+  { 0xA59BC234DB398C25ULL, 508, 172 },
+  { 0xF6C69A72A3989F5CULL, 534, 180 },
+  { 0xB7DCBF5354E9BECEULL, 561, 188 },
+  { 0x88FCF317F22241E2ULL, 588, 196 },
+  { 0xCC20CE9BD35C78A5ULL, 614, 204 },
+  { 0x98165AF37B2153DFULL, 641, 212 },
+  { 0xE2A0B5DC971F303AULL, 667, 220 },
+  { 0xA8D9D1535CE3B396ULL, 694, 228 },
+  { 0xFB9B7CD9A4A7443CULL, 720, 236 },
+  { 0xBB764C4CA7A44410ULL, 747, 244 },
+  { 0x8BAB8EEFB6409C1AULL, 774, 252 },
+  { 0xD01FEF10A657842CULL, 800, 260 },
+  { 0x9B10A4E5E9913129ULL, 827, 268 },
+  { 0xE7109BFBA19C0C9DULL, 853, 276 },
+  { 0xAC2820D9623BF429ULL, 880, 284 },
+  { 0x80444B5E7AA7CF85ULL, 907, 292 },
+  { 0xBF21E44003ACDD2DULL, 933, 300 },
+  { 0x8E679C2F5E44FF8FULL, 960, 308 },
+  { 0xD433179D9C8CB841ULL, 986, 316 },
+  { 0x9E19DB92B4E31BA9ULL, 1013, 324 },
+};
+
+const int kCachedPowersMinDecimalExponent = -300;
+const int kCachedPowersDecimalStep = 8;
+
+// The scaled value's exponent lands in [kAlpha, kGamma], so its integral
+// part fits 32 bits and its fraction 64
+const int kAlpha = -60;
+
+CachedPower CachedPowerFor(int e) {
+  // k = ceil((kAlpha - e - 1) * log10(2)), with 78913 / 2^18 for log10(2)
+  int f = kAlpha - e - 1;
+  int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+  int index = (-kCachedPowersMinDecimalExponent + k + (kCachedPowersDecimalStep - 1)) /
+      kCachedPowersDecimalStep;
+  return kCachedPowers[index];
+}
+
+// The number of decimal digits of n, and the largest power of ten not above it
+int LargestPow10(pb::uint32 n, pb::uint32* pow10) {
+  pb::uint32 p = 1000000000;
+  int digits = 10;
+  while (digits > 1 && n < p) {
+    p /= 10;
+    --digits;
+  }
+  *pow10 = p;
+  return digits;
+}
+
+/**
+ * Shorter digits that may lie within the exact boundaries though not
+ * within the shrunk ones: a prefix of the generated digits, rounded up
+ * if up is set, times 10^exponent
+ */
+struct NearMiss {
+  int length;
+  int exponent;
+  bool up;
+};
+
+// The most digits Grisu2 generates, and so the most near misses
+const int kMaxDigits = 20;
+
+// The scaled boundaries are off the exact ones by less than this many units
+const pb::uint64 kBoundaryError = 4;
+
+// Whether the prefix of the digits generated so far, or the prefix rounded
+// up, is within error of the boundaries; rest is how far the prefix is
+// below the upper boundary, delta how far the lower one is
+inline bool IsNearMiss(pb::uint64 rest, pb::uint64 delta, pb::uint64 ten_k, pb::uint64 error) {
+  return rest - delta <= error || ten_k - rest <= error;
+}
+
+void NoteNearMiss(int length, int exponent, pb::uint64 rest, pb::uint64 delta, pb::uint64 error,
+                  NearMiss* misses, int* miss_count) {
+  NearMiss& miss = misses[(*miss_count)++];
+  miss.length = length;
+  miss.exponent = exponent;
+  miss.up = rest - delta > error;
+}
+
+// Move the last digit toward w while it stays within the boundaries
+void Round(char* digits, int length, pb::uint64 dist, pb::uint64 delta, pb::uint64 rest,
+           pb::uint64 ten_k) {
+  while (rest < dist && delta - rest >= ten_k &&
+         (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    --digits[length - 1];
+    rest += ten_k;
+  }
+}
+
+void GenerateDigits(char* digits, int* length, int* exponent, DiyFp minus, DiyFp w, DiyFp plus,
+                    NearMiss* misses, int* miss_count) {
+  pb::uint64 delta = plus.f - minus.f;
+  pb::uint64 dist = plus.f - w.f;
+  const int shift = -plus.e;
+  const pb::uint64 one = 1ULL << shift;
+  pb::uint32 p1 = static_cast<pb::uint32>(plus.f >> shift);
+  pb::uint64 p2 = plus.f & (one - 1);
+
+  pb::uint32 pow10;
+  int n = LargestPow10(p1, &pow10);
+  while (n > 0) {
+    digits[(*length)++] = static_cast<char>('0' + p1 / pow10);
+    p1 %= pow10;
+    --n;
+    pb::uint64 rest = (static_cast<pb::uint64>(p1) << shift) + p2;
+    if (rest <= delta) {
+      *exponent += n;
+      Round(digits, *length, dist, delta, rest, static_cast<pb::uint64>(pow10) << shift);
+      return;
+    }
+    if (IsNearMiss(rest, delta, static_cast<pb::uint64>(pow10) << shift, kBoundaryError)) {
+      NoteNearMiss(*length, *exponent + n, rest, delta, kBoundaryError, misses, miss_count);
+    }
+    pow10 /= 10;
+  }
+  int m = 0;
+  pb::uint64 error = kBoundaryError;
+  for (;;) {
+    p2 *= 10;
+    digits[(*length)++] = static_cast<char>('0' + (p2 >> shift));
+    p2 &= one - 1;
+    ++m;
+    delta *= 10;
+    dist *= 10;
+    error *= 10;
+    if (p2 <= delta) break;
+    if (IsNearMiss(p2, delta, one, error)) {
+      NoteNearMiss(*length, *exponent - m, p2, delta, error, misses, miss_count);
+    }
+  }
+  *exponent -= m;
+  Round(digits, *length, dist, delta, p2, one);
+}
+
+// Write the digits of a positive value; value = digits * 10^exponent
+void Grisu2(const Boundaries& b, char* digits, int* length, int* exponent,
+            NearMiss* misses, int* miss_count) {
+  CachedPower cached = CachedPowerFor(b.plus.e);
+  DiyFp c(cached.f, cached.e);
+  DiyFp w = Multiply(b.w, c);
+  DiyFp minus = Multiply(b.minus, c);
+  DiyFp plus = Multiply(b.plus, c);
+  // Shrink the range by one unit on each side for the error of the products
+  *length = 0;
+  *exponent = -cached.k;
+  GenerateDigits(digits, length, exponent, DiyFp(minus.f + 1, minus.e), w,
+                 DiyFp(plus.f - 1, plus.e), misses, miss_count);
+}
+
+inline bool ParseNumber(const char* data, size_t size, double* value) {
+  return ParseDouble(data, size, value);
+}
+
+inline bool ParseNumber(const char* data, size_t size, float* value) {
+  return ParseFloat(data, size, value);
+}
+
+// Replace the digits with those of the shortest near miss that reads back
+// as the positive value, if any does
+template<typename T>
+void CheckNearMisses(T value, const NearMiss* misses, int miss_count,
+                     char* digits, int* length, int* exponent) {
+  for (int i = 0; i < miss_count; ++i) {
+    char text[kMaxNumberSize];
+    int size = misses[i].length;
+    int power = misses[i].exponent;
+    memcpy(text, digits, size);
+    if (misses[i].up) {
+      int j = size - 1;
+      while (j >= 0 && text[j] == '9') text[j--] = '0';
+      if (j < 0) {
+        // 99 rounds up to 1 * 10^2
+        text[0] = '1';
+        power += size;
+        size = 1;
+      } else {
+        ++text[j];
+      }
+    }
+    while (size > 1 && text[size - 1] == '0') {
+      --size;
+      ++power;
+    }
+    text[size] = 'e';
+    char* end = FormatInt64(power, text + size + 1);
+    T back;
+    if (ParseNumber(text, end - text, &back) && back == value) {
+      memcpy(digits, text, size);
+      *length = size;
+      *exponent = power;
+      return;
+    }
+  }
+}
+
+char* WriteExponent(int exponent, char* p) {
+  *p++ = 'e';
+  if (exponent < 0) {
+    *p++ = '-';
+    exponent = -exponent;
+  } else {
+    *p++ = '+';
+  }
+  // printf writes at least two digits
+  if (exponent >= 100) {
+    *p++ = static_cast<char>('0' + exponent / 100);
+    exponent %= 100;
+  }
+  memcpy(p, kDigitPairs + 2 * exponent, 2);
+  return p + 2;
+}
+
+// Lay out length digits with value digits * 10^exponent like %.17g
+char* Layout(const char* digits, int length, int exponent, char* p) {
+  // The value is 0.digits * 10^point
+  int point = length + exponent;
+  if (point > -4 && point <= 17) {
+    if (point <= 0) {
+      *p++ = '0';
+      *p++ = '.';
+      memset(p, '0', -point);
+      p += -point;
+      memcpy(p, digits, length);
+      return p + length;
+    }
+    if (point >= length) {
+      memcpy(p, digits, length);
+      p += length;
+      memset(p, '0', point - length);
+      p += point - length;
+      *p++ = '.';
+      *p++ = '0';
+      return p;
+    }
+    memcpy(p, digits, point);
+    p += point;
+    *p++ = '.';
+    memcpy(p, digits + point, length - point);
+    return p + length - point;
+  }
+  *p++ = digits[0];
+  if (length > 1) {
+    *p++ = '.';
+    memcpy(p, digits + 1, length - 1);
+    p += length - 1;
+  }
+  return WriteExponent(point - 1, p);
+}
+
+// Write a value given its sign and magnitude
+template<typename T>
+char* FormatBinary(bool negative, T magnitude, bool zero, const Boundaries& boundaries, char* p) {
+  if (negative) *p++ = '-';
+  if (zero) {
+    memcpy(p, "0.0", 3);
+    return p + 3;
+  }
+  char digits[kMaxDigits];
+  int length;
+  int exponent;
+  NearMiss misses[kMaxDigits];
+  int miss_count = 0;
+  Grisu2(boundaries, digits, &length, &exponent, misses, &miss_count);
+  CheckNearMisses(magnitude, misses, miss_count, digits, &length, &exponent);
+  return Layout(digits, length, exponent, p);
+}
+
+/**
+ * A JSON number split into its decimal significand and exponent
+ */
+struct Decimal {
+  bool negative;
+  /** The significant digits, if there are at most 19 of them */
+  pb::uint64 significand;
+  int exponent;
+  /** Whether the significand lost digits */
+  bool truncated;
+};
+
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Split a number in JSON syntax; the significand is exact unless truncated
+bool Decompose(const char* p, const char* end, Decimal* decimal) {
+  decimal->negative = p != end && *p == '-';
+  if (decimal->negative) ++p;
+  if (p == end || !IsDigit(*p)) return false;
+  pb::uint64 significand = 0;
+  int digits = 0;
+  int exponent = 0;
+  // A leading zero stands alone
+  if (*p == '0') {
+    ++p;
+  } else {
+    for (; p != end && IsDigit(*p); ++p) {
+      if (digits < 19) {
+        significand = significand * 10 + (*p - '0');
+        ++digits;
+      } else {
+        ++exponent;
+        if (*p != '0') decimal->truncated = true;
+      }
+    }
+  }
+  if (p != end && *p == '.') {
+    ++p;
+    if (p == end || !IsDigit(*p)) return false;
+    for (; p != end && IsDigit(*p); ++p) {
+      if (significand == 0 && *p == '0') {
+        --exponent;
+      } else if (digits < 19) {
+        significand = significand * 10 + (*p - '0');
+        ++digits;
+        --exponent;
+      } else if (*p != '0') {
+        decimal->truncated = true;
+      }
+    }
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative = p != end && *p == '-';
+    if (p != end && (*p == '+' || *p == '-')) ++p;
+    if (p == end || !IsDigit(*p)) return false;
+    int value = 0;
+    for (; p != end && IsDigit(*p); ++p) {
+      // Saturate; anything this far out is zero or infinity anyway
+      if (value < 100000) value = value * 10 + (*p - '0');
+    }
+    exponent += negative ? -value : value;
+  }
+  decimal->significand = significand;
+  decimal->exponent = exponent;
+  return p == end;
+}
+
+// The C locale, so that strtod always reads a decimal point
+locale_t CLocale() {
+  static locale_t locale = newlocale(LC_ALL_MASK, "C", static_cast<locale_t>(0));
+  return locale;
+}
+
+// A midpoint between two doubles has at most 767 significant digits, so
+// digits past this many only matter as to whether any of them is nonzero
+const int kMaxSignificantDigits = 768;
+
+// strtod needs a terminated copy. It is kept on the stack: leading zeros
+// and the point are left out, and the digits past kMaxSignificantDigits
+// are replaced with a single 1 if any of them is nonzero, which rounds the
+// same. The number has passed Decompose.
+template<typename T, typename Strtod>
+bool ParseSlow(const char* data, size_t size, Strtod convert, T* value) {
+  char buf[kMaxSignificantDigits + 32];
+  char* q = buf;
+  const char* p = data;
+  const char* end = data + size;
+  if (*p == '-') *q++ = *p++;
+  // The value is the copied digits times 10^exponent
+  pb::int64 exponent = 0;
+  int digits = 0;
+  bool dropped = false;
+  bool fraction = false;
+  for (; p != end && *p != 'e' && *p != 'E'; ++p) {
+    if (*p == '.') {
+      fraction = true;
+      continue;
+    }
+    if (fraction) --exponent;
+    if (digits == 0 && *p == '0') continue;
+    if (digits < kMaxSignificantDigits) {
+      *q++ = *p;
+      ++digits;
+    } else {
+      ++exponent;
+      if (*p != '0') dropped = true;
+    }
+  }
+  if (digits == 0) *q++ = '0';
+  if (dropped) {
+    *q++ = '1';
+    --exponent;
+  }
+  if (p != end) {
+    ++p;
+    bool negative = *p == '-';
+    if (*p == '+' || *p == '-') ++p;
+    pb::int64 written = 0;
+    for (; p != end; ++p) {
+      // Saturate; anything this far out is zero or infinity anyway
+      if (written < 100000) written = written * 10 + (*p - '0');
+    }
+    exponent += negative ? -written : written;
+  }
+  *q++ = 'e';
+  q = FormatInt64(exponent, q);
+  *q = '\0';
+  char* parsed;
+  *value = convert(buf, &parsed, CLocale());
+  return parsed == q;
+}
+
+// Powers of ten that are exact as doubles
+const double kExactPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Powers of ten that are exact as floats
+const float kExactFloatPowersOfTen[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+}  // namespace
+
+char* FormatDouble(double value, char* buffer) {
+  pb::uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  pb::uint64 fraction = bits & ((1ULL << 52) - 1);
+  int exponent = static_cast<int>((bits >> 52) & 0x7FF);
+  Boundaries boundaries;
+  bool zero = fraction == 0 && exponent == 0;
+  if (!zero) {
+    boundaries = ComputeBoundaries(fraction, exponent, std::numeric_limits<double>::digits,
+                                   std::numeric_limits<double>::max_exponent);
+  }
+  bool negative = (bits >> 63) != 0;
+  return FormatBinary(negative, negative ? -value : value, zero, boundaries, buffer);
+}
+
+char* FormatFloat(float value, char* buffer) {
+  pb::uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  pb::uint32 fraction = bits & ((1U << 23) - 1);
+  int exponent = static_cast<int>((bits >> 23) & 0xFF);
+  Boundaries boundaries;
+  bool zero = fraction == 0 && exponent == 0;
+  if (!zero) {
+    // The boundaries are those of the float, so its shortest digits come out
+    boundaries = ComputeBoundaries(fraction, exponent, std::numeric_limits<float>::digits,
+                                   std::numeric_limits<float>::max_exponent);
+  }
+  bool negative = (bits >> 31) != 0;
+  return FormatBinary(negative, negative ? -value : value, zero, boundaries, buffer);
+}
+
+char* FormatInt64(pb::int64 value, char* buffer) {
+  if (value < 0) {
+    *buffer++ = '-';
+    // Negate in unsigned arithmetic so that the minimum value does not overflow
+    return FormatUInt64(0 - static_cast<pb::uint64>(value), buffer);
+  }
+  return FormatUInt64(static_cast<pb::uint64>(value), buffer);
+}
+
+char* FormatUInt64(pb::uint64 value, char* buffer) {
+  char* end = buffer + CountDigits(value);
+  char* p = end;
+  while (value >= 100) {
+    p -= 2;
+    memcpy(p, kDigitPairs + 2 * (value % 100), 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    memcpy(p - 2, kDigitPairs + 2 * value, 2);
+  } else {
+    p[-1] = static_cast<char>('0' + value);
+  }
+  return end;
+}
+
+bool ParseDouble(const char* data, size_t size, double* value) {
+  Decimal decimal = Decimal();
+  if (!Decompose(data, data + size, &decimal)) return false;
+  // Clinger's fast path: when both the significand and the power of ten
+  // are exact doubles, one correctly rounded operation is the answer
+  if (!decimal.truncated && decimal.significand <= (1ULL << 53) &&
+      decimal.exponent >= -22 && decimal.exponent <= 22) {
+    double d = static_cast<double>(decimal.significand);
+    if (decimal.exponent < 0) {
+      d /= kExactPowersOfTen[-decimal.exponent];
+    } else {
+      d *= kExactPowersOfTen[decimal.exponent];
+    }
+    *value = decimal.negative ? -d : d;
+    return true;
+  }
+  return ParseSlow(data, size, strtod_l, value);
+}
+
+bool ParseFloat(const char* data, size_t size, float* value) {
+  Decimal decimal = Decimal();
+  if (!Decompose(data, data + size, &decimal)) return false;
+  if (!decimal.truncated && decimal.significand <= (1ULL << 24) &&
+      decimal.exponent >= -10 && decimal.exponent <= 10) {
+    float f = static_cast<float>(decimal.significand);
+    if (decimal.exponent < 0) {
+      f /= kExactFloatPowersOfTen[-decimal.exponent];
+    } else {
+      f *= kExactFloatPowersOfTen[decimal.exponent];
+    }
+    *value = decimal.negative ? -f : f;
+    return true;
+  }
+  // Straight to float: going through double could round twice
+  return ParseSlow(data, size, strtof_l, value);
+}
+
+}  // namespace pjconv
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-22
+ */
+
+
+#ifndef PJCONV_NUMBER_FORMAT_H_
+#define PJCONV_NUMBER_FORMAT_H_
+
+#include <cstddef>
+#include <google/protobuf/stubs/common.h>
+
+namespace pjconv {
+
+/** Enough room for any number the functions below write */
+const int kMaxNumberSize = 32;
+
+/**
+ * Write the shortest decimal that reads back as the same double.
+ *
+ * The digits come from Grisu2. Shorter digits that its arithmetic cannot
+ * tell from the rounding boundaries, such as a boundary that reads back
+ * as the value because its significand is even, are tried by parsing
+ * them, so the digits are the shortest. The
+ * layout is that of printf("%.17g") with ".0" added to integral values,
+ * as Json::FastWriter writes them: fixed notation for decimal exponents
+ * from -4 to 16 and scientific notation otherwise.
+ *
+ * @param value a finite value
+ * @param buffer room for kMaxNumberSize chars
+ * @return the end of the written chars, which are not NUL-terminated
+ */
+char* FormatDouble(double value, char* buffer);
+
+/**
+ * Write the shortest decimal that reads back as the same float, in the
+ * same layout as FormatDouble
+ */
+char* FormatFloat(float value, char* buffer);
+
+/**
+ * Write an integer in decimal, two digits at a time
+ */
+char* FormatInt64(google::protobuf::int64 value, char* buffer);
+char* FormatUInt64(google::protobuf::uint64 value, char* buffer);
+
+/**
+ * Parse a JSON number into a double, rounded correctly
+ *
+ * Numbers whose digits fit in 53 bits and whose exponent is small, which
+ * are most of them, are converted with a single exact multiplication or
+ * division. The rest go to strtod in the "C" locale, so a decimal comma
+ * locale never changes the result.
+ *
+ * @param data the number, which need not be NUL-terminated
+ * @param size the length of the number
+ * @return false if the text is not exactly one JSON number
+ */
+bool ParseDouble(const char* data, size_t size, double* value);
+
+/**
+ * Parse a JSON number into a float, rounded once from the decimal
+ */
+bool ParseFloat(const char* data, size_t size, float* value);
+
+}  // namespace pjconv
+#endif  // PJCONV_NUMBER_FORMAT_H_
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-22
+ */
+
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "pjconv/number_format.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+std::string Double(double value) {
+  char buf[kMaxNumberSize];
+  return std::string(buf, FormatDouble(value, buf));
+}
+
+std::string Float(float value) {
+  char buf[kMaxNumberSize];
+  return std::string(buf, FormatFloat(value, buf));
+}
+
+std::string Int64(pb::int64 value) {
+  char buf[kMaxNumberSize];
+  return std::string(buf, FormatInt64(value, buf));
+}
+
+std::string UInt64(pb::uint64 value) {
+  char buf[kMaxNumberSize];
+  return std::string(buf, FormatUInt64(value, buf));
+}
+
+TEST(FormatDouble, WritesShortestDigits) {
+  EXPECT_EQ("0.1", Double(0.1));
+  EXPECT_EQ("0.3", Double(0.3));
+  EXPECT_EQ("0.30000000000000004", Double(0.1 + 0.2));
+  EXPECT_EQ("-2.5", Double(-2.5));
+  EXPECT_EQ("1e+300", Double(1e300));
+  EXPECT_EQ("5e-324", Double(5e-324));
+  EXPECT_EQ("1.7976931348623157e+308", Double(std::numeric_limits<double>::max()));
+  EXPECT_EQ("2.2250738585072014e-308", Double(std::numeric_limits<double>::min()));
+}
+
+TEST(FormatDouble, LaysOutLikePrintf) {
+  // Json::FastWriter prints %.17g and marks integral values with ".0"
+  EXPECT_EQ("0.0", Double(0.0));
+  EXPECT_EQ("-0.0", Double(-0.0));
+  EXPECT_EQ("1.0", Double(1.0));
+  EXPECT_EQ("-1.0", Double(-1.0));
+  EXPECT_EQ("1024.0", Double(1024.0));
+  EXPECT_EQ("12.5", Double(12.5));
+  EXPECT_EQ("0.0001", Double(1e-4));
+  EXPECT_EQ("1e-05", Double(1e-5));
+  EXPECT_EQ("1.5e-05", Double(1.5e-5));
+  EXPECT_EQ("10000000000000000.0", Double(1e16));
+  EXPECT_EQ("1e+17", Double(1e17));
+  EXPECT_EQ("1.25e+100", Double(1.25e100));
+}
+
+TEST(FormatDouble, RoundTrips) {
+  std::mt19937_64 random(20131222);
+  for (int i = 0; i < 200000; ++i) {
+    pb::uint64 bits = random();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0) continue;
+    std::string text = Double(value);
+    double back = strtod(text.c_str(), NULL);
+    ASSERT_EQ(0, memcmp(&value, &back, sizeof(value))) << text;
+    // Never longer than the 17 digits that always suffice
+    char full[64];
+    ASSERT_LE(text.size(), static_cast<size_t>(snprintf(full, sizeof(full), "%.17g", value) + 2))
+        << text;
+  }
+}
+
+TEST(FormatFloat, WritesShortestDigitsAsFloat) {
+  EXPECT_EQ("0.1", Float(0.1f));
+  EXPECT_EQ("0.25", Float(0.25f));
+  EXPECT_EQ("3.0", Float(3.0f));
+  EXPECT_EQ("-0.125", Float(-0.125f));
+  EXPECT_EQ("16777216.0", Float(16777216.0f));
+  EXPECT_EQ("3.4028235e+38", Float(std::numeric_limits<float>::max()));
+  EXPECT_EQ("1e-45", Float(std::numeric_limits<float>::denorm_min()));
+
+  std::mt19937 random(20131222);
+  for (int i = 0; i < 200000; ++i) {
+    pb::uint32 bits = random();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0) continue;
+    std::string text = Float(value);
+    float back = strtof(text.c_str(), NULL);
+    ASSERT_EQ(0, memcmp(&value, &back, sizeof(value))) << text;
+  }
+}
+
+// The fewest significant digits that read back as the value
+template<typename T>
+int ShortestDigits(T value, T (*parse)(const char*, char**)) {
+  for (int precision = 1;; ++precision) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.*e", precision - 1, static_cast<double>(value));
+    if (parse(text, NULL) == value) return precision;
+  }
+}
+
+int Digits(const std::string& text) {
+  std::string digits;
+  for (size_t i = 0; i < text.size() && text[i] != 'e'; ++i) {
+    if (text[i] >= '0' && text[i] <= '9') digits.push_back(text[i]);
+  }
+  digits.erase(0, digits.find_first_not_of('0'));
+  digits.erase(digits.find_last_not_of('0') + 1);
+  return static_cast<int>(digits.size());
+}
+
+float ToFloat(const char* text, char** end) {
+  return strtof(text, end);
+}
+
+double ToDouble(const char* text, char** end) {
+  return strtod(text, end);
+}
+
+TEST(FormatFloat, WritesEvenBoundaries) {
+  // 588900000 is the midpoint above 588899968f, which has an even
+  // significand, so it reads back as the float
+  EXPECT_EQ("588900000.0", Float(588899968.0f));
+  EXPECT_EQ("-588900000.0", Float(-588899968.0f));
+  // The boundary of an odd significand rounds away from it
+  EXPECT_EQ("588900030.0", Float(588900032.0f));
+
+  std::mt19937 random(20140223);
+  for (int i = 0; i < 100000; ++i) {
+    pb::uint32 bits = random();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0 || value == 0) continue;
+    std::string text = Float(value);
+    ASSERT_EQ(ShortestDigits(value, ToFloat), Digits(text)) << text;
+  }
+}
+
+TEST(FormatDouble, WritesTheFewestDigits) {
+  std::mt19937_64 random(20140223);
+  for (int i = 0; i < 100000; ++i) {
+    pb::uint64 bits = random();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    if (value != value || value - value != 0 || value == 0) continue;
+    std::string text = Double(value);
+    ASSERT_EQ(ShortestDigits(value, ToDouble), Digits(text)) << text;
+  }
+}
+
+TEST(FormatInt, WritesDecimal) {
+  EXPECT_EQ("0", UInt64(0));
+  EXPECT_EQ("7", UInt64(7));
+  EXPECT_EQ("10", UInt64(10));
+  EXPECT_EQ("99", UInt64(99));
+  EXPECT_EQ("100", UInt64(100));
+  EXPECT_EQ("18446744073709551615", UInt64(std::numeric_limits<pb::uint64>::max()));
+  EXPECT_EQ("-1", Int64(-1));
+  EXPECT_EQ("-9223372036854775808", Int64(std::numeric_limits<pb::int64>::min()));
+  EXPECT_EQ("9223372036854775807", Int64(std::numeric_limits<pb::int64>::max()));
+
+  pb::uint64 value = 1;
+  for (int i = 0; i < 20; ++i, value *= 10) {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "%llu", static_cast<unsigned long long>(value - 1));
+    EXPECT_EQ(expected, UInt64(value - 1));
+    snprintf(expected, sizeof(expected), "%llu", static_cast<unsigned long long>(value));
+    EXPECT_EQ(expected, UInt64(value));
+  }
+}
+
+TEST(ParseDouble, MatchesStrtod) {
+  const char* texts[] = {
+    "0", "-0", "1", "-1", "0.1", "0.3", "1e300", "1E-7", "2.5e+3", "123456789012345678",
+    "9007199254740993", "1.7976931348623157e308", "2.2250738585072014e-308", "5e-324",
+    "1e-400", "1e400", "-1e400", "0.000000000000000000000000000001", "1e22", "1e23",
+    "12345678901234567890123456789e-10", "3.14159265358979323846264338327950288",
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    double value;
+    ASSERT_TRUE(ParseDouble(texts[i], strlen(texts[i]), &value)) << texts[i];
+    double expected = strtod(texts[i], NULL);
+    EXPECT_EQ(0, memcmp(&expected, &value, sizeof(value))) << texts[i];
+  }
+
+  std::mt19937_64 random(20131229);
+  for (int i = 0; i < 100000; ++i) {
+    char text[64];
+    int size = snprintf(text, sizeof(text), "%llu.%llue%d",
+                        static_cast<unsigned long long>(random() >> (random() % 64)),
+                        static_cast<unsigned long long>(random() % 1000000),
+                        static_cast<int>(random() % 60) - 30);
+    double value;
+    ASSERT_TRUE(ParseDouble(text, size, &value)) << text;
+    double expected = strtod(text, NULL);
+    ASSERT_EQ(0, memcmp(&expected, &value, sizeof(value))) << text;
+  }
+}
+
+TEST(ParseDouble, ReadsLongNumbersExactly) {
+  // Exactly halfway between 1 and the next double, which rounds to even
+  std::string half = "1.00000000000000011102230246251565404236316680908203125";
+  std::string texts[] = {
+    half + std::string(1000, '0'),
+    half + std::string(1000, '0') + "1",
+    "0." + std::string(1000, '0') + "1" + std::string(900, '7') + "e1005",
+    std::string(900, '9') + "e-900",
+    "-" + std::string(800, '1') + "." + std::string(800, '2'),
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    double value;
+    ASSERT_TRUE(ParseDouble(texts[i].data(), texts[i].size(), &value)) << texts[i];
+    double expected = strtod(texts[i].c_str(), NULL);
+    EXPECT_EQ(0, memcmp(&expected, &value, sizeof(value))) << texts[i];
+    float f;
+    ASSERT_TRUE(ParseFloat(texts[i].data(), texts[i].size(), &f)) << texts[i];
+    float expected_f = strtof(texts[i].c_str(), NULL);
+    EXPECT_EQ(0, memcmp(&expected_f, &f, sizeof(f))) << texts[i];
+  }
+  double value;
+  ASSERT_TRUE(ParseDouble(texts[0].data(), texts[0].size(), &value));
+  EXPECT_EQ(1.0, value);
+  ASSERT_TRUE(ParseDouble(texts[1].data(), texts[1].size(), &value));
+  EXPECT_EQ(std::nextafter(1.0, 2.0), value);
+}
+
+TEST(ParseFloat, RoundsOnceToFloat) {
+  std::mt19937_64 random(20131229);
+  for (int i = 0; i < 100000; ++i) {
+    char text[64];
+    int size = snprintf(text, sizeof(text), "%llue%d",
+                        static_cast<unsigned long long>(random() >> (random() % 64)),
+                        static_cast<int>(random() % 40) - 20);
+    float value;
+    ASSERT_TRUE(ParseFloat(text, size, &value)) << text;
+    float expected = strtof(text, NULL);
+    ASSERT_EQ(0, memcmp(&expected, &value, sizeof(value))) << text;
+  }
+  // Just above halfway between 1 and the next float; as a double it is
+  // exactly halfway, which would then round down to 1
+  const char* text = "1.00000005960464477539062501";
+  float value;
+  ASSERT_TRUE(ParseFloat(text, strlen(text), &value));
+  EXPECT_EQ(std::nextafter(1.0f, 2.0f), value);
+}
+
+TEST(ParseDouble, RejectsNonJsonNumbers) {
+  const char* texts[] = {
+    "", "-", "+1", "01", "1.", ".5", "1e", "1e+", "0x10", "1,5", "nan", "inf", " 1", "1 ",
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    double d;
+    float f;
+    EXPECT_FALSE(ParseDouble(texts[i], strlen(texts[i]), &d)) << texts[i];
+    EXPECT_FALSE(ParseFloat(texts[i], strlen(texts[i]), &f)) << texts[i];
+  }
+  // The length bounds the number, not a terminator
+  double d;
+  ASSERT_TRUE(ParseDouble("2.5e3,", 5, &d));
+  EXPECT_EQ(2.5e3, d);
+}
+
+}  // namespace pjconv
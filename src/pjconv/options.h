@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-10
+ */
+
+#ifndef PJCONV_OPTIONS_H_
+#define PJCONV_OPTIONS_H_
+
+namespace pjconv {
+
+class ConversionProfiler;
+class Projection;
+
+/**
+ * Options of a single conversion
+ */
+struct ConvertOptions {
+  ConvertOptions()
+      : convert_unset_fields(true), presize_output(false), projection(NULL), profiler(NULL) {
+  }
+
+  /** Whether to convert the unset fields in the protobuf message */
+  bool convert_unset_fields;
+
+  /**
+   * Whether to compute the exact length of compact JSON output first and
+   * reserve it, so the string never grows while it is written. This walks
+   * the message twice, which pays off for large messages.
+   */
+  bool presize_output;
+
+  /**
+   * If not NULL, only the fields it selects are converted; it must be of
+   * the type of the message converted
+   */
+  const Projection* projection;
+
+  /**
+   * If not NULL, the conversion is traced when it samples it, and the cost
+   * of each message type and field is added to it
+   */
+  ConversionProfiler* profiler;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_OPTIONS_H_
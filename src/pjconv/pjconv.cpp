@@ -23,28 +23,63 @@
  * @date		2013-9-15
  */
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <google/protobuf/descriptor.h>
 
 #include "pjconv/pjconv.h"
+#include "pjconv/json_parser.h"
+#include "pjconv/json_writer.h"
+#include "pjconv/plan.h"
+#include "pjconv/profile_trace.h"
+#include "pjconv/stats_scope.h"
+#include "pjconv/thread_pool.h"
+#include "pjconv/wire_json_writer.h"
 
 namespace pjconv {
 
 namespace pb = google::protobuf;
 
-PJConverter::PJConverter() : convert_unset_fields_(true) {
+PJConverter::PJConverter() : plans_(new PlanCache()) {
 }
 
 PJConverter::~PJConverter() {
+  delete plans_;
 }
 
 bool PJConverter::Convert(
     const pb::Message& message,
     Json::Value* json,
     bool convert_unset_fields) const {
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  return Convert(message, json, options);
+}
+
+bool PJConverter::Convert(
+    const pb::Message& message,
+    std::string* json,
+    bool styled,
+    bool convert_unset_fields) const {
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  return Convert(message, json, styled, options);
+}
+
+bool PJConverter::Convert(
+    const pb::Message& message,
+    Json::Value* json,
+    const ConvertOptions& options) const {
   if (!json) return false;
+  StatsScope stats(StatsScope::kToJson);
+  ProfileScope profile(options.profiler, ProfileScope::kToJson);
   json->clear();
-  convert_unset_fields_ = convert_unset_fields;
-  ConvertFromMessage(message, json);
+  const MessagePlan* plan = plans_->Get(message.GetDescriptor(), options.projection);
+  if (!plan) return false;
+  ConvertFromMessage(*plan, message, options, json);
+  stats.Finish(true, 0, 0);
+  profile.Finish(true);
   return true;
 }
 
@@ -52,65 +87,302 @@ bool PJConverter::Convert(
     const pb::Message& message,
     std::string* json,
     bool styled,
-    bool convert_unset_fields) const {
+    const ConvertOptions& options) const {
   if (!json) return false;
+  StatsScope stats(StatsScope::kToJson);
+  ProfileScope profile(options.profiler, ProfileScope::kToJson);
+  if (!styled) {
+    json->clear();
+    if (options.presize_output) json->reserve(ComputeJsonSize(message, options) + 1);
+    JsonWriter writer(plans_, options, json);
+    if (!writer.WriteMessage(message)) return false;
+    // Json::FastWriter terminates the document with a newline
+    json->push_back('\n');
+    stats.Finish(true, 0, json->size());
+    profile.Finish(true);
+    return true;
+  }
   Json::Value value;
-  bool ret = Convert(message, &value, convert_unset_fields);
+  bool ret = Convert(message, &value, options);
   if (ret) {
-    if (styled) {
-      Json::StyledWriter writer;
-      *json = writer.write(value);
-    } else {
-      Json::FastWriter writer;
-      *json = writer.write(value);
-    }
+    Json::StyledWriter writer;
+    *json = writer.write(value);
+    stats.Finish(true, 0, json->size());
   }
+  profile.Finish(ret);
   return ret;
 }
 
+bool PJConverter::Write(
+    const pb::Message& message,
+    std::string* json,
+    const ConvertOptions& options) const {
+  if (!json) return false;
+  StatsScope stats(StatsScope::kToJson);
+  ProfileScope profile(options.profiler, ProfileScope::kToJson);
+  if (options.presize_output) json->reserve(json->size() + ComputeJsonSize(message, options));
+  size_t start = json->size();
+  JsonWriter writer(plans_, options, json);
+  bool ok = writer.WriteMessage(message);
+  stats.Finish(ok, 0, json->size() - start);
+  profile.Finish(ok);
+  return ok;
+}
+
+size_t PJConverter::ComputeJsonSize(const pb::Message& message, const ConvertOptions& options) const {
+  JsonSizer sizer(plans_, options);
+  return sizer.MessageSize(message);
+}
+
+bool PJConverter::Write(
+    const pb::Message& message,
+    pb::io::ZeroCopyOutputStream* output,
+    const ConvertOptions& options) const {
+  if (!output) return false;
+  ZeroCopyStreamSink sink(output);
+  return Write(message, &sink, options);
+}
+
+bool PJConverter::Write(
+    const pb::Message& message,
+    JsonSink* sink,
+    const ConvertOptions& options) const {
+  if (!sink) return false;
+  // The writer counts the bytes it passes to the sink
+  StatsScope stats(StatsScope::kToJson);
+  ProfileScope profile(options.profiler, ProfileScope::kToJson);
+  JsonWriter writer(plans_, options, sink);
+  bool ok = writer.WriteMessage(message);
+  stats.Finish(ok, 0, 0);
+  profile.Finish(ok);
+  return ok;
+}
+
+bool PJConverter::TranscodeToJson(
+    const char* data,
+    size_t size,
+    const pb::Descriptor* type,
+    std::string* json,
+    const ConvertOptions& options) const {
+  if ((!data && size > 0) || !type || !json) return false;
+  StatsScope stats(StatsScope::kToJson);
+  size_t start = json->size();
+  WireJsonWriter writer(plans_, options);
+  bool ok = writer.Write(data, size, type, json);
+  stats.Finish(ok, size, json->size() - start);
+  return ok;
+}
+
 bool PJConverter::Convert(const Json::Value& json, pb::Message* message) const {
+  return Convert(json, message, ConvertOptions());
+}
+
+bool PJConverter::Convert(
+    const Json::Value& json,
+    pb::Message* message,
+    const ConvertOptions& options) const {
   if (!message) return false;
+  StatsScope stats(StatsScope::kFromJson);
+  ProfileScope profile(options.profiler, ProfileScope::kFromJson);
   message->Clear();
-  ConvertToMessage(json, message);
+  const MessagePlan* plan = plans_->Get(message->GetDescriptor(), options.projection);
+  if (!plan) return false;
+  ConvertToMessage(json, *plan, message);
+  stats.Finish(true, 0, 0);
+  profile.Finish(true);
   return true;
 }
 
 bool PJConverter::Convert(const std::string& json, pb::Message* message) const {
-  if (!message) return false;
-  Json::Reader reader;
-  Json::Value value;
-  bool ret = reader.parse(json, value, false);
-  if (ret) {
-    ret = Convert(value, message);
+  return Convert(json.data(), json.size(), message);
+}
+
+bool PJConverter::Convert(const char* json, size_t length, pb::Message* message) const {
+  return Convert(json, length, message, ConvertOptions());
+}
+
+bool PJConverter::Convert(
+    const char* json,
+    size_t length,
+    pb::Message* message,
+    const ConvertOptions& options) const {
+  if (!json || !message) return false;
+  StatsScope stats(StatsScope::kFromJson);
+  ProfileScope profile(options.profiler, ProfileScope::kFromJson);
+  JsonParser parser(plans_);
+  bool ok = parser.Parse(json, length, message, options.projection);
+  stats.Finish(ok, length, 0);
+  profile.Finish(ok);
+  return ok;
+}
+
+bool PJConverter::TranscodeToWire(
+    const char* json,
+    size_t length,
+    const pb::Descriptor* type,
+    std::string* bytes,
+    const ConvertOptions& options) const {
+  if (!json || !type || !bytes) return false;
+  StatsScope stats(StatsScope::kFromJson);
+  size_t start = bytes->size();
+  JsonParser parser(plans_);
+  bool ok = parser.ParseToWire(json, length, type, bytes, options.projection);
+  stats.Finish(ok, length, bytes->size() - start);
+  return ok;
+}
+
+pb::Message* PJConverter::ConvertOnArena(
+    const Json::Value& json,
+    const pb::Message& prototype,
+    pb::Arena* arena,
+    const ConvertOptions& options) const {
+  const MessagePlan* plan = plans_->Get(prototype.GetDescriptor(), options.projection);
+  if (!plan) return NULL;
+  StatsScope stats(StatsScope::kFromJson);
+  ProfileScope profile(options.profiler, ProfileScope::kFromJson);
+  // Reflection allocates submessages and strings on the message's arena
+  pb::Message* message = prototype.New(arena);
+  ConvertToMessage(json, *plan, message);
+  // A Json::Value has no text, so no bytes are read
+  stats.Finish(true, 0, 0);
+  profile.Finish(true);
+  return message;
+}
+
+pb::Message* PJConverter::ConvertOnArena(
+    const char* json,
+    size_t length,
+    const pb::Message& prototype,
+    pb::Arena* arena,
+    const ConvertOptions& options) const {
+  if (!json) return NULL;
+  StatsScope stats(StatsScope::kFromJson);
+  ProfileScope profile(options.profiler, ProfileScope::kFromJson);
+  pb::Message* message = prototype.New(arena);
+  JsonParser parser(plans_);
+  bool ok = parser.Parse(json, length, message, options.projection);
+  stats.Finish(ok, length, 0);
+  profile.Finish(ok);
+  if (!ok) {
+    // Whatever was built stays on the arena until it is freed
+    if (!arena) delete message;
+    return NULL;
   }
-  return ret;
+  return message;
+}
+
+Projection* PJConverter::NewProjection(
+    const pb::Descriptor* type,
+    const std::vector<std::string>& paths) const {
+  if (!type) return NULL;
+  return Projection::Compile(plans_, type, paths);
 }
 
-void PJConverter::ConvertFromMessage(const pb::Message& message, Json::Value* json) const {
-  const pb::Descriptor* desc = message.GetDescriptor();
+bool PJConverter::ConvertBatch(
+    const std::vector<const pb::Message*>& messages,
+    std::vector<std::string>* jsons,
+    ThreadPool* pool,
+    std::vector<char>* succeeded,
+    const ConvertOptions& options) const {
+  if (!jsons || !pool) return false;
+  size_t count = messages.size();
+  jsons->resize(count);
+  std::vector<char> local;
+  std::vector<char>& ok = succeeded ? *succeeded : local;
+  ok.assign(count, 0);
+  // Each item is written to its own slot, so workers share nothing
+  pool->ParallelFor(count, 0, [this, &messages, jsons, &ok, &options](
+      size_t begin, size_t end, int worker) {
+    for (size_t i = begin; i < end; ++i) {
+      ok[i] = messages[i] && Convert(*messages[i], &(*jsons)[i], false, options);
+    }
+  });
+  return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+bool PJConverter::ConvertBatch(
+    const std::vector<std::string>& jsons,
+    const std::vector<pb::Message*>& messages,
+    ThreadPool* pool,
+    std::vector<char>* succeeded) const {
+  if (!pool || jsons.size() != messages.size()) return false;
+  size_t count = jsons.size();
+  std::vector<char> local;
+  std::vector<char>& ok = succeeded ? *succeeded : local;
+  ok.assign(count, 0);
+  // One parser per worker, so its scratch buffers are reused across items
+  std::vector<std::unique_ptr<JsonParser> > parsers(pool->size());
+  for (size_t i = 0; i < parsers.size(); ++i) {
+    parsers[i].reset(new JsonParser(plans_));
+  }
+  pool->ParallelFor(count, 0, [&jsons, &messages, &ok, &parsers](
+      size_t begin, size_t end, int worker) {
+    JsonParser* parser = parsers[worker].get();
+    for (size_t i = begin; i < end; ++i) {
+      StatsScope stats(StatsScope::kFromJson);
+      ok[i] = messages[i] && parser->Parse(jsons[i].data(), jsons[i].size(), messages[i]);
+      stats.Finish(ok[i] != 0, jsons[i].size(), 0);
+    }
+  });
+  return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+void PJConverter::ConvertFromMessage(
+    const MessagePlan& plan,
+    const pb::Message& message,
+    const ConvertOptions& options,
+    Json::Value* json) const {
   const pb::Reflection *ref = message.GetReflection();
+  ProfileTrace* trace = ProfileTrace::Current();
+  if (trace) trace->Enter(plan.descriptor->full_name(), 0);
 
   Json::Value& out = *json;
-  int n = desc->field_count();
-  for (int i = 0; i < n; ++i) {
-    const pb::FieldDescriptor* field = desc->field(i);
-    const std::string& name = field->name();
-    if (field->is_repeated()) {
-      if (ref->FieldSize(message, field) > 0) {
-        ConvertFromRepeatedField(message, ref, field, &out[name]);
+  if (!options.convert_unset_fields && PresentFields::Worthwhile(plan)) {
+    PresentFields present(plan, message);
+    for (size_t i = 0; i < present.size(); ++i) {
+      const FieldPlan& field = present[i];
+      if (trace) trace->Enter(field.field->name(), 0);
+      if (field.repeated) {
+        ConvertFromRepeatedField(message, ref, field, options, &out[field.field->name()]);
+      } else {
+        ConvertFromSingelField(message, ref, field, options, &out[field.field->name()]);
+      }
+      if (trace) trace->Leave(0);
+    }
+    StatsScope::CountFields(present.size());
+    if (trace) trace->Leave(0);
+    return;
+  }
+  size_t fields = 0;
+  for (size_t i = 0; i < plan.fields.size(); ++i) {
+    const FieldPlan& field = plan.fields[i];
+    const std::string& name = field.field->name();
+    if (field.repeated) {
+      if (ref->FieldSize(message, field.field) > 0) {
+        if (trace) trace->Enter(name, 0);
+        ConvertFromRepeatedField(message, ref, field, options, &out[name]);
+        if (trace) trace->Leave(0);
+        ++fields;
       }
-    } else if (convert_unset_fields_ || ref->HasField(message, field)) {
-      ConvertFromSingelField(message, ref, field, &out[name]);
+    } else if (options.convert_unset_fields || ref->HasField(message, field.field)) {
+      if (trace) trace->Enter(name, 0);
+      ConvertFromSingelField(message, ref, field, options, &out[name]);
+      if (trace) trace->Leave(0);
+      ++fields;
     }
   }
+  StatsScope::CountFields(fields);
+  if (trace) trace->Leave(0);
 }
 
 void PJConverter::ConvertFromSingelField(
     const pb::Message& message,
     const pb::Reflection* ref,
-    const pb::FieldDescriptor* field,
+    const FieldPlan& field_plan,
+    const ConvertOptions& options,
     Json::Value* json) const {
-  switch (field->cpp_type()) {
+  const pb::FieldDescriptor* field = field_plan.field;
+  switch (field_plan.cpp_type) {
     case pb::FieldDescriptor::CPPTYPE_INT32:
       *json = ref->GetInt32(message, field);
       break;
@@ -140,7 +412,7 @@ void PJConverter::ConvertFromSingelField(
       break;
     case pb::FieldDescriptor::CPPTYPE_MESSAGE:
       const pb::Message& m = ref->GetMessage(message, field);
-      ConvertFromMessage(m, json);
+      ConvertFromMessage(*field_plan.message, m, options, json);
       break;
   }
 }
@@ -148,10 +420,12 @@ void PJConverter::ConvertFromSingelField(
 void PJConverter::ConvertFromRepeatedField(
     const pb::Message& message,
     const pb::Reflection* ref,
-    const pb::FieldDescriptor* field,
+    const FieldPlan& field_plan,
+    const ConvertOptions& options,
     Json::Value* json) const {
+  const pb::FieldDescriptor* field = field_plan.field;
   int n = ref->FieldSize(message, field);
-  switch (field->cpp_type()) {
+  switch (field_plan.cpp_type) {
     case pb::FieldDescriptor::CPPTYPE_INT32:
       for (int i = 0; i < n; ++i) {
         json->append(ref->GetRepeatedInt32(message, field, i));
@@ -201,34 +475,50 @@ void PJConverter::ConvertFromRepeatedField(
       for (int i = 0; i < n; ++i) {
         const pb::Message& m = ref->GetRepeatedMessage(message, field, i);
         Json::Value value;
-        ConvertFromMessage(m, &value);
+        ConvertFromMessage(*field_plan.message, m, options, &value);
         json->append(value);
       }
       break;
   }
 }
 
-void PJConverter::ConvertToMessage(const Json::Value& json, pb::Message* message) const {
-  const pb::Descriptor* desc = message->GetDescriptor();
+void PJConverter::ConvertToMessage(
+    const Json::Value& json,
+    const MessagePlan& plan,
+    pb::Message* message) const {
   const pb::Reflection *ref = message->GetReflection();
+  ProfileTrace* trace = ProfileTrace::Current();
+  if (trace) trace->Enter(plan.descriptor->full_name(), 0);
+  size_t fields = 0;
+  size_t unknown = 0;
   for (Json::ValueIterator iter = json.begin(); iter != json.end(); ++iter) {
-    const pb::FieldDescriptor* field = desc->FindFieldByName(iter.memberName());
-    if (!field) continue;
-    if (field->label() == pb::FieldDescriptor::LABEL_REPEATED) {
-      ConvertToRepeatedField(*iter, message, desc, ref, field);
+    const char* name = iter.memberName();
+    const FieldPlan* field = plan.Find(name, strlen(name));
+    if (!field) {
+      ++unknown;
+      continue;
+    }
+    ++fields;
+    if (trace) trace->Enter(field->field->name(), 0);
+    if (field->repeated) {
+      ConvertToRepeatedField(*iter, message, ref, *field);
     } else {
-      ConvertToSingleField(*iter, message, desc, ref, field);
+      ConvertToSingleField(*iter, message, ref, *field);
     }
+    if (trace) trace->Leave(0);
   }
+  StatsScope::CountFields(fields);
+  StatsScope::CountUnknownKeys(unknown);
+  if (trace) trace->Leave(0);
 }
 
 void PJConverter::ConvertToSingleField(
     const Json::Value& json,
     pb::Message* message,
-    const pb::Descriptor* desc,
     const pb::Reflection* ref,
-    const pb::FieldDescriptor* field) const {
-  switch (field->cpp_type()) {
+    const FieldPlan& field_plan) const {
+  const pb::FieldDescriptor* field = field_plan.field;
+  switch (field_plan.cpp_type) {
     case pb::FieldDescriptor::CPPTYPE_INT32:
       SetField(json, message, ref, field, &Json::Value::isIntegral, &Json::Value::asInt,
                &pb::Reflection::SetInt32);
@@ -258,14 +548,14 @@ void PJConverter::ConvertToSingleField(
                &pb::Reflection::SetBool);
       break;
     case pb::FieldDescriptor::CPPTYPE_ENUM:
-      SetEnumField(json, message, desc, ref, field, &pb::Reflection::SetEnum);
+      SetEnumField(json, message, ref, field_plan, &pb::Reflection::SetEnum);
       break;
     case pb::FieldDescriptor::CPPTYPE_STRING:
       SetField(json, message, ref, field, &Json::Value::isString, &Json::Value::asString,
                &pb::Reflection::SetString);
       break;
     case pb::FieldDescriptor::CPPTYPE_MESSAGE:
-      ConvertToMessage(json, ref->MutableMessage(message, field));
+      ConvertToMessage(json, *field_plan.message, ref->MutableMessage(message, field));
       break;
   }
 }
@@ -273,10 +563,10 @@ void PJConverter::ConvertToSingleField(
 void PJConverter::ConvertToRepeatedField(
     const Json::Value& json,
     pb::Message* message,
-    const pb::Descriptor* desc,
     const pb::Reflection* ref,
-    const pb::FieldDescriptor* field) const {
-  switch (field->cpp_type()) {
+    const FieldPlan& field_plan) const {
+  const pb::FieldDescriptor* field = field_plan.field;
+  switch (field_plan.cpp_type) {
     case pb::FieldDescriptor::CPPTYPE_INT32:
       for (Json::ValueIterator iter = json.begin(); iter != json.end(); ++iter) {
         SetField(*iter, message, ref, field, &Json::Value::isIntegral, &Json::Value::asInt,
@@ -321,7 +611,7 @@ void PJConverter::ConvertToRepeatedField(
       break;
     case pb::FieldDescriptor::CPPTYPE_ENUM:
       for (Json::ValueIterator iter = json.begin(); iter != json.end(); ++iter) {
-        SetEnumField(*iter, message, desc, ref, field, &pb::Reflection::AddEnum);
+        SetEnumField(*iter, message, ref, field_plan, &pb::Reflection::AddEnum);
       }
       break;
     case pb::FieldDescriptor::CPPTYPE_STRING:
@@ -332,7 +622,7 @@ void PJConverter::ConvertToRepeatedField(
       break;
     case pb::FieldDescriptor::CPPTYPE_MESSAGE:
       for (Json::ValueIterator iter = json.begin(); iter != json.end(); ++iter) {
-        ConvertToMessage(*iter, ref->AddMessage(message, field));
+        ConvertToMessage(*iter, *field_plan.message, ref->AddMessage(message, field));
       }
       break;
   }
@@ -349,6 +639,8 @@ void PJConverter::SetField(
     Setter setter) const {
   if ((json.*checker)()) {
     (ref->*setter)(message, field, (json.*getter)());
+  } else {
+    StatsScope::CountDroppedValue();
   }
 }
 
@@ -356,19 +648,20 @@ template<typename Setter>
 void PJConverter::SetEnumField(
     const Json::Value& json,
     pb::Message* message,
-    const pb::Descriptor* desc,
     const pb::Reflection* ref,
-    const pb::FieldDescriptor* field,
+    const FieldPlan& field_plan,
     Setter setter) const {
-  const pb::EnumDescriptor* enum_desc = desc->FindEnumTypeByName(field->full_name());
-  if (enum_desc) {
-    if (json.isString()) {
-      const pb::EnumValueDescriptor* value = enum_desc->FindValueByName(json.asString());
-      if (value) (ref->*setter)(message, field, value);
-    } else if (json.isIntegral()) {
-      const pb::EnumValueDescriptor* value = enum_desc->FindValueByNumber(json.asInt());
-      if (value) (ref->*setter)(message, field, value);
-    }
+  const pb::EnumValueDescriptor* value = NULL;
+  if (json.isString()) {
+    const char* name = json.asCString();
+    value = field_plan.enums->FindByName(name, strlen(name));
+  } else if (json.isIntegral()) {
+    value = field_plan.enums->FindByNumber(json.asInt());
+  }
+  if (value) {
+    (ref->*setter)(message, field_plan.field, value);
+  } else {
+    StatsScope::CountDroppedValue();
   }
 }
 
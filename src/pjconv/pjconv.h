@@ -27,13 +27,28 @@
 #define PJCONV_PJ_CONVERTER_H_
 
 #include <string>
+#include <vector>
 #include <google/protobuf/message.h>
 #include <json/json.h>
 
+#include "pjconv/json_sink.h"
+#include "pjconv/options.h"
+#include "pjconv/projection.h"
+
 namespace pjconv {
 
+class PlanCache;
+class ThreadPool;
+struct MessagePlan;
+struct FieldPlan;
+
 /**
  * Protobuf and Json Converter
+ *
+ * The converter compiles a conversion plan for each message type on first
+ * use and keeps it, so a long-lived converter converts fastest. All the
+ * Convert methods are thread-safe: one converter can be shared by any
+ * number of threads.
  */
 class PJConverter {
  public:
@@ -68,6 +83,111 @@ class PJConverter {
       bool styled = true,
       bool convert_unset_fields = true) const;
 
+  /**
+   * Convert a protobuf message to a JSON object
+   *
+   * @param message the input protobuf message
+   * @param json the output JSON object
+   * @param options the options of this conversion
+   * @return true if convert successfully
+   */
+  bool Convert(
+      const google::protobuf::Message& message,
+      Json::Value* json,
+      const ConvertOptions& options) const;
+
+  /**
+   * Convert a protobuf message to a JSON string
+   *
+   * @param message the input protobuf message
+   * @param json the output JSON string
+   * @param styled whether to format the output string in a human friendly way
+   * @param options the options of this conversion
+   * @return true if convert successfully
+   */
+  bool Convert(
+      const google::protobuf::Message& message,
+      std::string* json,
+      bool styled,
+      const ConvertOptions& options) const;
+
+  /**
+   * Append a protobuf message to a string as compact JSON text
+   *
+   * Unlike Convert, the string is not cleared and no newline is added, so
+   * one buffer can collect many messages and keep its capacity.
+   *
+   * @param message the input protobuf message
+   * @param json the string the JSON text is appended to
+   * @param options the options of this conversion
+   * @return true if convert successfully
+   */
+  bool Write(
+      const google::protobuf::Message& message,
+      std::string* json,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Compute the exact length of a protobuf message as compact JSON text,
+   * without writing it
+   *
+   * @param message the input protobuf message
+   * @param options the options of the conversion to measure
+   * @return the number of bytes Write appends, which is one less than
+   *     Convert writes with styled set to false
+   */
+  size_t ComputeJsonSize(
+      const google::protobuf::Message& message,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Write a protobuf message to a stream as compact JSON text
+   *
+   * @param message the input protobuf message
+   * @param output the stream the JSON text is written to
+   * @param options the options of this conversion
+   * @return true if convert successfully, false if the stream failed
+   */
+  bool Write(
+      const google::protobuf::Message& message,
+      google::protobuf::io::ZeroCopyOutputStream* output,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Pass a protobuf message as compact JSON text to a sink, in chunks
+   *
+   * @param message the input protobuf message
+   * @param sink the sink the JSON text is passed to
+   * @param options the options of this conversion
+   * @return true if convert successfully, false if the sink stopped it
+   */
+  bool Write(
+      const google::protobuf::Message& message,
+      JsonSink* sink,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Append a serialized protobuf message to a string as compact JSON text,
+   * decoding the wire format directly instead of parsing a Message
+   *
+   * The text is what Write gives for the message the bytes parse into,
+   * except that map entries keep their order on the wire.
+   *
+   * @param data the serialized message
+   * @param size the length of the serialized message
+   * @param type the type of the message
+   * @param json the string the JSON text is appended to
+   * @param options the options of this conversion
+   * @return true if convert successfully, false if the bytes do not parse
+   *     as a message of the type; the string is then left as it was
+   */
+  bool TranscodeToJson(
+      const char* data,
+      size_t size,
+      const google::protobuf::Descriptor* type,
+      std::string* json,
+      const ConvertOptions& options = ConvertOptions()) const;
+
   /**
    * Convert a JSON object to a protobuf message
    *
@@ -77,45 +197,209 @@ class PJConverter {
    */
   bool Convert(const Json::Value& json, google::protobuf::Message* message) const;
 
+  /**
+   * Convert a JSON object to a protobuf message
+   *
+   * @param json the input JSON object
+   * @param message the output protobuf message
+   * @param options the options of this conversion; under a projection the
+   *     members of the fields it leaves out are skipped
+   * @return true if convert successfully
+   */
+  bool Convert(
+      const Json::Value& json,
+      google::protobuf::Message* message,
+      const ConvertOptions& options) const;
+
   /**
    * Convert a JSON string to a protobuf message
    *
    * @param json the input JSON string
-   * @param message the output protobuf message
+   * @param message the output protobuf message, cleared if the string is not valid JSON
    * @return true if convert successfully
    */
   bool Convert(const std::string& json, google::protobuf::Message* message) const;
 
+  /**
+   * Convert a JSON text to a protobuf message without copying the input
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param message the output protobuf message, cleared if the text is not valid JSON
+   * @return true if convert successfully
+   */
+  bool Convert(const char* json, size_t length, google::protobuf::Message* message) const;
+
+  /**
+   * Convert a JSON text to a protobuf message without copying the input
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param message the output protobuf message, cleared if the text is not valid JSON
+   * @param options the options of this conversion; under a projection the
+   *     members of the fields it leaves out are skipped unread
+   * @return true if convert successfully
+   */
+  bool Convert(
+      const char* json,
+      size_t length,
+      google::protobuf::Message* message,
+      const ConvertOptions& options) const;
+
+  /**
+   * Convert a JSON text to a serialized protobuf message without building
+   * the message
+   *
+   * The bytes are those SerializeToString gives for the message Convert
+   * fills from the same text, and are appended so the string's capacity
+   * can be reused.
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param type the type of the message
+   * @param bytes the string the serialized message is appended to
+   * @param options the options of this conversion
+   * @return true if convert successfully, false if the text is not valid
+   *     JSON or leaves a required field unset; the string is then left as it was
+   */
+  bool TranscodeToWire(
+      const char* json,
+      size_t length,
+      const google::protobuf::Descriptor* type,
+      std::string* bytes,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Convert a JSON object to a new protobuf message on an arena
+   *
+   * The message, its submessages and its strings are all allocated from
+   * the arena and freed with it, which works for generated types and
+   * dynamic messages alike.
+   *
+   * @param json the input JSON object
+   * @param prototype the type of the message, such as its default instance
+   * @param arena the arena owning the new message; if NULL it is allocated
+   *     on the heap and the caller owns it
+   * @param options the options of this conversion; under a projection the
+   *     members of the fields it leaves out are skipped
+   * @return the new message, or NULL if the projection is of another type
+   */
+  google::protobuf::Message* ConvertOnArena(
+      const Json::Value& json,
+      const google::protobuf::Message& prototype,
+      google::protobuf::Arena* arena,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Convert a JSON text to a new protobuf message on an arena
+   *
+   * @param json the input JSON text, which need not be NUL-terminated
+   * @param length the length of the input JSON text
+   * @param prototype the type of the message, such as its default instance
+   * @param arena the arena owning the new message; if NULL it is allocated
+   *     on the heap and the caller owns it
+   * @param options the options of this conversion; under a projection the
+   *     members of the fields it leaves out are skipped
+   * @return the new message, or NULL if the text is not valid JSON or the
+   *     projection is of another type
+   */
+  google::protobuf::Message* ConvertOnArena(
+      const char* json,
+      size_t length,
+      const google::protobuf::Message& prototype,
+      google::protobuf::Arena* arena,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Compile field paths of a message type into a projection, which makes
+   * conversions under it touch only the selected fields
+   *
+   * @param type the message type the paths start from
+   * @param paths the dot-separated field names of each selected field, as
+   *     in a FieldMask, such as "person.phone.number"
+   * @return the new projection, owned by the caller, or NULL if a path does
+   *     not name a field; it must not outlive the converter
+   */
+  Projection* NewProjection(
+      const google::protobuf::Descriptor* type,
+      const std::vector<std::string>& paths) const;
+
+  /**
+   * Convert protobuf messages to JSON strings in parallel
+   *
+   * Each message is written as by Convert(message, json, false, options).
+   *
+   * @param messages the input protobuf messages
+   * @param jsons the output JSON strings, resized to match: jsons[i] holds messages[i]
+   * @param pool the threads to convert on
+   * @param succeeded if not NULL, set to whether each message is converted successfully
+   * @param options the options of the conversions
+   * @return true if every message is converted successfully
+   */
+  bool ConvertBatch(
+      const std::vector<const google::protobuf::Message*>& messages,
+      std::vector<std::string>* jsons,
+      ThreadPool* pool,
+      std::vector<char>* succeeded = NULL,
+      const ConvertOptions& options = ConvertOptions()) const;
+
+  /**
+   * Convert JSON strings to protobuf messages in parallel
+   *
+   * Each string is parsed as by Convert(json, message).
+   *
+   * @param jsons the input JSON strings
+   * @param messages the output protobuf messages, one for each string
+   * @param pool the threads to convert on
+   * @param succeeded if not NULL, set to whether each string is converted successfully
+   * @return true if every string is converted successfully
+   */
+  bool ConvertBatch(
+      const std::vector<std::string>& jsons,
+      const std::vector<google::protobuf::Message*>& messages,
+      ThreadPool* pool,
+      std::vector<char>* succeeded = NULL) const;
+
  private:
-  void ConvertFromMessage(const google::protobuf::Message& message, Json::Value* json) const;
+  PJConverter(const PJConverter&);
+  void operator=(const PJConverter&);
+
+  void ConvertFromMessage(
+      const MessagePlan& plan,
+      const google::protobuf::Message& message,
+      const ConvertOptions& options,
+      Json::Value* json) const;
 
   void ConvertFromSingelField(
       const google::protobuf::Message& message,
       const google::protobuf::Reflection *ref,
-      const google::protobuf::FieldDescriptor* field,
+      const FieldPlan& field,
+      const ConvertOptions& options,
       Json::Value* json) const;
 
   void ConvertFromRepeatedField(
       const google::protobuf::Message& message,
       const google::protobuf::Reflection *ref,
-      const google::protobuf::FieldDescriptor* field,
+      const FieldPlan& field,
+      const ConvertOptions& options,
       Json::Value* json) const;
 
-  void ConvertToMessage(const Json::Value& json, google::protobuf::Message* message) const;
+  void ConvertToMessage(
+      const Json::Value& json,
+      const MessagePlan& plan,
+      google::protobuf::Message* message) const;
 
   void ConvertToSingleField(
       const Json::Value& json,
       google::protobuf::Message* message,
-      const google::protobuf::Descriptor* desc,
       const google::protobuf::Reflection* ref,
-      const google::protobuf::FieldDescriptor* field) const;
+      const FieldPlan& field) const;
 
   void ConvertToRepeatedField(
       const Json::Value& json,
       google::protobuf::Message* message,
-      const google::protobuf::Descriptor* desc,
       const google::protobuf::Reflection* ref,
-      const google::protobuf::FieldDescriptor* field) const;
+      const FieldPlan& field) const;
 
   template<typename Checker, typename Getter, typename Setter>
   void SetField(
@@ -131,12 +415,11 @@ class PJConverter {
   void SetEnumField(
       const Json::Value& json,
       google::protobuf::Message* message,
-      const google::protobuf::Descriptor* desc,
       const google::protobuf::Reflection* ref,
-      const google::protobuf::FieldDescriptor* field,
+      const FieldPlan& field,
       Setter setter) const;
 
-  mutable bool convert_unset_fields_;
+  PlanCache* plans_;
 };
 
 }  // namespace pjconv
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-02
+ *
+ * Measures the throughput of each conversion over corpora of different
+ * shapes, next to the JSON conversions of protobuf itself:
+ *
+ *   deep     a message nested 64 levels deep
+ *   wide     a message with 256 fields of every type, all set
+ *   numbers  a message with 100000 repeated integers and doubles
+ *   strings  a message with 16 strings of 64KB, a few characters escaped
+ *   small    1000 small generated messages
+ *
+ * Usage: pjconv_bench [--benchmark_filter=<regex>] [google benchmark flags]
+ *
+ * Each benchmark is named <conversion>/<corpus>; the Protobuf conversions
+ * are util::MessageToJsonString and util::JsonStringToMessage, and
+ * ToString/<corpus>/stats and FromString/<corpus>/stats run with the
+ * conversion statistics counted, which the others leave stopped. Like those,
+ * the conversions to JSON leave out unset fields, which also keeps them from
+ * following the recursive type of deep without end. Bytes per second count
+ * the compact JSON text of the corpus.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/util/json_util.h>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/stats.h"
+#include "pjconv/proto/addressbook.pb.h"
+
+namespace {
+
+namespace pb = google::protobuf;
+
+const int kDepth = 64;
+const int kWideFields = 256;
+const int kNumbers = 100000;
+const int kStrings = 16;
+const size_t kStringSize = 64 << 10;
+const int kSmallMessages = 1000;
+
+/**
+ * Messages of one shape with their JSON forms, made once
+ */
+struct Corpus {
+  std::string name;
+  std::vector<const pb::Message*> messages;
+  std::vector<std::string> jsons;
+  std::vector<Json::Value> values;
+  /** The text protobuf writes, which it parses back */
+  std::vector<std::string> protobuf_jsons;
+  size_t bytes;
+};
+
+void AddField(pb::DescriptorProto* message, const std::string& name, int number,
+              pb::FieldDescriptorProto::Type type, pb::FieldDescriptorProto::Label label,
+              const std::string& type_name = std::string()) {
+  pb::FieldDescriptorProto* field = message->add_field();
+  field->set_name(name);
+  field->set_number(number);
+  field->set_type(type);
+  field->set_label(label);
+  if (!type_name.empty()) field->set_type_name(type_name);
+}
+
+/**
+ * The types of the corpora other than small, which have no generated code
+ */
+const pb::FileDescriptor* BuildFile(pb::DescriptorPool* pool) {
+  pb::FileDescriptorProto file;
+  file.set_name("pjconv_bench.proto");
+  file.set_package("bench");
+  pb::EnumDescriptorProto* color = file.add_enum_type();
+  color->set_name("Color");
+  const char* colors[] = {"RED", "GREEN", "BLUE"};
+  for (int i = 0; i < 3; ++i) {
+    color->add_value()->set_name(colors[i]);
+    color->mutable_value(i)->set_number(i);
+  }
+
+  pb::DescriptorProto* node = file.add_message_type();
+  node->set_name("Node");
+  AddField(node, "value", 1, pb::FieldDescriptorProto::TYPE_INT32,
+           pb::FieldDescriptorProto::LABEL_OPTIONAL);
+  AddField(node, "label", 2, pb::FieldDescriptorProto::TYPE_STRING,
+           pb::FieldDescriptorProto::LABEL_OPTIONAL);
+  AddField(node, "child", 3, pb::FieldDescriptorProto::TYPE_MESSAGE,
+           pb::FieldDescriptorProto::LABEL_OPTIONAL, ".bench.Node");
+
+  // The wide message cycles through the field types
+  const pb::FieldDescriptorProto::Type types[] = {
+    pb::FieldDescriptorProto::TYPE_INT32, pb::FieldDescriptorProto::TYPE_INT64,
+    pb::FieldDescriptorProto::TYPE_UINT32, pb::FieldDescriptorProto::TYPE_DOUBLE,
+    pb::FieldDescriptorProto::TYPE_FLOAT, pb::FieldDescriptorProto::TYPE_BOOL,
+    pb::FieldDescriptorProto::TYPE_STRING, pb::FieldDescriptorProto::TYPE_ENUM,
+  };
+  const int type_count = sizeof(types) / sizeof(types[0]);
+  pb::DescriptorProto* wide = file.add_message_type();
+  wide->set_name("Wide");
+  for (int i = 0; i < kWideFields; ++i) {
+    pb::FieldDescriptorProto::Type type = types[i % type_count];
+    AddField(wide, "field_" + std::to_string(i), i + 1, type,
+             pb::FieldDescriptorProto::LABEL_OPTIONAL,
+             type == pb::FieldDescriptorProto::TYPE_ENUM ? ".bench.Color" : "");
+  }
+
+  pb::DescriptorProto* numbers = file.add_message_type();
+  numbers->set_name("Numbers");
+  AddField(numbers, "ints", 1, pb::FieldDescriptorProto::TYPE_INT64,
+           pb::FieldDescriptorProto::LABEL_REPEATED);
+  AddField(numbers, "doubles", 2, pb::FieldDescriptorProto::TYPE_DOUBLE,
+           pb::FieldDescriptorProto::LABEL_REPEATED);
+
+  pb::DescriptorProto* strings = file.add_message_type();
+  strings->set_name("Strings");
+  AddField(strings, "text", 1, pb::FieldDescriptorProto::TYPE_STRING,
+           pb::FieldDescriptorProto::LABEL_REPEATED);
+
+  return pool->BuildFile(file);
+}
+
+pb::Message* BuildDeep(const pb::Message& prototype) {
+  pb::Message* root = prototype.New();
+  pb::Message* node = root;
+  for (int i = 0; i < kDepth; ++i) {
+    const pb::Descriptor* desc = node->GetDescriptor();
+    const pb::Reflection* ref = node->GetReflection();
+    ref->SetInt32(node, desc->FindFieldByName("value"), i);
+    ref->SetString(node, desc->FindFieldByName("label"), "level " + std::to_string(i));
+    if (i + 1 < kDepth) node = ref->MutableMessage(node, desc->FindFieldByName("child"));
+  }
+  return root;
+}
+
+pb::Message* BuildWide(const pb::Message& prototype) {
+  pb::Message* message = prototype.New();
+  const pb::Descriptor* desc = message->GetDescriptor();
+  const pb::Reflection* ref = message->GetReflection();
+  for (int i = 0; i < desc->field_count(); ++i) {
+    const pb::FieldDescriptor* field = desc->field(i);
+    switch (field->cpp_type()) {
+      case pb::FieldDescriptor::CPPTYPE_INT32:
+        ref->SetInt32(message, field, -i * 1000);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_INT64:
+        ref->SetInt64(message, field, i * 1000000007LL);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_UINT32:
+        ref->SetUInt32(message, field, i * 7u);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+        ref->SetDouble(message, field, i / 3.0);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_FLOAT:
+        ref->SetFloat(message, field, i * 0.25f);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_BOOL:
+        ref->SetBool(message, field, i % 2 == 0);
+        break;
+      case pb::FieldDescriptor::CPPTYPE_STRING:
+        ref->SetString(message, field, "value of " + field->name());
+        break;
+      case pb::FieldDescriptor::CPPTYPE_ENUM:
+        ref->SetEnum(message, field, field->enum_type()->value(i % 3));
+        break;
+      default:
+        break;
+    }
+  }
+  return message;
+}
+
+pb::Message* BuildNumbers(const pb::Message& prototype) {
+  pb::Message* message = prototype.New();
+  const pb::Descriptor* desc = message->GetDescriptor();
+  const pb::Reflection* ref = message->GetReflection();
+  const pb::FieldDescriptor* ints = desc->FindFieldByName("ints");
+  const pb::FieldDescriptor* doubles = desc->FindFieldByName("doubles");
+  unsigned long long x = 88172645463325252ULL;
+  for (int i = 0; i < kNumbers; ++i) {
+    // xorshift, for numbers of every length
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    ref->AddInt64(message, ints, static_cast<long long>(x) >> (x % 48));
+    ref->AddDouble(message, doubles, static_cast<double>(x >> 11) / (1ULL << 40));
+  }
+  return message;
+}
+
+pb::Message* BuildStrings(const pb::Message& prototype) {
+  pb::Message* message = prototype.New();
+  const pb::FieldDescriptor* text = message->GetDescriptor()->FindFieldByName("text");
+  for (int i = 0; i < kStrings; ++i) {
+    std::string value;
+    value.reserve(kStringSize);
+    for (int sentence = 0; value.size() < kStringSize; ++sentence) {
+      value += "The quick brown fox jumps over the lazy dog. ";
+      // One in eight sentences has characters to escape
+      if (sentence % 8 == 0) value += "\"quoted\"\tand\n";
+    }
+    message->GetReflection()->AddString(message, text, value);
+  }
+  return message;
+}
+
+void BuildSmall(std::vector<std::unique_ptr<pb::Message> >* messages) {
+  for (int i = 0; i < kSmallMessages; ++i) {
+    tutorial::Person* person = new tutorial::Person();
+    messages->push_back(std::unique_ptr<pb::Message>(person));
+    person->set_name("person " + std::to_string(i));
+    person->set_id(i);
+    if (i % 2 == 0) person->set_email("person@example.com");
+    tutorial::Person::PhoneNumber* phone = person->add_phone();
+    phone->set_number(std::to_string(10000 + i));
+    phone->set_type(tutorial::Person::HOME);
+  }
+}
+
+Corpus MakeCorpus(const pjconv::PJConverter& conv, const std::string& name,
+                  const std::vector<std::unique_ptr<pb::Message> >& owned) {
+  Corpus corpus;
+  corpus.name = name;
+  for (size_t i = 0; i < owned.size(); ++i) {
+    corpus.messages.push_back(owned[i].get());
+  }
+  const std::vector<const pb::Message*>& messages = corpus.messages;
+  corpus.bytes = 0;
+  for (size_t i = 0; i < messages.size(); ++i) {
+    std::string json;
+    Json::Value value;
+    std::string protobuf_json;
+    conv.Convert(*messages[i], &json, false, false);
+    conv.Convert(*messages[i], &value, false);
+    pb::util::MessageToJsonString(*messages[i], &protobuf_json);
+    corpus.bytes += json.size();
+    corpus.jsons.push_back(json);
+    corpus.values.push_back(value);
+    corpus.protobuf_jsons.push_back(protobuf_json);
+  }
+  return corpus;
+}
+
+void Finish(benchmark::State& state, const Corpus& corpus) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * corpus.bytes));
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * corpus.messages.size()));
+}
+
+void ToString(benchmark::State& state, const pjconv::PJConverter* conv, const Corpus* corpus) {
+  std::string json;
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->messages.size(); ++i) {
+      conv->Convert(*corpus->messages[i], &json, false, false);
+      benchmark::DoNotOptimize(json.data());
+    }
+  }
+  Finish(state, *corpus);
+}
+
+void ToValue(benchmark::State& state, const pjconv::PJConverter* conv, const Corpus* corpus) {
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->messages.size(); ++i) {
+      Json::Value value;
+      conv->Convert(*corpus->messages[i], &value, false);
+      benchmark::DoNotOptimize(&value);
+    }
+  }
+  Finish(state, *corpus);
+}
+
+void FromString(benchmark::State& state, const pjconv::PJConverter* conv, const Corpus* corpus) {
+  std::unique_ptr<pb::Message> message(corpus->messages[0]->New());
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->jsons.size(); ++i) {
+      conv->Convert(corpus->jsons[i], message.get());
+      benchmark::DoNotOptimize(message.get());
+    }
+  }
+  Finish(state, *corpus);
+}
+
+void FromValue(benchmark::State& state, const pjconv::PJConverter* conv, const Corpus* corpus) {
+  std::unique_ptr<pb::Message> message(corpus->messages[0]->New());
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->values.size(); ++i) {
+      conv->Convert(corpus->values[i], message.get());
+      benchmark::DoNotOptimize(message.get());
+    }
+  }
+  Finish(state, *corpus);
+}
+
+typedef void (*Conversion)(benchmark::State& state, const pjconv::PJConverter* conv,
+                           const Corpus* corpus);
+
+/**
+ * Run a conversion with the conversion statistics counted
+ */
+void WithStats(benchmark::State& state, Conversion conversion, const pjconv::PJConverter* conv,
+               const Corpus* corpus) {
+  pjconv::SetConversionStatsEnabled(true);
+  conversion(state, conv, corpus);
+  pjconv::SetConversionStatsEnabled(false);
+}
+
+void ProtobufToString(benchmark::State& state, const Corpus* corpus) {
+  std::string json;
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->messages.size(); ++i) {
+      json.clear();
+      pb::util::MessageToJsonString(*corpus->messages[i], &json);
+      benchmark::DoNotOptimize(json.data());
+    }
+  }
+  Finish(state, *corpus);
+}
+
+void ProtobufFromString(benchmark::State& state, const Corpus* corpus) {
+  std::unique_ptr<pb::Message> message(corpus->messages[0]->New());
+  for (auto _ : state) {
+    for (size_t i = 0; i < corpus->protobuf_jsons.size(); ++i) {
+      pb::util::JsonStringToMessage(corpus->protobuf_jsons[i], message.get());
+      benchmark::DoNotOptimize(message.get());
+    }
+  }
+  Finish(state, *corpus);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* file = BuildFile(&pool);
+  if (!file) return 1;
+  pb::DynamicMessageFactory factory(&pool);
+  pjconv::PJConverter conv;
+  pb::Message* (*builders[])(const pb::Message&) = {
+    BuildDeep, BuildWide, BuildNumbers, BuildStrings,
+  };
+  const char* names[] = {"deep", "wide", "numbers", "strings", "small"};
+  const char* types[] = {"Node", "Wide", "Numbers", "Strings"};
+  std::vector<std::unique_ptr<pb::Message> > owned[5];
+  for (int i = 0; i < 4; ++i) {
+    const pb::Message* prototype = factory.GetPrototype(file->FindMessageTypeByName(types[i]));
+    owned[i].push_back(std::unique_ptr<pb::Message>(builders[i](*prototype)));
+  }
+  BuildSmall(&owned[4]);
+  // The benchmarks keep pointers into the corpora, so they are all made first
+  std::vector<Corpus> corpora;
+  for (int i = 0; i < 5; ++i) {
+    corpora.push_back(MakeCorpus(conv, names[i], owned[i]));
+  }
+
+  for (size_t i = 0; i < corpora.size(); ++i) {
+    const Corpus* corpus = &corpora[i];
+    benchmark::RegisterBenchmark(("ToString/" + corpus->name).c_str(), ToString, &conv, corpus);
+    benchmark::RegisterBenchmark(("ToValue/" + corpus->name).c_str(), ToValue, &conv, corpus);
+    benchmark::RegisterBenchmark(("FromString/" + corpus->name).c_str(), FromString, &conv,
+                                 corpus);
+    benchmark::RegisterBenchmark(("FromValue/" + corpus->name).c_str(), FromValue, &conv, corpus);
+    benchmark::RegisterBenchmark(("ToString/" + corpus->name + "/stats").c_str(), WithStats,
+                                 ToString, &conv, corpus);
+    benchmark::RegisterBenchmark(("FromString/" + corpus->name + "/stats").c_str(), WithStats,
+                                 FromString, &conv, corpus);
+    benchmark::RegisterBenchmark(("ProtobufToString/" + corpus->name).c_str(), ProtobufToString,
+                                 corpus);
+    benchmark::RegisterBenchmark(("ProtobufFromString/" + corpus->name).c_str(),
+                                 ProtobufFromString, corpus);
+  }
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
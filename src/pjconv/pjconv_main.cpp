@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-24
+ *
+ *
+ * Converts files of newline-delimited JSON to length-delimited protobuf
+ * records and back, and makes random records for load and benchmark data.
+ *
+ * Usage: pjconv --descriptor_set=FILE --type=NAME [--mode=json2pb|pb2json]
+ *               [--input=FILE] [--output=FILE] [--threads=N]
+ *               [--convert_unset_fields=true|false]
+ *        pjconv --descriptor_set=FILE --type=NAME --mode=generate [--count=N]
+ *               [--seed=N] [--density=P] [--max_depth=N] [--output=FILE]
+ *
+ * The descriptor set is the output of protoc --include_imports
+ * --descriptor_set_out. Each protobuf record is its size as a varint
+ * followed by the message, as written by writeDelimitedTo in Java. The
+ * input is memory-mapped and cut into chunks at record boundaries; the
+ * chunks are converted in parallel and written in input order. Protobuf
+ * records read from stdin are streamed through a StreamConverter instead,
+ * so a pipe of any length converts in constant memory. pb2json leaves out
+ * the fields that are not set unless --convert_unset_fields=true, so that
+ * a record converted to JSON and back has the bytes it started with.
+ *
+ * The generate mode writes count records filled by a MessageGenerator;
+ * the same seed gives the same records.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/descriptor_database.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include "pjconv/message_generator.h"
+#include "pjconv/pjconv.h"
+#include "pjconv/stream_converter.h"
+#include "pjconv/thread_pool.h"
+#include "pjconv/wire_format.h"
+
+namespace {
+
+namespace pb = google::protobuf;
+
+// The input converted at a time is about kChunkSize times kChunksPerThread
+// times the number of threads, so memory use does not grow with the input
+const size_t kChunkSize = 1 << 20;
+const size_t kChunksPerThread = 4;
+// Report at most this many bad records
+const int kMaxErrors = 10;
+
+struct Flags {
+  Flags() : mode("json2pb"), input("-"), output("-"), threads(0), count(1000) {
+    convert.convert_unset_fields = false;
+  }
+
+  std::string descriptor_set;
+  std::string type;
+  std::string mode;
+  std::string input;
+  std::string output;
+  int threads;
+  /** The options of pb2json */
+  pjconv::ConvertOptions convert;
+  /** The number of records to generate */
+  long count;
+  pjconv::GeneratorOptions generator;
+};
+
+void Usage(const char* argv0) {
+  fprintf(stderr, "Usage: %s --descriptor_set=FILE --type=NAME [--mode=json2pb|pb2json]\n"
+          "          [--input=FILE] [--output=FILE] [--threads=N]\n"
+          "          [--convert_unset_fields=true|false]\n"
+          "       %s --descriptor_set=FILE --type=NAME --mode=generate [--count=N]\n"
+          "          [--seed=N] [--density=P] [--max_depth=N] [--output=FILE]\n", argv0, argv0);
+}
+
+bool ParseFlags(int argc, char** argv, Flags* flags) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* eq = strchr(arg, '=');
+    if (strncmp(arg, "--", 2) != 0 || !eq) return false;
+    std::string name(arg + 2, eq);
+    std::string value(eq + 1);
+    if (name == "descriptor_set") {
+      flags->descriptor_set = value;
+    } else if (name == "type") {
+      flags->type = value;
+    } else if (name == "mode") {
+      flags->mode = value;
+    } else if (name == "input") {
+      flags->input = value;
+    } else if (name == "output") {
+      flags->output = value;
+    } else if (name == "threads") {
+      flags->threads = atoi(value.c_str());
+    } else if (name == "convert_unset_fields") {
+      if (value != "true" && value != "false") return false;
+      flags->convert.convert_unset_fields = value == "true";
+    } else if (name == "count") {
+      flags->count = atol(value.c_str());
+    } else if (name == "seed") {
+      flags->generator.seed = strtoull(value.c_str(), NULL, 10);
+    } else if (name == "density") {
+      flags->generator.field_density = atof(value.c_str());
+    } else if (name == "max_depth") {
+      flags->generator.max_depth = atoi(value.c_str());
+    } else {
+      return false;
+    }
+  }
+  return !flags->descriptor_set.empty() && !flags->type.empty() &&
+      (flags->mode == "json2pb" || flags->mode == "pb2json" || flags->mode == "generate") &&
+      flags->count >= 0;
+}
+
+/**
+ * The whole input, memory-mapped if it is a regular file
+ */
+class Input {
+ public:
+  Input() : data_(NULL), size_(0), mapped_(false) {
+  }
+
+  ~Input() {
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+  }
+
+  bool Open(const std::string& path) {
+    if (path == "-") return Read(std::cin);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      return false;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+      close(fd);
+      std::ifstream in(path.c_str(), std::ios::binary);
+      return in && Read(in);
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+    size_ = st.st_size;
+    mapped_ = true;
+    return true;
+  }
+
+  const char* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  Input(const Input&);
+  void operator=(const Input&);
+
+  bool Read(std::istream& in) {
+    buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return !in.bad();
+  }
+
+  const char* data_;
+  size_t size_;
+  bool mapped_;
+  std::string buffer_;
+};
+
+const pb::Descriptor* LoadType(const std::string& path, const std::string& type,
+                               pb::SimpleDescriptorDatabase* database,
+                               std::unique_ptr<pb::DescriptorPool>* pool) {
+  std::ifstream in(path.c_str(), std::ios::binary);
+  pb::FileDescriptorSet files;
+  if (!in || !files.ParseFromIstream(&in)) {
+    fprintf(stderr, "Failed to read the descriptor set %s\n", path.c_str());
+    return NULL;
+  }
+  for (int i = 0; i < files.file_size(); ++i) {
+    if (!database->Add(files.file(i))) return NULL;
+  }
+  // The pool builds the files on demand, so their order does not matter
+  pool->reset(new pb::DescriptorPool(database));
+  const pb::Descriptor* desc = (*pool)->FindMessageTypeByName(type);
+  if (!desc) {
+    fprintf(stderr, "No message type %s in %s\n", type.c_str(), path.c_str());
+  }
+  return desc;
+}
+
+bool IsBlank(const char* begin, const char* end) {
+  for (; begin < end; ++begin) {
+    if (!isspace(static_cast<unsigned char>(*begin))) return false;
+  }
+  return true;
+}
+
+/**
+ * A run of whole input records and what they convert to
+ */
+struct Chunk {
+  const char* begin;
+  const char* end;
+  std::string output;
+  int failures;
+  /** The input offset of the first bad record */
+  size_t first_failure;
+};
+
+// Cut the input after *pos into at most max_chunks chunks of whole records;
+// return false if a protobuf record is truncated
+bool Cut(const Input& input, bool json, size_t max_chunks, const char** pos,
+         std::vector<Chunk>* chunks) {
+  const char* end = input.data() + input.size();
+  chunks->clear();
+  while (*pos < end && chunks->size() < max_chunks) {
+    Chunk chunk;
+    chunk.begin = *pos;
+    if (json) {
+      // Cut after the first newline past the chunk size
+      chunk.end = static_cast<size_t>(end - *pos) > kChunkSize ? *pos + kChunkSize : end;
+      const char* newline = static_cast<const char*>(memchr(chunk.end, '\n', end - chunk.end));
+      chunk.end = newline ? newline + 1 : end;
+    } else {
+      const char* p = *pos;
+      while (p < end && static_cast<size_t>(p - *pos) < kChunkSize) {
+        const char* record = p;
+        pb::uint64 size;
+        if (!pjconv::ReadVarint(&p, end, &size) || size > static_cast<pb::uint64>(end - p)) {
+          fprintf(stderr, "Truncated record at offset %zu\n",
+                  static_cast<size_t>(record - input.data()));
+          return false;
+        }
+        p += size;
+      }
+      chunk.end = p;
+    }
+    *pos = chunk.end;
+    chunks->push_back(chunk);
+  }
+  return true;
+}
+
+void Fail(size_t offset, Chunk* chunk) {
+  if (chunk->failures++ == 0) chunk->first_failure = offset;
+}
+
+void JsonToPb(const pjconv::PJConverter& conv, const char* base, Chunk* chunk,
+              const pb::Descriptor* type, std::string* bytes) {
+  const char* line = chunk->begin;
+  while (line < chunk->end) {
+    const char* newline = static_cast<const char*>(memchr(line, '\n', chunk->end - line));
+    const char* line_end = newline ? newline : chunk->end;
+    if (!IsBlank(line, line_end)) {
+      bytes->clear();
+      if (conv.TranscodeToWire(line, line_end - line, type, bytes)) {
+        pjconv::AppendVarint(bytes->size(), &chunk->output);
+        chunk->output.append(*bytes);
+      } else {
+        Fail(line - base, chunk);
+      }
+    }
+    line = newline ? newline + 1 : chunk->end;
+  }
+}
+
+void PbToJson(const pjconv::PJConverter& conv, const char* base, Chunk* chunk,
+              const pb::Descriptor* type, const pjconv::ConvertOptions& options) {
+  const char* p = chunk->begin;
+  while (p < chunk->end) {
+    const char* record = p;
+    pb::uint64 size = 0;
+    // Cut has checked the framing
+    pjconv::ReadVarint(&p, chunk->end, &size);
+    if (conv.TranscodeToJson(p, size, type, &chunk->output, options)) {
+      chunk->output.push_back('\n');
+    } else {
+      Fail(record - base, chunk);
+    }
+    p += size;
+  }
+}
+
+int StreamPbToJson(const pb::Message& prototype, const Flags& flags, FILE* out) {
+  pjconv::PJConverter conv;
+  pjconv::StreamOptions options;
+  options.workers = flags.threads;
+  options.convert = flags.convert;
+  pjconv::StreamConverter converter(conv, prototype, options);
+  pb::io::FileInputStream input(STDIN_FILENO);
+  pb::io::FileOutputStream output(fileno(out));
+  pjconv::StreamStats stats;
+  bool ok = converter.Convert(&input, &output, &stats);
+  if (!output.Close()) {
+    fprintf(stderr, "Failed to write %s: %s\n", flags.output.c_str(), strerror(output.GetErrno()));
+    return 1;
+  }
+  if (stats.failures > 0) {
+    fprintf(stderr, "%zu records failed to convert\n", stats.failures);
+  } else if (!ok) {
+    fprintf(stderr, "Truncated record after %zu records\n", stats.records);
+  }
+  return ok ? 0 : 1;
+}
+
+int Generate(const pb::Message& prototype, const Flags& flags, FILE* out) {
+  pjconv::MessageGenerator generator(flags.generator);
+  pb::io::FileOutputStream output(fileno(out));
+  bool ok = generator.WriteDelimited(prototype, flags.count, &output);
+  if (!output.Close() || !ok) {
+    fprintf(stderr, "Failed to write %s: %s\n", flags.output.c_str(), strerror(output.GetErrno()));
+    return 1;
+  }
+  return 0;
+}
+
+bool Write(FILE* out, const std::string& data) {
+  return data.empty() || fwrite(data.data(), 1, data.size(), out) == data.size();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Flags flags;
+  if (!ParseFlags(argc, argv, &flags)) {
+    Usage(argv[0]);
+    return 2;
+  }
+  bool json2pb = flags.mode == "json2pb";
+
+  pb::SimpleDescriptorDatabase database;
+  std::unique_ptr<pb::DescriptorPool> pool;
+  const pb::Descriptor* desc = LoadType(flags.descriptor_set, flags.type, &database, &pool);
+  if (!desc) return 1;
+  pb::DynamicMessageFactory factory(pool.get());
+  const pb::Message* prototype = factory.GetPrototype(desc);
+
+  FILE* out = flags.output == "-" ? stdout : fopen(flags.output.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "Failed to open %s: %s\n", flags.output.c_str(), strerror(errno));
+    return 1;
+  }
+  if (flags.mode == "generate") {
+    return Generate(*prototype, flags, out);
+  }
+  if (!json2pb && flags.input == "-") {
+    return StreamPbToJson(*prototype, flags, out);
+  }
+  Input input;
+  if (!input.Open(flags.input)) {
+    fprintf(stderr, "Failed to read %s: %s\n", flags.input.c_str(), strerror(errno));
+    return 1;
+  }
+
+  pjconv::PJConverter conv;
+  pjconv::ThreadPool threads(flags.threads);
+  // One scratch string per worker
+  std::vector<std::string> scratch(threads.size());
+
+  const char* pos = input.data();
+  std::vector<Chunk> chunks;
+  int failures = 0;
+  bool ok = true;
+  while (ok && pos < input.data() + input.size()) {
+    if (!Cut(input, json2pb, kChunksPerThread * threads.size(), &pos, &chunks)) {
+      ok = false;
+      break;
+    }
+    threads.ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end, int worker) {
+      for (size_t i = begin; i < end; ++i) {
+        Chunk* chunk = &chunks[i];
+        chunk->failures = 0;
+        if (json2pb) {
+          JsonToPb(conv, input.data(), chunk, desc, &scratch[worker]);
+        } else {
+          PbToJson(conv, input.data(), chunk, desc, flags.convert);
+        }
+      }
+    });
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      if (chunks[i].failures > 0 && failures < kMaxErrors) {
+        fprintf(stderr, "Failed to convert the record at offset %zu\n", chunks[i].first_failure);
+      }
+      failures += chunks[i].failures;
+      if (!Write(out, chunks[i].output)) {
+        fprintf(stderr, "Failed to write %s: %s\n", flags.output.c_str(), strerror(errno));
+        ok = false;
+        break;
+      }
+    }
+  }
+  if (fflush(out) != 0 || (out != stdout && fclose(out) != 0)) ok = false;
+  if (failures > 0) {
+    fprintf(stderr, "%d records failed to convert\n", failures);
+  }
+  return ok && failures == 0 ? 0 : 1;
+}
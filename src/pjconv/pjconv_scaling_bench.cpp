@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-10
+ *
+ * Measures how the throughput of one shared PJConverter scales with the
+ * number of threads, both with threads calling Convert and with ConvertBatch
+ * on a ThreadPool.
+ *
+ * Usage: pjconv_scaling_bench [iterations-per-thread] [max-threads]
+ *
+ * The batches hold as many messages as a thread makes iterations.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/thread_pool.h"
+#include "pjconv/proto/addressbook.pb.h"
+
+namespace {
+
+void Build(tutorial::AddressBook* ab) {
+  for (int i = 0; i < 10; ++i) {
+    tutorial::Person* person = ab->add_person();
+    person->set_name("person");
+    person->set_id(i);
+    person->set_email("person@example.com");
+    tutorial::Person::PhoneNumber* number = person->add_phone();
+    number->set_number("10000");
+    number->set_type(tutorial::Person::HOME);
+  }
+}
+
+// Convert to a JSON string and back with every thread; return conversions per second
+double Run(const pjconv::PJConverter& conv, const tutorial::AddressBook& ab,
+           int threads, int iterations) {
+  std::atomic<bool> go(false);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.push_back(std::thread([&conv, &ab, &go, &failures, iterations]() {
+      std::string json;
+      tutorial::AddressBook ab2;
+      while (!go.load()) {
+      }
+      for (int i = 0; i < iterations; ++i) {
+        if (!conv.Convert(ab, &json, false) || !conv.Convert(json, &ab2)) {
+          ++failures;
+        }
+      }
+    }));
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  go.store(true);
+  for (int t = 0; t < threads; ++t) {
+    workers[t].join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (failures.load() > 0) {
+    fprintf(stderr, "%d conversions failed\n", failures.load());
+    exit(1);
+  }
+  return 2.0 * threads * iterations / elapsed.count();
+}
+
+// Convert a batch to JSON strings and back on a pool; return conversions per second
+double RunBatch(const pjconv::PJConverter& conv, const tutorial::AddressBook& ab,
+                int threads, int count) {
+  pjconv::ThreadPool pool(threads);
+  std::vector<tutorial::AddressBook> books(count, ab);
+  std::vector<const google::protobuf::Message*> inputs(count);
+  std::vector<google::protobuf::Message*> outputs(count);
+  for (int i = 0; i < count; ++i) {
+    inputs[i] = &books[i];
+    outputs[i] = &books[i];
+  }
+  std::vector<std::string> jsons;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool ok = conv.ConvertBatch(inputs, &jsons, &pool) && conv.ConvertBatch(jsons, outputs, &pool);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (!ok) {
+    fprintf(stderr, "batch conversion failed\n");
+    exit(1);
+  }
+  return 2.0 * count / elapsed.count();
+}
+
+void Report(const char* title, int max_threads, std::function<double(int)> run) {
+  printf("%s\n%8s %16s %10s %11s\n", title, "threads", "conversions/s", "speedup",
+         "efficiency");
+  double base = 0;
+  for (int threads = 1; threads <= max_threads; threads = threads < max_threads ?
+       std::min(threads * 2, max_threads) : max_threads + 1) {
+    double rate = run(threads);
+    if (threads == 1) base = rate;
+    printf("%8d %16.0f %10.2f %10.1f%%\n", threads, rate, rate / base,
+           100.0 * rate / base / threads);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+  int max_threads = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+  if (iterations <= 0 || max_threads <= 0) {
+    fprintf(stderr, "Usage: %s [iterations-per-thread] [max-threads]\n", argv[0]);
+    return 1;
+  }
+
+  pjconv::PJConverter conv;
+  tutorial::AddressBook ab;
+  Build(&ab);
+  // Compile the plans outside of the measurements
+  Run(conv, ab, 1, 100);
+
+  Report("Convert on each thread", max_threads, [&](int threads) {
+    return Run(conv, ab, threads, iterations);
+  });
+  Report("ConvertBatch", max_threads, [&](int threads) {
+    return RunBatch(conv, ab, threads, iterations);
+  });
+  return 0;
+}
@@ -23,9 +23,15 @@
  * @date		2013-9-15
  */
 
+#include <memory>
+#include <thread>
+#include <vector>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <gtest/gtest.h>
 
 #include "pjconv/pjconv.h"
+#include "pjconv/test_util.h"
+#include "pjconv/thread_pool.h"
 #include "pjconv/proto/addressbook.pb.h"
 
 namespace pjconv {
@@ -97,5 +103,205 @@ TEST(PJConverter, ConvertBetweenPbAndString) {
   Check(ab2);
 }
 
+TEST(PJConverter, WritesToStringsAndStreams) {
+  PJConverter conv;
+  tutorial::AddressBook ab;
+  Build(&ab);
+  const std::string kCompact = kJsonString.substr(0, kJsonString.size() - 1);
+
+  std::string json = "[";
+  ASSERT_TRUE(conv.Write(ab, &json));
+  json.push_back(',');
+  ASSERT_TRUE(conv.Write(ab, &json));
+  EXPECT_EQ("[" + kCompact + "," + kCompact, json);
+
+  // Small blocks make the text span many stream buffers
+  std::string streamed;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&streamed);
+    ASSERT_TRUE(conv.Write(ab, &string_stream));
+  }
+  EXPECT_EQ(kCompact, streamed);
+
+  char buffer[256];
+  google::protobuf::io::ArrayOutputStream array_stream(buffer, sizeof(buffer), 7);
+  ASSERT_TRUE(conv.Write(ab, &array_stream));
+  EXPECT_EQ(static_cast<google::protobuf::int64>(kCompact.size()), array_stream.ByteCount());
+  EXPECT_EQ(kCompact, std::string(buffer, kCompact.size()));
+
+  // The stream runs out of room
+  google::protobuf::io::ArrayOutputStream small_stream(buffer, 16);
+  EXPECT_FALSE(conv.Write(ab, &small_stream));
+}
+
+TEST(PJConverter, PresizesOutput) {
+  PJConverter conv;
+  tutorial::AddressBook ab;
+  Build(&ab);
+  const std::string kCompact = kJsonString.substr(0, kJsonString.size() - 1);
+  EXPECT_EQ(kCompact.size(), conv.ComputeJsonSize(ab));
+
+  ConvertOptions options;
+  options.presize_output = true;
+  std::string json;
+  ASSERT_TRUE(conv.Convert(ab, &json, false, options));
+  EXPECT_EQ(kJsonString, json);
+  // Reserved once, give or take the library's rounding, and never grown
+  EXPECT_LT(json.capacity(), kJsonString.size() + 16);
+
+  json = "[";
+  ASSERT_TRUE(conv.Write(ab, &json, options));
+  EXPECT_EQ("[" + kCompact, json);
+}
+
+TEST(PJConverter, ConvertsEnumsFromJsonValue) {
+  PJConverter conv;
+  Json::Value json;
+  Json::Reader reader;
+  ASSERT_TRUE(reader.parse("{\"person\":[{\"name\":\"bin3\",\"phone\":["
+                           "{\"type\":\"WORK\"},{\"type\":0},{\"type\":\"PAGER\"},"
+                           "{\"type\":7}]}]}", json));
+  tutorial::AddressBook ab;
+  ASSERT_TRUE(conv.Convert(json, &ab));
+  ASSERT_EQ(1, ab.person_size());
+  ASSERT_EQ(4, ab.person(0).phone_size());
+  EXPECT_EQ(tutorial::Person::WORK, ab.person(0).phone(0).type());
+  EXPECT_EQ(tutorial::Person::MOBILE, ab.person(0).phone(1).type());
+  // Unknown names and numbers leave the field unset
+  EXPECT_FALSE(ab.person(0).phone(2).has_type());
+  EXPECT_FALSE(ab.person(0).phone(3).has_type());
+}
+
+TEST(PJConverter, ConvertsOnArena) {
+  PJConverter conv;
+  tutorial::AddressBook expected;
+  ASSERT_TRUE(conv.Convert(kJsonString, &expected));
+
+  google::protobuf::Arena arena;
+  google::protobuf::Message* message = conv.ConvertOnArena(
+      kJsonString.data(), kJsonString.size(), tutorial::AddressBook::default_instance(), &arena);
+  ASSERT_TRUE(message != NULL);
+  tutorial::AddressBook* ab = dynamic_cast<tutorial::AddressBook*>(message);
+  ASSERT_TRUE(ab != NULL);
+  EXPECT_EQ(&arena, ab->GetArena());
+  EXPECT_EQ(&arena, ab->person(0).phone(1).GetArena());
+  EXPECT_EQ(expected.SerializeAsString(), ab->SerializeAsString());
+
+  Json::Value json;
+  ASSERT_TRUE(conv.Convert(expected, &json));
+  ab = dynamic_cast<tutorial::AddressBook*>(
+      conv.ConvertOnArena(json, tutorial::AddressBook::default_instance(), &arena));
+  ASSERT_TRUE(ab != NULL);
+  EXPECT_EQ(&arena, ab->GetArena());
+  EXPECT_EQ(expected.SerializeAsString(), ab->SerializeAsString());
+
+  EXPECT_TRUE(conv.ConvertOnArena("{\"person\":", 10, expected, &arena) == NULL);
+  EXPECT_TRUE(conv.ConvertOnArena("{]", 2, expected, NULL) == NULL);
+}
+
+TEST(PJConverter, ConvertsDynamicMessagesOnArena) {
+  PJConverter conv;
+  std::unique_ptr<google::protobuf::Message> types(test::NewTypes());
+  test::BuildTypes(types.get());
+  std::string text;
+  ASSERT_TRUE(conv.Convert(*types, &text, false, false));
+
+  google::protobuf::Arena arena;
+  google::protobuf::Message* message =
+      conv.ConvertOnArena(text.data(), text.size(), *types, &arena);
+  ASSERT_TRUE(message != NULL);
+  EXPECT_EQ(&arena, message->GetArena());
+  EXPECT_EQ(types->SerializeAsString(), message->SerializeAsString());
+
+  // Without an arena the caller owns the message
+  std::unique_ptr<google::protobuf::Message> owned(
+      conv.ConvertOnArena(text.data(), text.size(), *types, NULL));
+  ASSERT_TRUE(owned != NULL);
+  EXPECT_TRUE(owned->GetArena() == NULL);
+  EXPECT_EQ(types->SerializeAsString(), owned->SerializeAsString());
+}
+
+TEST(PJConverter, ConvertBatchKeepsOrder) {
+  PJConverter conv;
+  ThreadPool pool(4);
+  const size_t kCount = 1000;
+  std::vector<tutorial::AddressBook> books(kCount);
+  std::vector<const google::protobuf::Message*> inputs(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    Build(&books[i]);
+    books[i].mutable_person(1)->set_id(static_cast<int>(i));
+    inputs[i] = &books[i];
+  }
+  inputs[7] = NULL;
+
+  std::vector<std::string> jsons;
+  std::vector<char> succeeded;
+  EXPECT_FALSE(conv.ConvertBatch(inputs, &jsons, &pool, &succeeded));
+  ASSERT_EQ(kCount, jsons.size());
+  ASSERT_EQ(kCount, succeeded.size());
+  for (size_t i = 0; i < kCount; ++i) {
+    if (i == 7) {
+      EXPECT_FALSE(succeeded[i]);
+      continue;
+    }
+    EXPECT_TRUE(succeeded[i]);
+    std::string json;
+    ASSERT_TRUE(conv.Convert(books[i], &json, false));
+    EXPECT_EQ(json, jsons[i]) << i;
+  }
+
+  jsons[7] = "{\"person\":";
+  std::vector<tutorial::AddressBook> outputs(kCount);
+  std::vector<google::protobuf::Message*> messages(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    messages[i] = &outputs[i];
+  }
+  EXPECT_FALSE(conv.ConvertBatch(jsons, messages, &pool, &succeeded));
+  ASSERT_EQ(kCount, succeeded.size());
+  for (size_t i = 0; i < kCount; ++i) {
+    if (i == 7) {
+      EXPECT_FALSE(succeeded[i]);
+      continue;
+    }
+    ASSERT_TRUE(succeeded[i]) << i;
+    ASSERT_EQ(2, outputs[i].person_size());
+    EXPECT_EQ(static_cast<int>(i), outputs[i].person(1).id());
+  }
+
+  inputs[7] = &books[7];
+  EXPECT_TRUE(conv.ConvertBatch(inputs, &jsons, &pool));
+  EXPECT_TRUE(conv.ConvertBatch(jsons, messages, &pool));
+}
+
+TEST(PJConverter, SharedAcrossThreads) {
+  PJConverter conv;
+  tutorial::AddressBook ab;
+  Build(&ab);
+
+  const int kThreads = 8;
+  std::vector<int> failures(kThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.push_back(std::thread([&conv, &ab, &failures, t]() {
+      // Alternate the options so that a shared setting would be noticed
+      ConvertOptions options;
+      options.convert_unset_fields = t % 2 == 0;
+      const std::string& expected = options.convert_unset_fields ? kJsonString : kJsonString2;
+      for (int i = 0; i < 200; ++i) {
+        std::string json;
+        tutorial::AddressBook ab2;
+        if (!conv.Convert(ab, &json, false, options) || json != expected ||
+            !conv.Convert(json, &ab2) || ab2.person_size() != 2) {
+          ++failures[t];
+        }
+      }
+    }));
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    threads[t].join();
+    EXPECT_EQ(0, failures[t]) << "thread " << t;
+  }
+}
+
 }
   // namespace pjconv
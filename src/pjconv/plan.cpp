@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-03
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "pjconv/plan.h"
+#include "pjconv/projection.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+bool FieldNameLess(const pb::FieldDescriptor* a, const pb::FieldDescriptor* b) {
+  return a->name() < b->name();
+}
+
+// Field and enum value names are identifiers, so quoting needs no escaping
+std::string Quote(const std::string& name) {
+  std::string quoted;
+  quoted.reserve(name.size() + 2);
+  quoted.push_back('"');
+  quoted.append(name);
+  quoted.push_back('"');
+  return quoted;
+}
+
+// Plans with fewer fields are walked field by field
+const size_t kMinListedFields = 16;
+
+/**
+ * The scratch space of PresentFields on one thread
+ */
+struct PresentScratch {
+  PresentScratch() : depth(0) {
+  }
+
+  std::vector<const pb::FieldDescriptor*> listed;
+  /** Owned one by one, so a level stays put while deeper ones are added */
+  std::vector<std::unique_ptr<std::vector<const FieldPlan*> > > levels;
+  size_t depth;
+};
+
+PresentScratch& Scratch() {
+  static thread_local PresentScratch scratch;
+  return scratch;
+}
+
+}  // namespace
+
+size_t HashName(const char* data, size_t size) {
+  // Eight bytes per step; names are short
+  const pb::uint64 kMul = 0x9E3779B97F4A7C15ULL;
+  pb::uint64 hash = size * kMul;
+  for (; size >= 8; data += 8, size -= 8) {
+    pb::uint64 word;
+    memcpy(&word, data, 8);
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 32;
+  }
+  if (size > 0) {
+    pb::uint64 word = 0;
+    memcpy(&word, data, size);
+    hash = (hash ^ word) * kMul;
+    hash ^= hash >> 32;
+  }
+  return static_cast<size_t>(hash);
+}
+
+PresentFields::PresentFields(const MessagePlan& plan, const pb::Message& message) {
+  PresentScratch& scratch = Scratch();
+  if (scratch.depth == scratch.levels.size()) {
+    scratch.levels.push_back(std::unique_ptr<std::vector<const FieldPlan*> >(
+        new std::vector<const FieldPlan*>()));
+  }
+  std::vector<const FieldPlan*>& fields = *scratch.levels[scratch.depth++];
+  fields.clear();
+  scratch.listed.clear();
+  message.GetReflection()->ListFields(message, &scratch.listed);
+  for (size_t i = 0; i < scratch.listed.size(); ++i) {
+    const pb::FieldDescriptor* field = scratch.listed[i];
+    // Plans hold no extensions, and projected plans leave fields out
+    if (field->is_extension()) continue;
+    const FieldPlan* field_plan = plan.by_index[field->index()];
+    if (field_plan) fields.push_back(field_plan);
+  }
+  // The plans of the fields lie in member order in one vector
+  std::sort(fields.begin(), fields.end(), std::less<const FieldPlan*>());
+  fields_ = &fields;
+}
+
+PresentFields::~PresentFields() {
+  --Scratch().depth;
+}
+
+bool PresentFields::Worthwhile(const MessagePlan& plan) {
+  return plan.fields.size() >= kMinListedFields;
+}
+
+void IndexPlan(MessagePlan* plan) {
+  const pb::Descriptor* desc = plan->descriptor;
+  size_t n = plan->fields.size();
+  plan->by_index.assign(desc->field_count(), NULL);
+  plan->required_count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const pb::FieldDescriptor* field = plan->fields[i].field;
+    plan->by_index[field->index()] = &plan->fields[i];
+    if (field->is_required()) ++plan->required_count;
+  }
+  // Index by number when that wastes little space, as for enum values
+  int max_number = 0;
+  for (int i = 0; i < desc->field_count(); ++i) {
+    max_number = std::max(max_number, desc->field(i)->number());
+  }
+  plan->by_number.clear();
+  if (max_number <= std::max(64, 4 * desc->field_count())) {
+    plan->by_number.assign(max_number + 1, NULL);
+    for (size_t i = 0; i < n; ++i) {
+      plan->by_number[plan->fields[i].field->number()] = &plan->fields[i];
+    }
+  }
+  // Field names first so that an alias never hides a real name
+  plan->by_name.Reset(3 * n);
+  for (size_t i = 0; i < n; ++i) {
+    plan->by_name.Insert(plan->fields[i].field->name(), &plan->fields[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    plan->by_name.Insert(plan->fields[i].field->json_name(), &plan->fields[i]);
+    plan->by_name.Insert(plan->fields[i].field->camelcase_name(), &plan->fields[i]);
+  }
+}
+
+PlanCache::PlanTable::PlanTable(size_t capacity)
+    : slots_(capacity), mask_(capacity - 1), size_(0) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots_[i].descriptor.store(NULL, std::memory_order_relaxed);
+    slots_[i].plan.store(NULL, std::memory_order_relaxed);
+  }
+}
+
+void PlanCache::PlanTable::Insert(const pb::Descriptor* desc, const MessagePlan* plan) {
+  for (size_t i = Hash(desc) & mask_;; i = (i + 1) & mask_) {
+    Slot& slot = slots_[i];
+    if (!slot.descriptor.load(std::memory_order_relaxed)) {
+      slot.plan.store(plan, std::memory_order_relaxed);
+      slot.descriptor.store(desc, std::memory_order_release);
+      ++size_;
+      return;
+    }
+  }
+}
+
+void PlanCache::PlanTable::InsertAll(const PlanTable& other) {
+  for (size_t i = 0; i < other.slots_.size(); ++i) {
+    const pb::Descriptor* desc = other.slots_[i].descriptor.load(std::memory_order_relaxed);
+    if (desc) Insert(desc, other.slots_[i].plan.load(std::memory_order_relaxed));
+  }
+}
+
+PlanCache::PlanCache() : plans_(new PlanTable(16)) {
+}
+
+PlanCache::~PlanCache() {
+  delete plans_.load();
+  for (size_t i = 0; i < retired_.size(); ++i) {
+    delete retired_[i];
+  }
+  for (size_t i = 0; i < owned_.size(); ++i) {
+    delete owned_[i];
+  }
+  for (EnumMap::iterator iter = enums_.begin(); iter != enums_.end(); ++iter) {
+    delete iter->second;
+  }
+}
+
+const MessagePlan* PlanCache::Get(const pb::Descriptor* desc, const Projection* projection) {
+  if (!projection) return Get(desc);
+  return projection->descriptor() == desc ? projection->plan() : NULL;
+}
+
+const MessagePlan* PlanCache::Compile(const pb::Descriptor* desc) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  PlanTable* current = plans_.load(std::memory_order_relaxed);
+  const MessagePlan* found = current->Find(desc);
+  if (found) return found;
+
+  // The new plans are only published once they are all complete
+  PlanMap pending;
+  const MessagePlan* plan = Build(desc, &pending);
+  PlanTable* table = current;
+  if (!current->Fits(pending.size())) {
+    size_t capacity = 16;
+    while (capacity < 2 * (current->size() + pending.size())) capacity *= 2;
+    table = new PlanTable(capacity);
+    table->InsertAll(*current);
+  }
+  for (PlanMap::const_iterator iter = pending.begin(); iter != pending.end(); ++iter) {
+    table->Insert(iter->first, iter->second);
+  }
+  if (table != current) {
+    retired_.push_back(current);
+    plans_.store(table, std::memory_order_release);
+  }
+  return plan;
+}
+
+MessagePlan* PlanCache::Build(const pb::Descriptor* desc, PlanMap* pending) {
+  MessagePlan* plan = new MessagePlan();
+  owned_.push_back(plan);
+  // Register before compiling the fields so that recursive types find it
+  (*pending)[desc] = plan;
+  plan->descriptor = desc;
+  const pb::Message* prototype = NULL;
+  plan->generated = FindGeneratedJsonWriter(desc, &prototype);
+  plan->generated_reflection = prototype ? prototype->GetReflection() : NULL;
+
+  int n = desc->field_count();
+  std::vector<const pb::FieldDescriptor*> fields(n);
+  for (int i = 0; i < n; ++i) {
+    fields[i] = desc->field(i);
+  }
+  // Json::Value keeps object members ordered by key
+  std::sort(fields.begin(), fields.end(), FieldNameLess);
+
+  plan->fields.resize(n);
+  for (int i = 0; i < n; ++i) {
+    const pb::FieldDescriptor* field = fields[i];
+    FieldPlan& field_plan = plan->fields[i];
+    field_plan.field = field;
+    field_plan.cpp_type = field->cpp_type();
+    field_plan.repeated = field->is_repeated();
+    field_plan.key = Quote(field->name());
+    field_plan.key.push_back(':');
+    field_plan.enums = NULL;
+    field_plan.message = NULL;
+    if (field_plan.cpp_type == pb::FieldDescriptor::CPPTYPE_ENUM) {
+      field_plan.enums = BuildEnum(field->enum_type());
+    } else if (field_plan.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+      const pb::Descriptor* message_desc = field->message_type();
+      field_plan.message = plans_.load(std::memory_order_relaxed)->Find(message_desc);
+      if (!field_plan.message) {
+        PlanMap::const_iterator iter = pending->find(message_desc);
+        field_plan.message = iter != pending->end() ? iter->second : Build(message_desc, pending);
+      }
+    }
+  }
+  IndexPlan(plan);
+  return plan;
+}
+
+const EnumTable* PlanCache::BuildEnum(const pb::EnumDescriptor* desc) {
+  EnumMap::const_iterator iter = enums_.find(desc);
+  if (iter != enums_.end()) return iter->second;
+  EnumTable* table = new EnumTable();
+  enums_[desc] = table;
+  table->descriptor = desc;
+
+  int n = desc->value_count();
+  table->quoted_names.resize(n);
+  table->by_name.Reset(n);
+  int min = 0;
+  int max = 0;
+  for (int i = 0; i < n; ++i) {
+    const pb::EnumValueDescriptor* value = desc->value(i);
+    table->quoted_names[i] = Quote(value->name());
+    table->by_name.Insert(value->name(), value);
+    if (i == 0 || value->number() < min) min = value->number();
+    if (i == 0 || value->number() > max) max = value->number();
+  }
+
+  // Index by number when that wastes little space; aliases keep the first value
+  table->min_number = min;
+  pb::int64 range = static_cast<pb::int64>(max) - min + 1;
+  if (n > 0 && range <= std::max(64, 4 * n)) {
+    table->by_number.assign(range, NULL);
+    for (int i = 0; i < n; ++i) {
+      const pb::EnumValueDescriptor*& slot = table->by_number[desc->value(i)->number() - min];
+      if (!slot) slot = desc->value(i);
+    }
+  }
+  return table;
+}
+
+}  // namespace pjconv
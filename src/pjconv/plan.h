@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-03
+ */
+
+#ifndef PJCONV_PLAN_H_
+#define PJCONV_PLAN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include "pjconv/generated.h"
+
+namespace pjconv {
+
+class Projection;
+struct MessagePlan;
+
+/**
+ * Hash the raw bytes of a name
+ */
+size_t HashName(const char* data, size_t size);
+
+/**
+ * Open addressing table from names to values.
+ *
+ * Keys are raw bytes, so a lookup never builds a string. The table points
+ * at the names it is given, which must outlive it.
+ */
+template<typename T>
+class NameTable {
+ public:
+  NameTable() : mask_(0) {
+  }
+
+  /**
+   * Empty the table and size it for the given number of names
+   */
+  void Reset(size_t max_names) {
+    // Keep the table at most half full
+    size_t capacity = 4;
+    while (capacity < max_names * 2) capacity *= 2;
+    slots_.assign(capacity, Slot());
+    mask_ = capacity - 1;
+  }
+
+  /**
+   * Add a name unless it is already present
+   */
+  void Insert(const std::string& name, const T* value) {
+    size_t hash = HashName(name.data(), name.size());
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      Slot& slot = slots_[i];
+      if (!slot.value) {
+        slot.hash = hash;
+        slot.size = name.size();
+        slot.name = name.data();
+        slot.value = value;
+        return;
+      }
+      if (slot.hash == hash && slot.size == name.size() &&
+          memcmp(slot.name, name.data(), name.size()) == 0) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * @return the value of the name given by its bytes, or NULL
+   */
+  const T* Find(const char* name, size_t size) const {
+    if (slots_.empty()) return NULL;
+    size_t hash = HashName(name, size);
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      const Slot& slot = slots_[i];
+      if (!slot.value) return NULL;
+      if (slot.hash == hash && slot.size == size && memcmp(slot.name, name, size) == 0) {
+        return slot.value;
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    size_t hash;
+    size_t size;
+    const char* name;
+    const T* value;
+  };
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+};
+
+/**
+ * The values of one enum type, indexed for conversion both ways
+ */
+struct EnumTable {
+  const google::protobuf::EnumDescriptor* descriptor;
+  /** The quoted value names, indexed by EnumValueDescriptor::index() */
+  std::vector<std::string> quoted_names;
+  /** The values by name */
+  NameTable<google::protobuf::EnumValueDescriptor> by_name;
+  /** The values by number minus min_number, when the numbers are dense enough */
+  std::vector<const google::protobuf::EnumValueDescriptor*> by_number;
+  int min_number;
+
+  const google::protobuf::EnumValueDescriptor* FindByName(const char* name, size_t size) const {
+    return by_name.Find(name, size);
+  }
+
+  const google::protobuf::EnumValueDescriptor* FindByNumber(int number) const {
+    if (by_number.empty()) return descriptor->FindValueByNumber(number);
+    google::protobuf::uint64 offset =
+        static_cast<google::protobuf::int64>(number) - min_number;
+    return offset < by_number.size() ? by_number[offset] : NULL;
+  }
+};
+
+/**
+ * How to convert one field, resolved from its descriptor once
+ */
+struct FieldPlan {
+  const google::protobuf::FieldDescriptor* field;
+  google::protobuf::FieldDescriptor::CppType cpp_type;
+  bool repeated;
+  /** The JSON member name, quoted and followed by a colon */
+  std::string key;
+  /** The values of the enum type for CPPTYPE_ENUM fields */
+  const EnumTable* enums;
+  /** The plan of the message type for CPPTYPE_MESSAGE fields */
+  const MessagePlan* message;
+};
+
+/**
+ * Table from JSON member names to field plans. Besides the field names it
+ * holds the json_name and the lowerCamelCase spelling of each field.
+ */
+typedef NameTable<FieldPlan> FieldNameTable;
+
+/**
+ * How to convert one message type
+ */
+struct MessagePlan {
+  const google::protobuf::Descriptor* descriptor;
+  /** The fields in JSON member order, that is by name */
+  std::vector<FieldPlan> fields;
+  /** The fields indexed by FieldDescriptor::index(), NULL for those left out */
+  std::vector<const FieldPlan*> by_index;
+  /** The fields by JSON member name */
+  FieldNameTable by_name;
+  /** The fields by number, when the numbers are small enough */
+  std::vector<const FieldPlan*> by_number;
+  /** The number of required fields */
+  int required_count;
+  /**
+   * The generated writer of the type, for messages whose reflection is
+   * generated_reflection; NULL if there is none
+   */
+  GeneratedJsonWriter generated;
+  const google::protobuf::Reflection* generated_reflection;
+
+  const FieldPlan& Find(const google::protobuf::FieldDescriptor* field) const {
+    return *by_index[field->index()];
+  }
+
+  const FieldPlan* Find(const char* name, size_t size) const {
+    return by_name.Find(name, size);
+  }
+
+  /**
+   * @return the plan of the field with a number, or NULL if there is none
+   */
+  const FieldPlan* FindByNumber(int number) const {
+    if (!by_number.empty()) {
+      return static_cast<size_t>(number) < by_number.size() ? by_number[number] : NULL;
+    }
+    const google::protobuf::FieldDescriptor* field = descriptor->FindFieldByNumber(number);
+    return field ? by_index[field->index()] : NULL;
+  }
+};
+
+/**
+ * The set fields of a message that a plan converts, in JSON member order
+ *
+ * Reflection::ListFields finds them from the has-bits, so a wide message
+ * with few fields set costs far less than a HasField call per field. The
+ * lists are kept in thread-local scratch space, one per nesting level, so
+ * instances must be destroyed in the reverse order of their creation.
+ */
+class PresentFields {
+ public:
+  PresentFields(const MessagePlan& plan, const google::protobuf::Message& message);
+  ~PresentFields();
+
+  /**
+   * @return whether listing the set fields of messages of a plan pays off
+   *     against testing each of its fields
+   */
+  static bool Worthwhile(const MessagePlan& plan);
+
+  size_t size() const {
+    return fields_->size();
+  }
+
+  const FieldPlan& operator[](size_t i) const {
+    return *(*fields_)[i];
+  }
+
+ private:
+  PresentFields(const PresentFields&);
+  void operator=(const PresentFields&);
+
+  const std::vector<const FieldPlan*>* fields_;
+};
+
+/**
+ * Build the lookup tables of a plan from its descriptor and fields. The
+ * fields may be a subset of the descriptor's; the others are not found.
+ */
+void IndexPlan(MessagePlan* plan);
+
+/**
+ * Compiles and keeps the plans of message types.
+ *
+ * Lookups of compiled plans take no lock: the plans are kept in an open
+ * addressing table whose slots are filled in place and never change once
+ * filled. A table that would be more than half full is copied into one
+ * twice its size; the old one stays for the readers that may still probe
+ * it, so the tables kept take less than twice the space of the current
+ * one, and the copying less than twice the inserts. Compiling a plan also
+ * compiles the plans of every message type reachable from it. Plans live
+ * as long as the cache, and the descriptors must outlive it.
+ */
+class PlanCache {
+ public:
+  PlanCache();
+  ~PlanCache();
+
+  /**
+   * @return the plan of a message type, compiling it on first use
+   */
+  const MessagePlan* Get(const google::protobuf::Descriptor* desc) {
+    const MessagePlan* plan = plans_.load(std::memory_order_acquire)->Find(desc);
+    return plan ? plan : Compile(desc);
+  }
+
+  /**
+   * @return the plan of the projected fields of a message type, or of all
+   *     its fields if projection is NULL; NULL if the projection is of
+   *     another type
+   */
+  const MessagePlan* Get(const google::protobuf::Descriptor* desc, const Projection* projection);
+
+ private:
+  typedef std::unordered_map<const google::protobuf::Descriptor*, MessagePlan*> PlanMap;
+  typedef std::unordered_map<const google::protobuf::EnumDescriptor*, EnumTable*> EnumMap;
+
+  /**
+   * Open addressing table from descriptors to plans. A slot gets its plan
+   * before its descriptor, so a reader that finds the descriptor finds
+   * the plan; only the compiling thread inserts.
+   */
+  class PlanTable {
+   public:
+    explicit PlanTable(size_t capacity);
+
+    const MessagePlan* Find(const google::protobuf::Descriptor* desc) const {
+      for (size_t i = Hash(desc) & mask_;; i = (i + 1) & mask_) {
+        const Slot& slot = slots_[i];
+        const google::protobuf::Descriptor* key = slot.descriptor.load(std::memory_order_acquire);
+        if (key == desc) return slot.plan.load(std::memory_order_relaxed);
+        if (!key) return NULL;
+      }
+    }
+
+    /** Add the plan of a type that is not in the table and fits in it */
+    void Insert(const google::protobuf::Descriptor* desc, const MessagePlan* plan);
+
+    /** @return whether the table stays at most half full with more plans */
+    bool Fits(size_t more) const {
+      return (size_ + more) * 2 <= slots_.size();
+    }
+
+    /** Add the plans of another table */
+    void InsertAll(const PlanTable& other);
+
+    size_t size() const {
+      return size_;
+    }
+
+   private:
+    PlanTable(const PlanTable&);
+    void operator=(const PlanTable&);
+
+    struct Slot {
+      std::atomic<const google::protobuf::Descriptor*> descriptor;
+      std::atomic<const MessagePlan*> plan;
+    };
+
+    // Descriptors are aligned, so their low bits are mixed in from the high ones
+    static size_t Hash(const google::protobuf::Descriptor* desc) {
+      google::protobuf::uint64 hash =
+          reinterpret_cast<uintptr_t>(desc) * 0x9e3779b97f4a7c15ULL;
+      return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+  };
+
+  PlanCache(const PlanCache&);
+  void operator=(const PlanCache&);
+
+  const MessagePlan* Compile(const google::protobuf::Descriptor* desc);
+  MessagePlan* Build(const google::protobuf::Descriptor* desc, PlanMap* pending);
+  const EnumTable* BuildEnum(const google::protobuf::EnumDescriptor* desc);
+
+  std::atomic<PlanTable*> plans_;
+  std::mutex mutex_;
+  /** The tables replaced by larger copies; readers may still be probing them */
+  std::vector<const PlanTable*> retired_;
+  std::vector<MessagePlan*> owned_;
+  /** The enum tables, only used while compiling */
+  EnumMap enums_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_PLAN_H_
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-03
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/plan.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+TEST(PlanCache, CompilesFieldsInMemberOrder) {
+  PlanCache plans;
+  const MessagePlan* plan = plans.Get(tutorial::Person::descriptor());
+  ASSERT_EQ(4u, plan->fields.size());
+  EXPECT_EQ("\"email\":", plan->fields[0].key);
+  EXPECT_EQ("\"id\":", plan->fields[1].key);
+  EXPECT_EQ("\"name\":", plan->fields[2].key);
+  EXPECT_EQ("\"phone\":", plan->fields[3].key);
+  EXPECT_TRUE(plan->fields[3].repeated);
+  EXPECT_EQ(pb::FieldDescriptor::CPPTYPE_INT32, plan->fields[1].cpp_type);
+
+  const pb::FieldDescriptor* name = tutorial::Person::descriptor()->FindFieldByName("name");
+  EXPECT_EQ(name, plan->Find(name).field);
+}
+
+TEST(PlanCache, LinksSubmessagePlans) {
+  PlanCache plans;
+  const MessagePlan* book = plans.Get(tutorial::AddressBook::descriptor());
+  const MessagePlan* person = book->fields[0].message;
+  ASSERT_TRUE(person != NULL);
+  EXPECT_EQ(tutorial::Person::descriptor(), person->descriptor);
+  // Reachable types are compiled along with the root
+  EXPECT_EQ(person, plans.Get(tutorial::Person::descriptor()));
+
+  const FieldPlan& type = person->fields[3].message->fields[1];
+  EXPECT_EQ("\"type\":", type.key);
+  ASSERT_TRUE(type.enums != NULL);
+  ASSERT_EQ(3u, type.enums->quoted_names.size());
+  EXPECT_EQ("\"WORK\"", type.enums->quoted_names[2]);
+}
+
+TEST(PlanCache, CompilesRecursiveTypes) {
+  pb::FileDescriptorProto file;
+  ASSERT_TRUE(pb::TextFormat::ParseFromString(
+      "name: 'tree.proto' message_type { name: 'Node' "
+      "field { name: 'child' number: 1 label: LABEL_REPEATED type: TYPE_MESSAGE "
+      "type_name: '.Node' } }", &file));
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* fd = pool.BuildFile(file);
+  ASSERT_TRUE(fd != NULL);
+  PlanCache plans;
+  const MessagePlan* node = plans.Get(fd->message_type(0));
+  EXPECT_EQ(node, node->fields[0].message);
+}
+
+TEST(PlanCache, KeepsPlansAsTheTableGrows) {
+  // Each type refers to the one before, so compiles add one or two plans
+  std::string text = "name: 'chain.proto' ";
+  for (int i = 0; i < 200; ++i) {
+    char message[160];
+    snprintf(message, sizeof(message),
+             "message_type { name: 'M%d' field { name: 'prev' number: 1 label: LABEL_OPTIONAL "
+             "type: TYPE_MESSAGE type_name: '.M%d' } } ",
+             i, i > 0 ? i - 1 : 0);
+    text += message;
+  }
+  pb::FileDescriptorProto file;
+  ASSERT_TRUE(pb::TextFormat::ParseFromString(text, &file));
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* fd = pool.BuildFile(file);
+  ASSERT_TRUE(fd != NULL);
+  PlanCache plans;
+  std::vector<const MessagePlan*> compiled;
+  for (int i = 0; i < fd->message_type_count(); i += 2) {
+    compiled.push_back(plans.Get(fd->message_type(i)));
+  }
+  for (int i = 0; i < fd->message_type_count(); ++i) {
+    const MessagePlan* plan = plans.Get(fd->message_type(i));
+    ASSERT_TRUE(plan != NULL);
+    EXPECT_EQ(fd->message_type(i), plan->descriptor);
+    EXPECT_EQ(plans.Get(fd->message_type(i > 0 ? i - 1 : 0)), plan->fields[0].message);
+    if (i % 2 == 0) {
+      EXPECT_EQ(compiled[i / 2], plan);
+    }
+  }
+}
+
+TEST(EnumTable, FindsValuesByNameAndNumber) {
+  pb::FileDescriptorProto file;
+  ASSERT_TRUE(pb::TextFormat::ParseFromString(
+      "name: 'enums.proto' "
+      "enum_type { name: 'Dense' options { allow_alias: true } "
+      "  value { name: 'A' number: -1 } value { name: 'B' number: 3 } "
+      "  value { name: 'ALSO_B' number: 3 } } "
+      "enum_type { name: 'Sparse' value { name: 'LOW' number: -2000000000 } "
+      "  value { name: 'HIGH' number: 2000000000 } } "
+      "message_type { name: 'M' "
+      "  field { name: 'dense' number: 1 label: LABEL_REPEATED type: TYPE_ENUM "
+      "          type_name: '.Dense' } "
+      "  field { name: 'other_dense' number: 2 label: LABEL_OPTIONAL type: TYPE_ENUM "
+      "          type_name: '.Dense' } "
+      "  field { name: 'sparse' number: 3 label: LABEL_OPTIONAL type: TYPE_ENUM "
+      "          type_name: '.Sparse' } }", &file));
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* fd = pool.BuildFile(file);
+  ASSERT_TRUE(fd != NULL);
+  PlanCache plans;
+  const MessagePlan* plan = plans.Get(fd->message_type(0));
+  // Fields of the same enum type share its table
+  EXPECT_EQ(plan->fields[0].enums, plan->fields[1].enums);
+
+  const EnumTable* dense = plan->fields[0].enums;
+  EXPECT_FALSE(dense->by_number.empty());
+  EXPECT_EQ("A", dense->FindByNumber(-1)->name());
+  // Aliases resolve to the first value of a number, like FindValueByNumber
+  EXPECT_EQ("B", dense->FindByNumber(3)->name());
+  EXPECT_TRUE(dense->FindByNumber(0) == NULL);
+  EXPECT_TRUE(dense->FindByNumber(4) == NULL);
+  EXPECT_TRUE(dense->FindByNumber(-2) == NULL);
+  EXPECT_EQ(3, dense->FindByName("ALSO_B", 6)->number());
+  EXPECT_TRUE(dense->FindByName("ALSO", 4) == NULL);
+
+  const EnumTable* sparse = plan->fields[2].enums;
+  EXPECT_TRUE(sparse->by_number.empty());
+  EXPECT_EQ("HIGH", sparse->FindByNumber(2000000000)->name());
+  EXPECT_TRUE(sparse->FindByNumber(0) == NULL);
+  EXPECT_EQ(-2000000000, sparse->FindByName("LOW", 3)->number());
+}
+
+TEST(FieldNameTable, FindsNamesAndAliases) {
+  pb::FileDescriptorProto file;
+  ASSERT_TRUE(pb::TextFormat::ParseFromString(
+      "name: 'alias.proto' message_type { name: 'M' "
+      "field { name: 'phone_number' number: 1 label: LABEL_OPTIONAL type: TYPE_STRING } "
+      "field { name: 'zip_code' number: 2 label: LABEL_OPTIONAL type: TYPE_STRING "
+      "        json_name: 'postcode' } "
+      "field { name: 'zipCode' number: 3 label: LABEL_OPTIONAL type: TYPE_STRING } }",
+      &file));
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* fd = pool.BuildFile(file);
+  ASSERT_TRUE(fd != NULL);
+  const pb::Descriptor* desc = fd->message_type(0);
+  PlanCache plans;
+  const MessagePlan* plan = plans.Get(desc);
+
+  const char* names[] = { "phone_number", "phoneNumber", "zip_code", "postcode", "zipCode" };
+  int numbers[] = { 1, 1, 2, 2, 3 };
+  for (int i = 0; i < 5; ++i) {
+    const FieldPlan* field = plan->Find(names[i], strlen(names[i]));
+    ASSERT_TRUE(field != NULL) << names[i];
+    EXPECT_EQ(numbers[i], field->field->number()) << names[i];
+  }
+  EXPECT_TRUE(plan->Find("phone", 5) == NULL);
+  EXPECT_TRUE(plan->Find("phone_numbers", 13) == NULL);
+  EXPECT_TRUE(plan->Find("", 0) == NULL);
+}
+
+TEST(FieldNameTable, FindsEveryFieldOfWideMessage) {
+  std::string text = "name: 'wide.proto' message_type { name: 'Wide' ";
+  for (int i = 1; i <= 300; ++i) {
+    char field[128];
+    snprintf(field, sizeof(field),
+             "field { name: 'field_%d' number: %d label: LABEL_OPTIONAL type: TYPE_INT32 } ",
+             i, i);
+    text += field;
+  }
+  text += "}";
+  pb::FileDescriptorProto file;
+  ASSERT_TRUE(pb::TextFormat::ParseFromString(text, &file));
+  pb::DescriptorPool pool;
+  const pb::FileDescriptor* fd = pool.BuildFile(file);
+  ASSERT_TRUE(fd != NULL);
+  PlanCache plans;
+  const MessagePlan* plan = plans.Get(fd->message_type(0));
+  for (int i = 1; i <= 300; ++i) {
+    char name[32];
+    int size = snprintf(name, sizeof(name), "field_%d", i);
+    const FieldPlan* field = plan->Find(name, size);
+    ASSERT_TRUE(field != NULL) << name;
+    EXPECT_EQ(i, field->field->number());
+    size = snprintf(name, sizeof(name), "field%d", i);
+    field = plan->Find(name, size);
+    ASSERT_TRUE(field != NULL) << name;
+    EXPECT_EQ(i, field->field->number());
+  }
+  EXPECT_TRUE(plan->Find("field_301", 9) == NULL);
+}
+
+TEST(PresentFields, ListsSetFieldsInMemberOrder) {
+  PlanCache plans;
+  const MessagePlan* plan = plans.Get(test::TypesDescriptor());
+  ASSERT_TRUE(PresentFields::Worthwhile(*plan));
+  EXPECT_FALSE(PresentFields::Worthwhile(*plans.Get(tutorial::Person::descriptor())));
+
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  const pb::Descriptor* desc = m->GetDescriptor();
+  const pb::Reflection* ref = m->GetReflection();
+  ref->SetString(m.get(), desc->FindFieldByName("s"), "x");
+  ref->SetBool(m.get(), desc->FindFieldByName("b"), false);
+  ref->AddInt32(m.get(), desc->FindFieldByName("r_i32"), 1);
+  ref->AddInt64(m.get(), desc->FindFieldByName("r_i64"), 1);
+  ref->ClearField(m.get(), desc->FindFieldByName("r_i64"));
+  pb::Message* inner = ref->MutableMessage(m.get(), desc->FindFieldByName("inner"));
+  inner->GetReflection()->SetString(inner, inner->GetDescriptor()->FindFieldByName("tag"), "t");
+
+  PresentFields present(*plan, *m);
+  ASSERT_EQ(4u, present.size());
+  EXPECT_EQ("b", present[0].field->name());
+  EXPECT_EQ("inner", present[1].field->name());
+  {
+    // A nested list leaves the outer one alone
+    PresentFields nested(*present[1].message, *inner);
+    ASSERT_EQ(1u, nested.size());
+    EXPECT_EQ("tag", nested[0].field->name());
+  }
+  EXPECT_EQ("r_i32", present[2].field->name());
+  EXPECT_EQ("s", present[3].field->name());
+}
+
+TEST(PlanCache, SharesPlansAcrossThreads) {
+  PlanCache plans;
+  const pb::Descriptor* descs[] = {
+    tutorial::AddressBook::descriptor(), tutorial::Person::PhoneNumber::descriptor(),
+    test::TypesDescriptor(), tutorial::Person::descriptor(),
+  };
+  const int kThreads = 8;
+  std::vector<const MessagePlan*> results(kThreads * 4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.push_back(std::thread([&plans, &descs, &results, t]() {
+      for (int i = 0; i < 4; ++i) {
+        results[t * 4 + i] = plans.Get(descs[(t + i) % 4]);
+      }
+    }));
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    threads[t].join();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(plans.Get(descs[(t + i) % 4]), results[t * 4 + i]);
+    }
+  }
+}
+
+}  // namespace pjconv
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+#ifndef PJCONV_PROFILE_TRACE_H_
+#define PJCONV_PROFILE_TRACE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <google/protobuf/stubs/common.h>
+
+#include "pjconv/profiler.h"
+
+namespace pjconv {
+
+/**
+ * The frames of one conversion a ConversionProfiler traces.
+ *
+ * The recursions that convert messages look the trace up once for each
+ * message and, when the conversion is traced, open a frame for the message
+ * and one for each of its fields. A frame keeps the time and the bytes
+ * from its opening to its closing, the frames inside it included.
+ */
+class ProfileTrace {
+ public:
+  /** @return the trace of the conversion running on this thread, or NULL */
+  static ProfileTrace* Current() {
+    return current_;
+  }
+
+  /**
+   * Open a frame inside the innermost open one
+   *
+   * @param name the name of the frame, which must outlive the conversion
+   * @param bytes the JSON text written or read so far
+   */
+  void Enter(const std::string& name, size_t bytes);
+
+  /**
+   * Close the innermost open frame
+   *
+   * @param bytes the JSON text written or read so far
+   */
+  void Leave(size_t bytes);
+
+ private:
+  ProfileTrace(const ProfileTrace&);
+  void operator=(const ProfileTrace&);
+
+  friend class ProfileScope;
+  friend class ConversionProfiler;
+
+  explicit ProfileTrace(const std::string& root);
+
+  /** A stack of frames, shared by all the frames opened on it */
+  struct Node {
+    const std::string* name;
+    size_t parent;
+    size_t first_child;
+    size_t next_sibling;
+    google::protobuf::uint64 nanoseconds;
+    google::protobuf::uint64 bytes;
+  };
+
+  struct Frame {
+    size_t node;
+    std::chrono::steady_clock::time_point start;
+    size_t bytes;
+  };
+
+  /** The stacks, each after its parent; the first is the root */
+  std::vector<Node> nodes_;
+  std::vector<Frame> frames_;
+
+  /**
+   * The trace of the thread; __thread like StatsScope::current_, so that
+   * the recursions in other files read it without a call
+   */
+  static __thread ProfileTrace* current_ __attribute__((tls_model("initial-exec")));
+};
+
+/**
+ * Traces one conversion if its profiler samples it.
+ *
+ * A scope opened inside another on the same thread neither samples nor
+ * traces, whether the outer one traces or not, so public calls that call
+ * each other count as one conversion.
+ */
+class ProfileScope {
+ public:
+  enum Direction { kToJson, kFromJson };
+
+  ProfileScope(ConversionProfiler* profiler, Direction direction)
+      : profiler_(profiler), trace_(NULL), outermost_(false), ok_(false) {
+    if (profiler_ && !open_) Open(direction);
+  }
+
+  ~ProfileScope() {
+    if (outermost_) Close();
+  }
+
+  /** Count the conversion as done; the traces of failed ones are dropped */
+  void Finish(bool ok) {
+    ok_ = ok;
+  }
+
+ private:
+  ProfileScope(const ProfileScope&);
+  void operator=(const ProfileScope&);
+
+  void Open(Direction direction);
+  void Close();
+
+  /**
+   * Whether the thread is inside the outermost scope of a profiler;
+   * __thread for the inline constructor, as current_ is
+   */
+  static __thread bool open_ __attribute__((tls_model("initial-exec")));
+
+  ConversionProfiler* profiler_;
+  ProfileTrace* trace_;
+  bool outermost_;
+  bool ok_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_PROFILE_TRACE_H_
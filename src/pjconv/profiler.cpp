@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+#include "pjconv/profiler.h"
+#include "pjconv/profile_trace.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+const size_t kNoNode = static_cast<size_t>(-1);
+
+const std::string& RootName(ProfileScope::Direction direction) {
+  // Never destroyed, as a conversion may outlive the static destructors
+  static const std::string* to_json = new std::string("to_json");
+  static const std::string* from_json = new std::string("from_json");
+  return direction == ProfileScope::kToJson ? *to_json : *from_json;
+}
+
+}  // namespace
+
+__thread ProfileTrace* ProfileTrace::current_ = NULL;
+__thread bool ProfileScope::open_ = false;
+
+ProfileTrace::ProfileTrace(const std::string& root) {
+  Node node = {&root, kNoNode, kNoNode, kNoNode, 0, 0};
+  nodes_.push_back(node);
+  Frame frame = {0, std::chrono::steady_clock::now(), 0};
+  frames_.push_back(frame);
+}
+
+void ProfileTrace::Enter(const std::string& name, size_t bytes) {
+  size_t parent = frames_.back().node;
+  // The names are those of descriptors, so the same name is the same string
+  size_t node = nodes_[parent].first_child;
+  while (node != kNoNode && nodes_[node].name != &name) {
+    node = nodes_[node].next_sibling;
+  }
+  if (node == kNoNode) {
+    node = nodes_.size();
+    Node child = {&name, parent, kNoNode, nodes_[parent].first_child, 0, 0};
+    nodes_.push_back(child);
+    nodes_[parent].first_child = node;
+  }
+  // The clock is read last and first, so finding the stack is not charged to it
+  Frame frame = {node, std::chrono::steady_clock::now(), bytes};
+  frames_.push_back(frame);
+}
+
+void ProfileTrace::Leave(size_t bytes) {
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  const Frame& frame = frames_.back();
+  Node& node = nodes_[frame.node];
+  node.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      end - frame.start).count();
+  node.bytes += bytes - frame.bytes;
+  frames_.pop_back();
+}
+
+void ProfileScope::Open(Direction direction) {
+  open_ = true;
+  outermost_ = true;
+  if (!profiler_->Sample()) return;
+  trace_ = new ProfileTrace(RootName(direction));
+  ProfileTrace::current_ = trace_;
+}
+
+void ProfileScope::Close() {
+  open_ = false;
+  if (!trace_) return;
+  ProfileTrace::current_ = NULL;
+  // A failed conversion may return with frames still open
+  if (ok_ && trace_->frames_.size() == 1) {
+    trace_->Leave(0);
+    profiler_->Add(*trace_);
+  }
+  delete trace_;
+}
+
+ConversionProfiler::ConversionProfiler(unsigned sample_period)
+    : sample_period_(sample_period > 0 ? sample_period : 1), conversions_(0), traced_(0) {
+}
+
+ConversionProfiler::~ConversionProfiler() {
+}
+
+bool ConversionProfiler::Sample() {
+  return conversions_.fetch_add(1, std::memory_order_relaxed) % sample_period_ == 0;
+}
+
+void ConversionProfiler::Add(const ProfileTrace& trace) {
+  const std::vector<ProfileTrace::Node>& nodes = trace.nodes_;
+  std::vector<Cost> inner(nodes.size());
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    inner[nodes[i].parent].nanoseconds += nodes[i].nanoseconds;
+    inner[nodes[i].parent].bytes += nodes[i].bytes;
+  }
+  // The stacks are built outside the lock; each comes after its parent
+  std::vector<std::string> stacks(nodes.size());
+  std::vector<Cost> own(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (i > 0) stacks[i] = stacks[nodes[i].parent] + ';';
+    stacks[i] += *nodes[i].name;
+    // What the inner frames leave is the frame's own; the root counts no bytes
+    if (nodes[i].nanoseconds > inner[i].nanoseconds) {
+      own[i].nanoseconds = nodes[i].nanoseconds - inner[i].nanoseconds;
+    }
+    if (nodes[i].bytes > inner[i].bytes) own[i].bytes = nodes[i].bytes - inner[i].bytes;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    Cost& cost = costs_[stacks[i]];
+    cost.nanoseconds += own[i].nanoseconds;
+    cost.bytes += own[i].bytes;
+  }
+  ++traced_;
+}
+
+std::string ConversionProfiler::ToFolded(Metric metric) const {
+  std::string folded;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::map<std::string, Cost>::const_iterator iter = costs_.begin(); iter != costs_.end();
+       ++iter) {
+    pb::uint64 value = metric == kNanoseconds ? iter->second.nanoseconds : iter->second.bytes;
+    if (value == 0) continue;
+    folded += iter->first;
+    folded += ' ';
+    folded += std::to_string(value);
+    folded += '\n';
+  }
+  return folded;
+}
+
+pb::uint64 ConversionProfiler::traced_conversions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return traced_;
+}
+
+void ConversionProfiler::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  costs_.clear();
+  traced_ = 0;
+}
+
+}  // namespace pjconv
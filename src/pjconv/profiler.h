@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+#ifndef PJCONV_PROFILER_H_
+#define PJCONV_PROFILER_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <google/protobuf/stubs/common.h>
+
+namespace pjconv {
+
+class ProfileScope;
+class ProfileTrace;
+
+/**
+ * Attributes the cost of conversions to the message types and fields they
+ * go through.
+ *
+ * Set it in ConvertOptions and it traces one in every sample_period of the
+ * conversions made with those options: each message and each field is
+ * timed as it is converted, and the JSON text it writes or reads is
+ * counted. The cost of a frame is its own, without that of the frames
+ * inside it, so the output of ToFolded goes straight to flamegraph.pl:
+ *
+ *   to_json;tutorial.AddressBook;person;tutorial.Person;name 1520
+ *
+ * A traced conversion runs several times slower, as it reads the clock
+ * twice for every field; the times are of the traced conversions only.
+ * TranscodeToJson, TranscodeToWire and the conversions that take no
+ * options are not traced.
+ *
+ * A profiler can be shared by any number of threads converting at once.
+ */
+class ConversionProfiler {
+ public:
+  enum Metric {
+    /** The time spent in each frame */
+    kNanoseconds,
+    /** The JSON text written or read in each frame */
+    kBytes,
+  };
+
+  /**
+   * @param sample_period trace one in this many conversions; 1 traces all
+   */
+  explicit ConversionProfiler(unsigned sample_period = 100);
+  ~ConversionProfiler();
+
+  /**
+   * @param metric the cost to write
+   * @return one "frame;frame;... cost" line for each stack of frames with
+   *     a cost, sorted by stack
+   */
+  std::string ToFolded(Metric metric) const;
+
+  /** @return the number of conversions traced so far */
+  google::protobuf::uint64 traced_conversions() const;
+
+  /** Forget the costs so far */
+  void Clear();
+
+ private:
+  ConversionProfiler(const ConversionProfiler&);
+  void operator=(const ConversionProfiler&);
+
+  friend class ProfileScope;
+
+  struct Cost {
+    Cost() : nanoseconds(0), bytes(0) {
+    }
+
+    google::protobuf::uint64 nanoseconds;
+    google::protobuf::uint64 bytes;
+  };
+
+  /** @return whether to trace the conversion starting now */
+  bool Sample();
+  void Add(const ProfileTrace& trace);
+
+  const unsigned sample_period_;
+  std::atomic<unsigned> conversions_;
+  mutable std::mutex mutex_;
+  /** The costs of each stack, by its frames joined with ';' */
+  std::map<std::string, Cost> costs_;
+  google::protobuf::uint64 traced_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_PROFILER_H_
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+#include <memory>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/profiler.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+TEST(ConversionProfiler, AttributesWrittenBytesToFields) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> m(test::NewSmallTypes());
+  ConversionProfiler profiler(1);
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  options.profiler = &profiler;
+  std::string json;
+  ASSERT_TRUE(conv.Write(*m, &json, options));
+  ASSERT_EQ("{\"i32\":5,\"inner\":{\"x\":7},\"s\":\"text\"}", json);
+  // Each member owns the comma or brace before it
+  EXPECT_EQ("to_json;pjconv.test.Types 1\n"
+            "to_json;pjconv.test.Types;i32 8\n"
+            "to_json;pjconv.test.Types;inner 9\n"
+            "to_json;pjconv.test.Types;inner;pjconv.test.Inner 1\n"
+            "to_json;pjconv.test.Types;inner;pjconv.test.Inner;x 6\n"
+            "to_json;pjconv.test.Types;s 11\n",
+            profiler.ToFolded(ConversionProfiler::kBytes));
+  std::string times = profiler.ToFolded(ConversionProfiler::kNanoseconds);
+  EXPECT_NE(std::string::npos, times.find("\nto_json;pjconv.test.Types;inner;pjconv.test.Inner;x "));
+  EXPECT_EQ(1u, profiler.traced_conversions());
+
+  profiler.Clear();
+  EXPECT_EQ("", profiler.ToFolded(ConversionProfiler::kBytes));
+  EXPECT_EQ(0u, profiler.traced_conversions());
+}
+
+TEST(ConversionProfiler, AttributesReadBytesToFields) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ConversionProfiler profiler(1);
+  ConvertOptions options;
+  options.profiler = &profiler;
+  std::string json = "{\"i32\":5,\"inner\":{\"x\":7},\"s\":\"text\",\"zzz\":1}";
+  ASSERT_TRUE(conv.Convert(json.data(), json.size(), m.get(), options));
+  // A field owns its value; keys and unknown members stay with the message
+  EXPECT_EQ("from_json;pjconv.test.Types 30\n"
+            "from_json;pjconv.test.Types;i32 1\n"
+            "from_json;pjconv.test.Types;inner;pjconv.test.Inner 6\n"
+            "from_json;pjconv.test.Types;inner;pjconv.test.Inner;x 1\n"
+            "from_json;pjconv.test.Types;s 6\n",
+            profiler.ToFolded(ConversionProfiler::kBytes));
+
+  ASSERT_FALSE(conv.Convert(std::string("{\"i32\":"), m.get()));
+  ASSERT_FALSE(conv.Convert("{\"i32\":", 7, m.get(), options));
+  EXPECT_EQ(1u, profiler.traced_conversions());
+}
+
+TEST(ConversionProfiler, TracesJsonValues) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> m(test::NewSmallTypes());
+  ConversionProfiler profiler(1);
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  options.profiler = &profiler;
+  // The styled text is written from a Json::Value, in one traced conversion
+  std::string json;
+  ASSERT_TRUE(conv.Convert(*m, &json, true, options));
+  Json::Value value;
+  ASSERT_TRUE(conv.Convert(*m, &value, options));
+  std::unique_ptr<pb::Message> back(test::NewTypes());
+  ASSERT_TRUE(conv.Convert(value, back.get(), options));
+  EXPECT_EQ(m->SerializeAsString(), back->SerializeAsString());
+  EXPECT_EQ(3u, profiler.traced_conversions());
+
+  std::string times = profiler.ToFolded(ConversionProfiler::kNanoseconds);
+  EXPECT_NE(std::string::npos, times.find("\nto_json;pjconv.test.Types;inner;pjconv.test.Inner;x "));
+  EXPECT_NE(std::string::npos,
+            times.find("\nfrom_json;pjconv.test.Types;inner;pjconv.test.Inner;x "));
+  // No text is written or read
+  EXPECT_EQ("", profiler.ToFolded(ConversionProfiler::kBytes));
+}
+
+TEST(ConversionProfiler, SamplesConversions) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> m(test::NewSmallTypes());
+  ConversionProfiler profiler(4);
+  ConvertOptions options;
+  options.profiler = &profiler;
+  for (int i = 0; i < 10; ++i) {
+    std::string json;
+    ASSERT_TRUE(conv.Write(*m, &json, options));
+  }
+  EXPECT_EQ(3u, profiler.traced_conversions());
+}
+
+TEST(ConversionProfiler, SamplesOutermostConversions) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> m(test::NewSmallTypes());
+  ConversionProfiler profiler(2);
+  ConvertOptions options;
+  options.profiler = &profiler;
+  // Styled text is written through a Json::Value, a conversion inside the
+  // conversion, which is not sampled apart from it
+  for (int i = 0; i < 4; ++i) {
+    std::string json;
+    ASSERT_TRUE(conv.Convert(*m, &json, true, options));
+  }
+  EXPECT_EQ(2u, profiler.traced_conversions());
+}
+
+}  // namespace pjconv
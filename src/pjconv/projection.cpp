@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-19
+ */
+
+
+#include <map>
+
+#include "pjconv/projection.h"
+#include "pjconv/plan.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+/**
+ * The selected fields of one message, as a tree of the paths through it
+ */
+struct Projection::Selection {
+  Selection() : plan(NULL), all(false) {
+  }
+
+  /** The plan of the whole message type */
+  const MessagePlan* plan;
+  /** Whether the whole message is selected */
+  bool all;
+  /** The selected fields by FieldDescriptor::index() */
+  std::map<int, Selection> fields;
+};
+
+Projection::Projection() : root_(NULL) {
+}
+
+Projection::~Projection() {
+  for (size_t i = 0; i < owned_.size(); ++i) {
+    delete owned_[i];
+  }
+}
+
+const pb::Descriptor* Projection::descriptor() const {
+  return root_->descriptor;
+}
+
+Projection* Projection::Compile(
+    PlanCache* plans,
+    const pb::Descriptor* desc,
+    const std::vector<std::string>& paths) {
+  Selection root;
+  root.plan = plans->Get(desc);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    const std::string& path = paths[i];
+    Selection* selection = &root;
+    size_t begin = 0;
+    for (;;) {
+      size_t end = path.find('.', begin);
+      if (end == std::string::npos) end = path.size();
+      // Field names, json names and camelCase names are all accepted
+      const FieldPlan* field = selection->plan ?
+          selection->plan->Find(path.data() + begin, end - begin) : NULL;
+      if (!field) return NULL;
+      selection = &selection->fields[field->field->index()];
+      selection->plan = field->message;
+      if (end == path.size()) {
+        selection->all = true;
+        break;
+      }
+      begin = end + 1;
+    }
+  }
+
+  Projection* projection = new Projection();
+  projection->root_ = projection->Build(root);
+  return projection;
+}
+
+MessagePlan* Projection::Build(const Selection& selection) {
+  const MessagePlan& whole = *selection.plan;
+  MessagePlan* plan = new MessagePlan();
+  owned_.push_back(plan);
+  plan->descriptor = whole.descriptor;
+  // A generated writer writes every field, so a pruned plan goes without
+  plan->generated = NULL;
+  plan->generated_reflection = NULL;
+  // Keep the JSON member order of the whole plan
+  for (size_t i = 0; i < whole.fields.size(); ++i) {
+    const FieldPlan& field = whole.fields[i];
+    std::map<int, Selection>::const_iterator iter = selection.fields.find(field.field->index());
+    if (iter == selection.fields.end()) continue;
+    plan->fields.push_back(field);
+    if (field.message && !iter->second.all) {
+      plan->fields.back().message = Build(iter->second);
+    }
+  }
+  IndexPlan(plan);
+  return plan;
+}
+
+}  // namespace pjconv
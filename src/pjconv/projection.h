@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-19
+ */
+
+
+#ifndef PJCONV_PROJECTION_H_
+#define PJCONV_PROJECTION_H_
+
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+
+namespace pjconv {
+
+class PlanCache;
+struct MessagePlan;
+
+/**
+ * A set of field paths of one message type, compiled for conversion
+ *
+ * A path names a field by its dot-separated field names from the root, as
+ * in a FieldMask: "person.phone.number" selects the number of every phone
+ * of every person. A path ending at a message field selects all of it.
+ * Conversions under a projection write and read only the selected fields,
+ * and never visit the others. Create one with PJConverter::NewProjection;
+ * it must not outlive that converter, and can be shared by any number of
+ * threads.
+ */
+class Projection {
+ public:
+  ~Projection();
+
+  /** @return the message type the paths start from */
+  const google::protobuf::Descriptor* descriptor() const;
+
+  /** @return the plan of the selected fields of the root message */
+  const MessagePlan* plan() const {
+    return root_;
+  }
+
+ private:
+  friend class PJConverter;
+
+  Projection();
+  Projection(const Projection&);
+  void operator=(const Projection&);
+
+  /**
+   * @return the projection of the paths, or NULL if a path names no field
+   */
+  static Projection* Compile(
+      PlanCache* plans,
+      const google::protobuf::Descriptor* desc,
+      const std::vector<std::string>& paths);
+
+  struct Selection;
+  MessagePlan* Build(const Selection& selection);
+
+  const MessagePlan* root_;
+  std::vector<MessagePlan*> owned_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_PROJECTION_H_
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-19
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/proto/addressbook.pb.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+void BuildBook(tutorial::AddressBook* book) {
+  tutorial::Person* person = book->add_person();
+  person->set_name("ann");
+  person->set_id(1);
+  person->set_email("ann@example.com");
+  tutorial::Person::PhoneNumber* phone = person->add_phone();
+  phone->set_number("111");
+  phone->set_type(tutorial::Person::WORK);
+  person->add_phone()->set_number("222");
+  person = book->add_person();
+  person->set_name("bob");
+  person->set_id(2);
+}
+
+std::vector<std::string> Paths(const char* a, const char* b = NULL) {
+  std::vector<std::string> paths(1, a);
+  if (b) paths.push_back(b);
+  return paths;
+}
+
+}  // namespace
+
+TEST(Projection, WritesSelectedPaths) {
+  PJConverter conv;
+  tutorial::AddressBook book;
+  BuildBook(&book);
+  std::unique_ptr<Projection> projection(conv.NewProjection(
+      book.GetDescriptor(), Paths("person.phone.number", "person.name")));
+  ASSERT_TRUE(projection.get() != NULL);
+  EXPECT_EQ(book.GetDescriptor(), projection->descriptor());
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+  options.projection = projection.get();
+
+  std::string expected = "{\"person\":[{\"name\":\"ann\",\"phone\":[{\"number\":\"111\"},"
+      "{\"number\":\"222\"}]},{\"name\":\"bob\"}]}";
+  std::string json;
+  ASSERT_TRUE(conv.Write(book, &json, options));
+  EXPECT_EQ(expected, json);
+  EXPECT_EQ(expected.size(), conv.ComputeJsonSize(book, options));
+
+  // Every path from a message to JSON gives the same text
+  ASSERT_TRUE(conv.Convert(book, &json, false, options));
+  EXPECT_EQ(expected + "\n", json);
+  Json::Value value;
+  ASSERT_TRUE(conv.Convert(book, &value, options));
+  EXPECT_EQ(expected + "\n", Json::FastWriter().write(value));
+  std::string bytes = book.SerializeAsString();
+  json.clear();
+  ASSERT_TRUE(conv.TranscodeToJson(bytes.data(), bytes.size(), book.GetDescriptor(), &json,
+                                   options));
+  EXPECT_EQ(expected, json);
+}
+
+TEST(Projection, SelectsWholeSubtrees) {
+  PJConverter conv;
+  tutorial::AddressBook book;
+  BuildBook(&book);
+  // A path ending at a message selects all of it, whatever else names its fields
+  std::unique_ptr<Projection> projection(conv.NewProjection(
+      book.GetDescriptor(), Paths("person.phone", "person.phone.number")));
+  ASSERT_TRUE(projection.get() != NULL);
+  ConvertOptions options;
+  options.projection = projection.get();
+  std::string json;
+  ASSERT_TRUE(conv.Write(book, &json, options));
+  // A message with nothing selected set is null, as in a Json::Value
+  EXPECT_EQ("{\"person\":[{\"phone\":[{\"number\":\"111\",\"type\":\"WORK\"},"
+            "{\"number\":\"222\",\"type\":\"HOME\"}]},null]}", json);
+
+  projection.reset(conv.NewProjection(book.GetDescriptor(), Paths("person")));
+  ASSERT_TRUE(projection.get() != NULL);
+  std::string all;
+  options.projection = NULL;
+  ASSERT_TRUE(conv.Write(book, &all, options));
+  options.projection = projection.get();
+  json.clear();
+  ASSERT_TRUE(conv.Write(book, &json, options));
+  EXPECT_EQ(all, json);
+}
+
+TEST(Projection, RejectsBadPaths) {
+  PJConverter conv;
+  const pb::Descriptor* desc = tutorial::AddressBook::descriptor();
+  EXPECT_TRUE(conv.NewProjection(desc, Paths("person.nope")) == NULL);
+  EXPECT_TRUE(conv.NewProjection(desc, Paths("person.name.length")) == NULL);
+  EXPECT_TRUE(conv.NewProjection(desc, Paths("person.")) == NULL);
+  EXPECT_TRUE(conv.NewProjection(desc, Paths("")) == NULL);
+  EXPECT_TRUE(conv.NewProjection(desc, Paths("person", "phone")) == NULL);
+  EXPECT_TRUE(conv.NewProjection(NULL, Paths("person")) == NULL);
+
+  // A projection only converts messages of its own type
+  std::unique_ptr<Projection> projection(conv.NewProjection(desc, Paths("person.id")));
+  ASSERT_TRUE(projection.get() != NULL);
+  ConvertOptions options;
+  options.projection = projection.get();
+  tutorial::Person person;
+  std::string json;
+  EXPECT_FALSE(conv.Write(person, &json, options));
+  EXPECT_EQ(0u, conv.ComputeJsonSize(person, options));
+  EXPECT_FALSE(conv.TranscodeToJson("", 0, person.GetDescriptor(), &json, options));
+  EXPECT_FALSE(conv.Convert("{}", 2, &person, options));
+  EXPECT_TRUE(conv.ConvertOnArena("{}", 2, person, NULL, options) == NULL);
+  EXPECT_TRUE(conv.ConvertOnArena(Json::Value(), person, NULL, options) == NULL);
+}
+
+TEST(Projection, ParsesSelectedPaths) {
+  PJConverter conv;
+  tutorial::AddressBook book;
+  BuildBook(&book);
+  std::string text;
+  ASSERT_TRUE(conv.Write(book, &text));
+  std::unique_ptr<Projection> projection(conv.NewProjection(
+      book.GetDescriptor(), Paths("person.id", "person.phone.type")));
+  ASSERT_TRUE(projection.get() != NULL);
+  ConvertOptions options;
+  options.projection = projection.get();
+
+  tutorial::AddressBook parsed;
+  ASSERT_TRUE(conv.Convert(text.data(), text.size(), &parsed, options));
+  tutorial::AddressBook expected;
+  expected.add_person()->set_id(1);
+  expected.mutable_person(0)->add_phone()->set_type(tutorial::Person::WORK);
+  expected.mutable_person(0)->add_phone()->set_type(tutorial::Person::HOME);
+  expected.add_person()->set_id(2);
+  EXPECT_EQ(expected.DebugString(), parsed.DebugString());
+
+  // So does every path from JSON to a message
+  pb::Arena arena;
+  pb::Message* message = conv.ConvertOnArena(text.data(), text.size(), book, &arena, options);
+  ASSERT_TRUE(message != NULL);
+  EXPECT_EQ(expected.DebugString(), message->DebugString());
+  Json::Value value;
+  ASSERT_TRUE(conv.Convert(book, &value));
+  message = conv.ConvertOnArena(value, book, &arena, options);
+  ASSERT_TRUE(message != NULL);
+  EXPECT_EQ(expected.DebugString(), message->DebugString());
+
+  // Required fields that are not selected are not required
+  std::string bytes;
+  ASSERT_TRUE(conv.TranscodeToWire(text.data(), text.size(), book.GetDescriptor(), &bytes,
+                                   options));
+  EXPECT_EQ(expected.SerializePartialAsString(), bytes);
+}
+
+}  // namespace pjconv
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-26
+ *
+ *
+ * The protoc plugin that generates JSON writers using generated accessors.
+ *
+ * Usage: protoc --plugin=protoc-gen-pjconv=PATH --pjconv_out=DIR FILE.proto
+ *
+ * For each FILE.proto it writes FILE.pjconv.h and FILE.pjconv.cc, to be
+ * compiled along with the FILE.pb.cc of protoc --cpp_out. The plugin only
+ * needs libprotobuf: the request and the response of the plugin protocol
+ * are read and written by hand instead of through libprotoc.
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "pjconv/json_codegen.h"
+
+namespace {
+
+namespace pb = google::protobuf;
+
+// Field numbers of CodeGeneratorRequest
+const int kFileToGenerate = 1;
+const int kProtoFile = 15;
+// Field numbers of CodeGeneratorResponse and its File
+const int kError = 1;
+const int kSupportedFeatures = 2;
+const int kFile = 15;
+const int kFileName = 1;
+const int kFileContent = 15;
+// CodeGeneratorResponse.FEATURE_PROTO3_OPTIONAL
+const int kFeatureProto3Optional = 1;
+
+struct Request {
+  std::vector<std::string> files_to_generate;
+  std::vector<pb::FileDescriptorProto> proto_files;
+};
+
+bool ParseRequest(const std::string& data, Request* request) {
+  pb::io::CodedInputStream input(reinterpret_cast<const pb::uint8*>(data.data()),
+                                 static_cast<int>(data.size()));
+  for (;;) {
+    pb::uint32 tag = input.ReadTag();
+    if (tag == 0) return true;
+    int number = pb::internal::WireFormatLite::GetTagFieldNumber(tag);
+    bool delimited = pb::internal::WireFormatLite::GetTagWireType(tag) ==
+        pb::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+    if (delimited && (number == kFileToGenerate || number == kProtoFile)) {
+      std::string value;
+      pb::uint32 length;
+      if (!input.ReadVarint32(&length) || !input.ReadString(&value, length)) return false;
+      if (number == kFileToGenerate) {
+        request->files_to_generate.push_back(value);
+      } else {
+        request->proto_files.push_back(pb::FileDescriptorProto());
+        if (!request->proto_files.back().ParseFromString(value)) return false;
+      }
+    } else if (!pb::internal::WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+}
+
+void AppendString(int number, const std::string& value, pb::io::CodedOutputStream* output) {
+  output->WriteTag(pb::internal::WireFormatLite::MakeTag(
+      number, pb::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+  output->WriteVarint32(static_cast<pb::uint32>(value.size()));
+  output->WriteString(value);
+}
+
+void AppendFile(const std::string& name, const std::string& content,
+                pb::io::CodedOutputStream* output) {
+  std::string file;
+  {
+    pb::io::StringOutputStream stream(&file);
+    pb::io::CodedOutputStream coded(&stream);
+    AppendString(kFileName, name, &coded);
+    AppendString(kFileContent, content, &coded);
+  }
+  AppendString(kFile, file, output);
+}
+
+// Generate the code of the requested files into the response; failures are
+// reported in the response, as protoc expects
+void GenerateFiles(const Request& request, pb::io::CodedOutputStream* output) {
+  output->WriteTag(pb::internal::WireFormatLite::MakeTag(
+      kSupportedFeatures, pb::internal::WireFormatLite::WIRETYPE_VARINT));
+  output->WriteVarint64(kFeatureProto3Optional);
+
+  // The files come with their imports, each after the files it imports
+  pb::DescriptorPool pool;
+  for (size_t i = 0; i < request.proto_files.size(); ++i) {
+    if (!pool.BuildFile(request.proto_files[i])) {
+      AppendString(kError, "Failed to load " + request.proto_files[i].name(), output);
+      return;
+    }
+  }
+  for (size_t i = 0; i < request.files_to_generate.size(); ++i) {
+    const pb::FileDescriptor* file = pool.FindFileByName(request.files_to_generate[i]);
+    if (!file) {
+      AppendString(kError, "Missing " + request.files_to_generate[i], output);
+      return;
+    }
+    pjconv::JsonCodeGenerator generator(file);
+    AppendFile(generator.HeaderName(), generator.GenerateHeader(), output);
+    AppendFile(generator.SourceName(), generator.GenerateSource(), output);
+  }
+}
+
+// @return the serialized response to the request
+std::string Generate(const Request& request) {
+  std::string response;
+  {
+    // The streams flush and trim the string when they are destroyed
+    pb::io::StringOutputStream stream(&response);
+    pb::io::CodedOutputStream output(&stream);
+    GenerateFiles(request, &output);
+  }
+  return response;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string data;
+  char buf[1 << 16];
+  size_t size;
+  while ((size = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+    data.append(buf, size);
+  }
+  Request request;
+  if (ferror(stdin) || !ParseRequest(data, &request)) {
+    fprintf(stderr, "%s: failed to read the request from protoc\n", argv[0]);
+    return 1;
+  }
+  std::string response = Generate(request);
+  if (fwrite(response.data(), 1, response.size(), stdout) != response.size() ||
+      fflush(stdout) != 0) {
+    fprintf(stderr, "%s: failed to write the response to protoc\n", argv[0]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+#include "pjconv/simd.h"
+
+namespace pjconv {
+
+namespace {
+
+#ifdef PJCONV_HAVE_X86_SIMD
+
+template<bool kControls>
+size_t Sse2(const char* data, size_t size) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash));
+    if (kControls) {
+      // An unsigned byte is at most 0x1f when the minimum of the two is itself
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(bytes, control), bytes));
+    }
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + FindStringByteScalar<kControls>(data + i, size - i);
+}
+
+template<bool kControls>
+__attribute__((target("avx2")))
+size_t Avx2(const char* data, size_t size) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1f);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote),
+                                   _mm256_cmpeq_epi8(bytes, backslash));
+    if (kControls) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, control), bytes));
+    }
+    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+  return i + Sse2<kControls>(data + i, size - i);
+}
+
+#endif  // PJCONV_HAVE_X86_SIMD
+
+}  // namespace
+
+bool CpuHasAvx2() {
+#ifdef PJCONV_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+bool CpuHasSsse3() {
+#ifdef PJCONV_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+#else
+  return false;
+#endif
+}
+
+FindStringByteFunc FindStringByteSse2(bool controls) {
+#ifdef PJCONV_HAVE_X86_SIMD
+  return controls ? Sse2<true> : Sse2<false>;
+#else
+  return NULL;
+#endif
+}
+
+FindStringByteFunc FindStringByteAvx2(bool controls) {
+#ifdef PJCONV_HAVE_X86_SIMD
+  if (CpuHasAvx2()) return controls ? Avx2<true> : Avx2<false>;
+#endif
+  return NULL;
+}
+
+}  // namespace pjconv
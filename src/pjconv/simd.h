@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-23
+ */
+
+
+#ifndef PJCONV_SIMD_H_
+#define PJCONV_SIMD_H_
+
+#include <cstddef>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define PJCONV_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace pjconv {
+
+/**
+ * What the scans of JSON text share: the features of the CPU the process
+ * runs on, and the search for the bytes that end a run of plain string
+ * bytes.
+ */
+
+/** @return whether the CPU has AVX2; false where x86 SIMD is not compiled in */
+bool CpuHasAvx2();
+
+/** @return whether the CPU has SSSE3; false where x86 SIMD is not compiled in */
+bool CpuHasSsse3();
+
+/**
+ * Find the first quote or backslash, and with kControls the first control
+ * byte below 0x20 as well: the bytes that end a string when it is read,
+ * and that must be escaped when it is written. This one goes a byte at a
+ * time.
+ *
+ * @return the offset of the byte, or size if there is none
+ */
+template<bool kControls>
+inline size_t FindStringByteScalar(const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c == '"' || c == '\\' || (kControls && c < 0x20)) return i;
+  }
+  return size;
+}
+
+typedef size_t (*FindStringByteFunc)(const char* data, size_t size);
+
+/**
+ * @return the search 16 bytes at a time, or NULL if SSE2 is not compiled in
+ */
+FindStringByteFunc FindStringByteSse2(bool controls);
+
+/**
+ * @return the search 32 bytes at a time, or NULL if AVX2 is not compiled
+ *     in or the CPU lacks it
+ */
+FindStringByteFunc FindStringByteAvx2(bool controls);
+
+}  // namespace pjconv
+#endif  // PJCONV_SIMD_H_
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-16
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pjconv/stats.h"
+#include "pjconv/stats_scope.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+std::string ConversionStats::ToPrometheus() const {
+  struct Sample {
+    const char* name;
+    const char* help;
+    const char* labels;
+    double value;
+  };
+  const Sample samples[] = {
+    {"pjconv_messages_total", "Messages converted.", "{direction=\"to_json\"}",
+     static_cast<double>(messages_to_json)},
+    {"pjconv_messages_total", NULL, "{direction=\"from_json\"}",
+     static_cast<double>(messages_from_json)},
+    {"pjconv_bytes_total", "Bytes of JSON text and serialized messages read and written.",
+     "{side=\"in\"}", static_cast<double>(bytes_in)},
+    {"pjconv_bytes_total", NULL, "{side=\"out\"}", static_cast<double>(bytes_out)},
+    {"pjconv_fields_visited_total", "Fields converted.", "",
+     static_cast<double>(fields_visited)},
+    {"pjconv_unknown_keys_skipped_total", "JSON members skipped for naming no field.", "",
+     static_cast<double>(unknown_keys_skipped)},
+    {"pjconv_mismatched_values_dropped_total",
+     "JSON values dropped for a type that does not fit their field.", "",
+     static_cast<double>(mismatched_values_dropped)},
+    {"pjconv_conversion_seconds_total", "Estimated time spent converting.",
+     "{direction=\"to_json\"}", nanoseconds_to_json / 1e9},
+    {"pjconv_conversion_seconds_total", NULL, "{direction=\"from_json\"}",
+     nanoseconds_from_json / 1e9},
+  };
+  std::string text;
+  char line[256];
+  for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i) {
+    const Sample& sample = samples[i];
+    if (sample.help) {
+      snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n", sample.name, sample.help,
+               sample.name);
+      text += line;
+    }
+    snprintf(line, sizeof(line), "%s%s %.17g\n", sample.name, sample.labels, sample.value);
+    text += line;
+  }
+  return text;
+}
+
+#ifdef PJCONV_STATS
+
+namespace {
+
+enum Counter {
+  kMessagesToJson,
+  kMessagesFromJson,
+  kBytesIn,
+  kBytesOut,
+  kFieldsVisited,
+  kUnknownKeysSkipped,
+  kMismatchedValuesDropped,
+  kNanosecondsToJson,
+  kNanosecondsFromJson,
+  kCounterCount,
+};
+
+// Time one in this many conversions on a thread
+const unsigned kTimeSample = 16;
+
+/**
+ * The counters of one thread. Only the thread writes them, so a relaxed
+ * load and store add to a counter without a locked instruction; the
+ * atomics only make the reads of a snapshot well-defined.
+ */
+struct Shard {
+  Shard() : calls(0) {
+    for (int i = 0; i < kCounterCount; ++i) {
+      counters[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void Add(Counter counter, pb::uint64 n) {
+    std::atomic<pb::uint64>& c = counters[counter];
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  std::atomic<pb::uint64> counters[kCounterCount];
+  /** The scopes the thread has opened, to pick the ones to time */
+  unsigned calls;
+};
+
+/**
+ * The shards of the live threads, and the sums of the threads gone
+ */
+struct Registry {
+  Registry() {
+    for (int i = 0; i < kCounterCount; ++i) {
+      retired[i] = 0;
+    }
+  }
+
+  std::mutex mutex;
+  std::vector<Shard*> shards;
+  pb::uint64 retired[kCounterCount];
+};
+
+Registry& GetRegistry() {
+  // Never destroyed, as threads may exit after the static destructors run
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+thread_local Shard* t_shard __attribute__((tls_model("initial-exec"))) = NULL;
+
+/**
+ * Hands the counts of a shard to the registry when its thread exits
+ */
+class ShardRetirer {
+ public:
+  ~ShardRetirer() {
+    if (!t_shard) return;
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kCounterCount; ++i) {
+      registry.retired[i] += t_shard->counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < registry.shards.size(); ++i) {
+      if (registry.shards[i] == t_shard) {
+        registry.shards.erase(registry.shards.begin() + i);
+        break;
+      }
+    }
+    delete t_shard;
+    t_shard = NULL;
+  }
+};
+
+Shard* LocalShard() {
+  if (!t_shard) {
+    // Constructed on the first conversion of the thread only
+    static thread_local ShardRetirer retirer;
+    (void)retirer;
+    Shard* shard = new Shard();
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.shards.push_back(shard);
+    t_shard = shard;
+  }
+  return t_shard;
+}
+
+}  // namespace
+
+__thread StatsScope* StatsScope::current_ = NULL;
+std::atomic<bool> StatsScope::enabled_(false);
+
+void StatsScope::Open() {
+  current_ = this;
+  sampled_ = LocalShard()->calls++ % kTimeSample == 0;
+  if (sampled_) start_ = std::chrono::steady_clock::now();
+}
+
+void StatsScope::Close() {
+  current_ = NULL;
+  Shard* shard = t_shard;
+  if (sampled_) {
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start_;
+    shard->Add(direction_ == kToJson ? kNanosecondsToJson : kNanosecondsFromJson,
+               static_cast<pb::uint64>(elapsed.count()) * kTimeSample);
+  }
+  if (ok_) shard->Add(direction_ == kToJson ? kMessagesToJson : kMessagesFromJson, 1);
+  if (bytes_in_) shard->Add(kBytesIn, bytes_in_);
+  if (bytes_out_) shard->Add(kBytesOut, bytes_out_);
+  if (fields_) shard->Add(kFieldsVisited, fields_);
+  if (unknown_keys_) shard->Add(kUnknownKeysSkipped, unknown_keys_);
+  if (dropped_values_) shard->Add(kMismatchedValuesDropped, dropped_values_);
+}
+
+ConversionStats GetConversionStats() {
+  pb::uint64 sums[kCounterCount];
+  Registry& registry = GetRegistry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (int i = 0; i < kCounterCount; ++i) {
+      sums[i] = registry.retired[i];
+      for (size_t j = 0; j < registry.shards.size(); ++j) {
+        sums[i] += registry.shards[j]->counters[i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  ConversionStats stats;
+  stats.messages_to_json = sums[kMessagesToJson];
+  stats.messages_from_json = sums[kMessagesFromJson];
+  stats.bytes_in = sums[kBytesIn];
+  stats.bytes_out = sums[kBytesOut];
+  stats.fields_visited = sums[kFieldsVisited];
+  stats.unknown_keys_skipped = sums[kUnknownKeysSkipped];
+  stats.mismatched_values_dropped = sums[kMismatchedValuesDropped];
+  stats.nanoseconds_to_json = sums[kNanosecondsToJson];
+  stats.nanoseconds_from_json = sums[kNanosecondsFromJson];
+  return stats;
+}
+
+void SetConversionStatsEnabled(bool enabled) {
+  StatsScope::enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+#else
+
+ConversionStats GetConversionStats() {
+  return ConversionStats();
+}
+
+void SetConversionStatsEnabled(bool enabled) {
+}
+
+#endif  // PJCONV_STATS
+
+}  // namespace pjconv
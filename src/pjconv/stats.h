@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-16
+ */
+
+#ifndef PJCONV_STATS_H_
+#define PJCONV_STATS_H_
+
+#include <string>
+#include <google/protobuf/stubs/common.h>
+
+namespace pjconv {
+
+/**
+ * Counts of the conversions made in this process so far, by every
+ * converter on every thread.
+ *
+ * The counters are only kept when the library is built with PJCONV_STATS
+ * defined and SetConversionStatsEnabled has turned counting on; otherwise
+ * they stay zero.
+ */
+struct ConversionStats {
+  ConversionStats()
+      : messages_to_json(0),
+        messages_from_json(0),
+        bytes_in(0),
+        bytes_out(0),
+        fields_visited(0),
+        unknown_keys_skipped(0),
+        mismatched_values_dropped(0),
+        nanoseconds_to_json(0),
+        nanoseconds_from_json(0) {
+  }
+
+  /** The messages converted to JSON text or Json::Value successfully */
+  google::protobuf::uint64 messages_to_json;
+  /** The messages filled or serialized from JSON successfully */
+  google::protobuf::uint64 messages_from_json;
+  /** The JSON text and serialized messages read */
+  google::protobuf::uint64 bytes_in;
+  /** The JSON text and serialized messages written */
+  google::protobuf::uint64 bytes_out;
+  /** The fields converted, each repeated field once */
+  google::protobuf::uint64 fields_visited;
+  /** The JSON members that name no field, or one a projection leaves out */
+  google::protobuf::uint64 unknown_keys_skipped;
+  /** The JSON values dropped because their type does not fit their field */
+  google::protobuf::uint64 mismatched_values_dropped;
+  /**
+   * The time spent converting in each direction, estimated by timing one
+   * in every 16 conversions on each thread
+   */
+  google::protobuf::uint64 nanoseconds_to_json;
+  google::protobuf::uint64 nanoseconds_from_json;
+
+  /**
+   * @return the counters in the Prometheus text exposition format
+   */
+  std::string ToPrometheus() const;
+};
+
+/**
+ * Take a snapshot of the conversion counters. Each counter is read on its
+ * own while other threads go on converting, so the snapshot is not taken
+ * at a single instant.
+ *
+ * @return the counts of the conversions so far
+ */
+ConversionStats GetConversionStats();
+
+/**
+ * Start or stop counting conversions, in every thread. Counting starts
+ * stopped, and then costs a load and a branch per conversion. Without
+ * PJCONV_STATS there is no counting to start, and this does nothing.
+ *
+ * @param enabled whether the conversions started from now on are counted
+ */
+void SetConversionStatsEnabled(bool enabled);
+
+}  // namespace pjconv
+#endif  // PJCONV_STATS_H_
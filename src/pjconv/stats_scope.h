@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-16
+ */
+
+#ifndef PJCONV_STATS_SCOPE_H_
+#define PJCONV_STATS_SCOPE_H_
+
+#include <cstddef>
+#include <google/protobuf/stubs/common.h>
+
+#ifdef PJCONV_STATS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace pjconv {
+
+/**
+ * Counts one conversion into the counters of its thread.
+ *
+ * The events of a conversion are counted in the scope, without atomics,
+ * and added to the thread's counters once it ends. A scope opened inside
+ * another on the same thread counts nothing, so public calls that call
+ * each other count one conversion. While counting is disabled a scope
+ * counts nothing either. Without PJCONV_STATS every member is empty and
+ * compiles away.
+ */
+class StatsScope {
+ public:
+  enum Direction { kToJson, kFromJson };
+
+#ifdef PJCONV_STATS
+  explicit StatsScope(Direction direction)
+      : direction_(direction),
+        active_(current_ == NULL && enabled_.load(std::memory_order_relaxed)),
+        sampled_(false), ok_(false),
+        bytes_in_(0), bytes_out_(0), fields_(0), unknown_keys_(0), dropped_values_(0) {
+    if (active_) Open();
+  }
+
+  ~StatsScope() {
+    if (active_) Close();
+  }
+
+  /** Count the conversion as done, with the bytes it read and wrote */
+  void Finish(bool ok, size_t bytes_in, size_t bytes_out) {
+    ok_ = ok;
+    bytes_in_ += bytes_in;
+    bytes_out_ += bytes_out;
+  }
+
+  static void CountFields(size_t n) {
+    if (current_) current_->fields_ += n;
+  }
+
+  static void CountUnknownKeys(size_t n) {
+    if (current_) current_->unknown_keys_ += n;
+  }
+
+  static void CountDroppedValue() {
+    if (current_) ++current_->dropped_values_;
+  }
+
+  static void CountBytesOut(size_t n) {
+    if (current_) current_->bytes_out_ += n;
+  }
+
+ private:
+  StatsScope(const StatsScope&);
+  void operator=(const StatsScope&);
+
+  void Open();
+  void Close();
+
+  /**
+   * The outermost scope of the thread, which the events are counted in;
+   * __thread, unlike thread_local, is read without a call in other files
+   */
+  static __thread StatsScope* current_ __attribute__((tls_model("initial-exec")));
+  /** Set by SetConversionStatsEnabled */
+  static std::atomic<bool> enabled_;
+  friend void SetConversionStatsEnabled(bool enabled);
+
+  Direction direction_;
+  bool active_;
+  bool sampled_;
+  bool ok_;
+  std::chrono::steady_clock::time_point start_;
+  size_t bytes_in_;
+  size_t bytes_out_;
+  size_t fields_;
+  size_t unknown_keys_;
+  size_t dropped_values_;
+#else
+  explicit StatsScope(Direction direction) {
+  }
+
+  void Finish(bool ok, size_t bytes_in, size_t bytes_out) {
+  }
+
+  static void CountFields(size_t n) {
+  }
+
+  static void CountUnknownKeys(size_t n) {
+  }
+
+  static void CountDroppedValue() {
+  }
+
+  static void CountBytesOut(size_t n) {
+  }
+#endif
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_STATS_SCOPE_H_
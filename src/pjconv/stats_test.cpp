@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-02-16
+ */
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/stats.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+TEST(ConversionStats, FormatsPrometheusText) {
+  ConversionStats stats;
+  stats.messages_to_json = 3;
+  stats.unknown_keys_skipped = 12345678901ULL;
+  stats.nanoseconds_from_json = 1500000000;
+  std::string text = stats.ToPrometheus();
+  EXPECT_NE(std::string::npos, text.find(
+      "# HELP pjconv_messages_total Messages converted.\n"
+      "# TYPE pjconv_messages_total counter\n"
+      "pjconv_messages_total{direction=\"to_json\"} 3\n"
+      "pjconv_messages_total{direction=\"from_json\"} 0\n"));
+  EXPECT_NE(std::string::npos, text.find("\npjconv_unknown_keys_skipped_total 12345678901\n"));
+  EXPECT_NE(std::string::npos,
+            text.find("\npjconv_conversion_seconds_total{direction=\"from_json\"} 1.5\n"));
+}
+
+#ifdef PJCONV_STATS
+
+TEST(ConversionStats, CountsConversionsToJson) {
+  SetConversionStatsEnabled(true);
+  PJConverter conv;
+  std::unique_ptr<pb::Message> types(test::NewSmallTypes());
+  ConvertOptions options;
+  options.convert_unset_fields = false;
+
+  ConversionStats before = GetConversionStats();
+  std::string json;
+  ASSERT_TRUE(conv.Write(*types, &json, options));
+  ConversionStats after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 1, after.messages_to_json);
+  EXPECT_EQ(before.bytes_out + json.size(), after.bytes_out);
+  // i32, s, inner and inner.x
+  EXPECT_EQ(before.fields_visited + 4, after.fields_visited);
+
+  before = after;
+  Json::Value value;
+  ASSERT_TRUE(conv.Convert(*types, &value, options));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 1, after.messages_to_json);
+  EXPECT_EQ(before.fields_visited + 4, after.fields_visited);
+  EXPECT_EQ(before.bytes_out, after.bytes_out);
+
+  // Styled text goes through a Json::Value, which is not counted again
+  before = after;
+  ASSERT_TRUE(conv.Convert(*types, &json, true, options));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 1, after.messages_to_json);
+  EXPECT_EQ(before.bytes_out + json.size(), after.bytes_out);
+
+  before = after;
+  test::StringSink sink;
+  ASSERT_TRUE(conv.Write(*types, &sink, options));
+  std::string bytes = types->SerializeAsString();
+  json.clear();
+  ASSERT_TRUE(conv.TranscodeToJson(bytes.data(), bytes.size(), types->GetDescriptor(), &json,
+                                   options));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 2, after.messages_to_json);
+  EXPECT_EQ(before.bytes_in + bytes.size(), after.bytes_in);
+  EXPECT_EQ(before.bytes_out + sink.text.size() + json.size(), after.bytes_out);
+  EXPECT_EQ(before.fields_visited + 8, after.fields_visited);
+}
+
+TEST(ConversionStats, CountsConversionsFromJson) {
+  SetConversionStatsEnabled(true);
+  PJConverter conv;
+  std::unique_ptr<pb::Message> types(test::NewTypes());
+  const std::string json = "{\"i32\":1,\"nope\":[1],\"s\":3,\"inner\":{\"x\":\"y\",\"tag\":\"t\"}}";
+
+  ConversionStats before = GetConversionStats();
+  ASSERT_TRUE(conv.Convert(json, types.get()));
+  ConversionStats after = GetConversionStats();
+  EXPECT_EQ(before.messages_from_json + 1, after.messages_from_json);
+  EXPECT_EQ(before.bytes_in + json.size(), after.bytes_in);
+  EXPECT_EQ(before.fields_visited + 5, after.fields_visited);
+  EXPECT_EQ(before.unknown_keys_skipped + 1, after.unknown_keys_skipped);
+  // s is not a string and x is not a number
+  EXPECT_EQ(before.mismatched_values_dropped + 2, after.mismatched_values_dropped);
+
+  Json::Value value;
+  ASSERT_TRUE(Json::Reader().parse(json, value));
+  before = after;
+  ASSERT_TRUE(conv.Convert(value, types.get()));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_from_json + 1, after.messages_from_json);
+  EXPECT_EQ(before.fields_visited + 5, after.fields_visited);
+  EXPECT_EQ(before.unknown_keys_skipped + 1, after.unknown_keys_skipped);
+  EXPECT_EQ(before.mismatched_values_dropped + 2, after.mismatched_values_dropped);
+
+  before = after;
+  std::string bytes;
+  ASSERT_TRUE(conv.TranscodeToWire(json.data(), json.size(), types->GetDescriptor(), &bytes));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_from_json + 1, after.messages_from_json);
+  EXPECT_EQ(before.bytes_in + json.size(), after.bytes_in);
+  EXPECT_EQ(before.bytes_out + bytes.size(), after.bytes_out);
+  EXPECT_EQ(before.mismatched_values_dropped + 2, after.mismatched_values_dropped);
+
+  // Failed conversions are not counted as messages
+  before = after;
+  EXPECT_FALSE(conv.Convert(std::string("{\"i32\":"), types.get()));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_from_json, after.messages_from_json);
+}
+
+TEST(ConversionStats, KeepsTheCountsOfExitedThreads) {
+  SetConversionStatsEnabled(true);
+  PJConverter conv;
+  std::unique_ptr<pb::Message> types(test::NewSmallTypes());
+  ConversionStats before = GetConversionStats();
+  std::thread worker([&conv, &types]() {
+    std::string json;
+    for (int i = 0; i < 100; ++i) {
+      json.clear();
+      conv.Write(*types, &json);
+    }
+  });
+  worker.join();
+  ConversionStats after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 100, after.messages_to_json);
+  // Some of the conversions are timed
+  EXPECT_GT(after.nanoseconds_to_json, before.nanoseconds_to_json);
+}
+
+TEST(ConversionStats, CountsOnlyWhileEnabled) {
+  PJConverter conv;
+  std::unique_ptr<pb::Message> types(test::NewSmallTypes());
+  std::string json;
+  SetConversionStatsEnabled(false);
+  ConversionStats before = GetConversionStats();
+  ASSERT_TRUE(conv.Write(*types, &json));
+  ASSERT_TRUE(conv.Convert(json, types.get()));
+  ConversionStats after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json, after.messages_to_json);
+  EXPECT_EQ(before.messages_from_json, after.messages_from_json);
+  EXPECT_EQ(before.bytes_out, after.bytes_out);
+  EXPECT_EQ(before.fields_visited, after.fields_visited);
+
+  SetConversionStatsEnabled(true);
+  ASSERT_TRUE(conv.Write(*types, &json));
+  after = GetConversionStats();
+  EXPECT_EQ(before.messages_to_json + 1, after.messages_to_json);
+}
+
+#endif  // PJCONV_STATS
+
+}  // namespace pjconv
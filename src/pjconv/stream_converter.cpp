@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-01
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <google/protobuf/io/coded_stream.h>
+
+#include "pjconv/stream_converter.h"
+#include "pjconv/bounded_queue.h"
+#include "pjconv/pjconv.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+// Spin this many times on an empty queue before yielding the processor
+const int kSpins = 64;
+// Yield this many times more before sleeping
+const int kYields = 64;
+// Sleep for a microsecond, then twice as long each time up to 1 << kMaxSleepShift
+const int kMaxSleepShift = 10;
+// Close a batch once its records take this many bytes
+const size_t kBatchBytes = 1 << 20;
+
+/**
+ * Back off while a queue stays empty: spin, then yield, then sleep, so that
+ * a stage waiting on a slow input or output does not hold a processor
+ */
+void Wait(int* spins) {
+  if (*spins < kSpins + kYields + kMaxSleepShift) ++*spins;
+  if (*spins < kSpins) return;
+  if (*spins < kSpins + kYields) {
+    std::this_thread::yield();
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(1 << (*spins - kSpins - kYields)));
+}
+
+}  // namespace
+
+/**
+ * Records travelling through the pipeline together
+ */
+struct StreamConverter::Batch {
+  /** The position of the batch in the stream */
+  size_t sequence;
+  /** The records back to back, and where each one ends */
+  std::string records;
+  std::vector<size_t> ends;
+  /** The JSON lines of the records */
+  std::string output;
+  size_t failures;
+};
+
+/**
+ * The state shared by the stages of one conversion
+ */
+struct StreamConverter::Pipeline {
+  explicit Pipeline(size_t count)
+      : free(count), parsed(count), converted(count), total(-1), corrupt(false),
+        stop(false) {
+  }
+
+  /** Wait for a batch; return false if the pipeline stops first */
+  bool Pop(BoundedQueue<Batch*>* queue, Batch** batch) {
+    for (int spins = 0; !queue->TryPop(batch); Wait(&spins)) {
+      if (stop.load(std::memory_order_relaxed)) return false;
+    }
+    return true;
+  }
+
+  std::vector<std::unique_ptr<Batch> > batches;
+  // Every batch is in one queue or held by one stage, and each queue can
+  // hold them all, so pushes never fail
+  BoundedQueue<Batch*> free;
+  BoundedQueue<Batch*> parsed;
+  BoundedQueue<Batch*> converted;
+  /** The number of batches in the stream, once the reader has reached its end */
+  std::atomic<long> total;
+  /** Whether the reader met a malformed record */
+  std::atomic<bool> corrupt;
+  /** Tells the stages to quit */
+  std::atomic<bool> stop;
+};
+
+StreamConverter::StreamConverter(
+    const PJConverter& converter,
+    const pb::Message& prototype,
+    const StreamOptions& options)
+    : converter_(converter), prototype_(prototype), options_(options) {
+  if (options_.workers <= 0) {
+    options_.workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  options_.records_per_batch = std::max(1, options_.records_per_batch);
+  if (options_.batches_in_flight <= 0) {
+    options_.batches_in_flight = 4 * options_.workers;
+  }
+  // Each worker holds a batch while the reader and the writer hold one more each
+  options_.batches_in_flight = std::max(options_.batches_in_flight, options_.workers + 2);
+}
+
+StreamConverter::~StreamConverter() {
+}
+
+bool StreamConverter::Convert(
+    pb::io::ZeroCopyInputStream* input,
+    pb::io::ZeroCopyOutputStream* output,
+    StreamStats* stats) {
+  size_t count = options_.batches_in_flight;
+  Pipeline pipeline(count);
+  for (size_t i = 0; i < count; ++i) {
+    pipeline.batches.push_back(std::unique_ptr<Batch>(new Batch()));
+    pipeline.free.TryPush(pipeline.batches[i].get());
+  }
+
+  std::thread reader(&StreamConverter::Read, this, input, &pipeline);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < options_.workers; ++i) {
+    workers.push_back(std::thread(&StreamConverter::Work, this, &pipeline));
+  }
+  StreamStats local;
+  bool ok = Write(output, &pipeline, stats ? stats : &local);
+  // Either every batch is written or the output failed; both end the pipeline
+  pipeline.stop.store(true);
+  reader.join();
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+  return ok && !pipeline.corrupt.load() && (stats ? stats : &local)->failures == 0;
+}
+
+void StreamConverter::Read(pb::io::ZeroCopyInputStream* input, Pipeline* pipeline) {
+  size_t sequence = 0;
+  bool end = false;
+  while (!end) {
+    Batch* batch;
+    if (!pipeline->Pop(&pipeline->free, &batch)) return;
+    batch->sequence = sequence;
+    batch->records.clear();
+    batch->ends.clear();
+    {
+      // A coded stream per batch, as its byte limit counts from its creation
+      pb::io::CodedInputStream coded(input);
+      while (batch->ends.size() < static_cast<size_t>(options_.records_per_batch) &&
+             batch->records.size() < kBatchBytes) {
+        const void* data;
+        int size;
+        if (!coded.GetDirectBufferPointer(&data, &size)) {
+          end = true;
+          break;
+        }
+        pb::uint32 length;
+        size_t offset = batch->records.size();
+        if (!coded.ReadVarint32(&length) || length > options_.max_record_size) {
+          pipeline->corrupt.store(true);
+          end = true;
+          break;
+        }
+        batch->records.resize(offset + length);
+        if (length > 0 && !coded.ReadRaw(&batch->records[offset], length)) {
+          batch->records.resize(offset);
+          pipeline->corrupt.store(true);
+          end = true;
+          break;
+        }
+        batch->ends.push_back(batch->records.size());
+      }
+    }
+    if (batch->ends.empty()) {
+      pipeline->free.TryPush(batch);
+    } else {
+      pipeline->parsed.TryPush(batch);
+      ++sequence;
+    }
+  }
+  pipeline->total.store(static_cast<long>(sequence), std::memory_order_release);
+}
+
+void StreamConverter::Work(Pipeline* pipeline) {
+  // Records go straight from the wire format to JSON, with no Message
+  const pb::Descriptor* type = prototype_.GetDescriptor();
+  Batch* batch;
+  while (pipeline->Pop(&pipeline->parsed, &batch)) {
+    batch->output.clear();
+    batch->failures = 0;
+    size_t begin = 0;
+    for (size_t i = 0; i < batch->ends.size(); ++i) {
+      size_t end = batch->ends[i];
+      if (converter_.TranscodeToJson(batch->records.data() + begin, end - begin, type,
+                                     &batch->output, options_.convert)) {
+        batch->output.push_back('\n');
+      } else {
+        ++batch->failures;
+      }
+      begin = end;
+    }
+    pipeline->converted.TryPush(batch);
+  }
+}
+
+bool StreamConverter::Write(
+    pb::io::ZeroCopyOutputStream* output,
+    Pipeline* pipeline,
+    StreamStats* stats) {
+  *stats = StreamStats();
+  // Batches finish out of order; fewer than count are ever in flight, so
+  // a batch waits in the slot of its sequence modulo count
+  size_t count = pipeline->batches.size();
+  std::vector<Batch*> pending(count, static_cast<Batch*>(NULL));
+  size_t next = 0;
+  int spins = 0;
+  for (;;) {
+    long total = pipeline->total.load(std::memory_order_acquire);
+    if (total >= 0 && next == static_cast<size_t>(total)) return true;
+    Batch* batch;
+    if (!pipeline->converted.TryPop(&batch)) {
+      Wait(&spins);
+      continue;
+    }
+    spins = 0;
+    pending[batch->sequence % count] = batch;
+    while ((batch = pending[next % count]) != NULL && batch->sequence == next) {
+      pending[next % count] = NULL;
+      stats->records += batch->ends.size();
+      stats->failures += batch->failures;
+      pb::io::CodedOutputStream coded(output);
+      coded.WriteRaw(batch->output.data(), static_cast<int>(batch->output.size()));
+      if (coded.HadError()) return false;
+      pipeline->free.TryPush(batch);
+      ++next;
+    }
+  }
+}
+
+}  // namespace pjconv
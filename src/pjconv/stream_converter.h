@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-01
+ */
+
+
+#ifndef PJCONV_STREAM_CONVERTER_H_
+#define PJCONV_STREAM_CONVERTER_H_
+
+#include <cstddef>
+#include <google/protobuf/message.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include "pjconv/options.h"
+
+namespace pjconv {
+
+class PJConverter;
+
+/**
+ * Options of a StreamConverter
+ */
+struct StreamOptions {
+  StreamOptions()
+      : workers(0),
+        records_per_batch(256),
+        batches_in_flight(0),
+        max_record_size(64 << 20) {
+  }
+
+  /** The number of converting threads, or 0 for one per hardware thread */
+  int workers;
+  /** The number of records handed between stages at a time */
+  int records_per_batch;
+  /** The number of batches in the pipeline, or 0 for four per worker */
+  int batches_in_flight;
+  /** Records larger than this are treated as a corrupt stream */
+  size_t max_record_size;
+  /** The options of each conversion */
+  ConvertOptions convert;
+};
+
+/**
+ * Counts of a stream conversion
+ */
+struct StreamStats {
+  StreamStats() : records(0), failures(0) {
+  }
+
+  /** The records read from the input */
+  size_t records;
+  /** The records that could not be parsed or converted, and were skipped */
+  size_t failures;
+};
+
+/**
+ * Converts a stream of length-delimited protobuf records to JSON lines.
+ *
+ * Each record is its size as a varint followed by the message. The
+ * conversion is a pipeline: a reader thread frames batches of records, the
+ * workers transcode them from the wire format to JSON, and the calling
+ * thread writes the JSON lines in input order. The stages are connected by bounded lock-free
+ * queues and a fixed number of batches circulate through them, so I/O
+ * overlaps conversion and memory use does not grow with the stream.
+ */
+class StreamConverter {
+ public:
+  /**
+   * @param converter the converter, shared by the workers
+   * @param prototype the type of the records
+   * @param options the options of the pipeline
+   */
+  StreamConverter(
+      const PJConverter& converter,
+      const google::protobuf::Message& prototype,
+      const StreamOptions& options = StreamOptions());
+  ~StreamConverter();
+
+  /**
+   * Convert every record of the input to one line of compact JSON
+   *
+   * @param input the length-delimited records
+   * @param output the JSON lines
+   * @param stats if not NULL, set to the counts of the conversion
+   * @return true if the whole input is framed, read and converted, and the output written
+   */
+  bool Convert(
+      google::protobuf::io::ZeroCopyInputStream* input,
+      google::protobuf::io::ZeroCopyOutputStream* output,
+      StreamStats* stats = NULL);
+
+ private:
+  struct Batch;
+  struct Pipeline;
+
+  StreamConverter(const StreamConverter&);
+  void operator=(const StreamConverter&);
+
+  void Read(google::protobuf::io::ZeroCopyInputStream* input, Pipeline* pipeline);
+  void Work(Pipeline* pipeline);
+  bool Write(
+      google::protobuf::io::ZeroCopyOutputStream* output,
+      Pipeline* pipeline,
+      StreamStats* stats);
+
+  const PJConverter& converter_;
+  const google::protobuf::Message& prototype_;
+  StreamOptions options_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_STREAM_CONVERTER_H_
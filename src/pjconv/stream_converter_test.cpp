@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-12-01
+ */
+
+
+#include <string>
+#include <gtest/gtest.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include "pjconv/pjconv.h"
+#include "pjconv/stream_converter.h"
+#include "pjconv/proto/addressbook.pb.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+void AppendRecord(const pb::Message& message, std::string* stream) {
+  std::string bytes;
+  message.SerializePartialToString(&bytes);
+  for (size_t size = bytes.size(); ; size >>= 7) {
+    if (size < 0x80) {
+      stream->push_back(static_cast<char>(size));
+      break;
+    }
+    stream->push_back(static_cast<char>(size | 0x80));
+  }
+  stream->append(bytes);
+}
+
+// Feed the input in small pieces so records straddle buffers
+bool Convert(StreamConverter* converter, const std::string& input, std::string* output,
+             StreamStats* stats) {
+  pb::io::ArrayInputStream in(input.data(), static_cast<int>(input.size()), 7);
+  output->clear();
+  pb::io::StringOutputStream out(output);
+  return converter->Convert(&in, &out, stats);
+}
+
+}  // namespace
+
+TEST(StreamConverter, ConvertsRecordsInOrder) {
+  PJConverter conv;
+  std::string input;
+  std::string expected;
+  std::string json;
+  for (int i = 0; i < 5000; ++i) {
+    tutorial::AddressBook book;
+    tutorial::Person* person = book.add_person();
+    person->set_name(std::string(i % 50, 'x'));
+    person->set_id(i);
+    AppendRecord(book, &input);
+    ASSERT_TRUE(conv.Convert(book, &json, false));
+    expected += json;
+  }
+  // An empty message is a record of size zero
+  AppendRecord(tutorial::AddressBook(), &input);
+  ASSERT_TRUE(conv.Convert(tutorial::AddressBook(), &json, false));
+  expected += json;
+
+  StreamOptions options;
+  options.workers = 3;
+  options.records_per_batch = 16;
+  StreamConverter converter(conv, tutorial::AddressBook::default_instance(), options);
+  std::string output;
+  StreamStats stats;
+  ASSERT_TRUE(Convert(&converter, input, &output, &stats));
+  EXPECT_EQ(5001u, stats.records);
+  EXPECT_EQ(0u, stats.failures);
+  EXPECT_EQ(expected, output);
+
+  // A converter can be reused, and an empty stream has no lines
+  ASSERT_TRUE(Convert(&converter, "", &output, &stats));
+  EXPECT_EQ(0u, stats.records);
+  EXPECT_EQ("", output);
+}
+
+TEST(StreamConverter, ReportsBadRecords) {
+  PJConverter conv;
+  tutorial::Person person;
+  person.set_name("bin3");
+  person.set_id(3);
+  std::string input;
+  AppendRecord(person, &input);
+  // Lacks the required fields
+  AppendRecord(tutorial::Person::PhoneNumber(), &input);
+  input += std::string("\x03\xff\xff\xff", 4);
+  AppendRecord(person, &input);
+
+  StreamOptions options;
+  options.workers = 2;
+  options.records_per_batch = 1;
+  StreamConverter converter(conv, tutorial::Person::default_instance(), options);
+  std::string output;
+  StreamStats stats;
+  EXPECT_FALSE(Convert(&converter, input, &output, &stats));
+  EXPECT_EQ(4u, stats.records);
+  EXPECT_EQ(2u, stats.failures);
+  std::string json;
+  ASSERT_TRUE(conv.Convert(person, &json, false));
+  EXPECT_EQ(json + json, output);
+
+  // The stream ends inside a record
+  input.resize(input.size() - 1);
+  EXPECT_FALSE(Convert(&converter, input, &output, &stats));
+  EXPECT_EQ(3u, stats.records);
+  EXPECT_EQ(json, output);
+}
+
+}  // namespace pjconv
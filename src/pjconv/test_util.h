@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-10-20
+ */
+
+#ifndef PJCONV_TEST_UTIL_H_
+#define PJCONV_TEST_UTIL_H_
+
+#include <limits>
+#include <string>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/text_format.h>
+
+#include "pjconv/json_sink.h"
+#include "pjconv/proto/addressbook.pb.h"
+
+namespace pjconv {
+namespace test {
+
+/**
+ * A message type covering every field type, built at runtime so that the
+ * tests do not depend on more generated code
+ */
+static const char kTypesProto[] =
+    "name: 'pjconv_test_types.proto' package: 'pjconv.test' "
+    "message_type { name: 'Inner' "
+    "  field { name: 'x' number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 } "
+    "  field { name: 'tag' number: 2 label: LABEL_OPTIONAL type: TYPE_STRING } "
+    "} "
+    "message_type { name: 'Types' "
+    "  field { name: 'i32' number: 1 label: LABEL_OPTIONAL type: TYPE_INT32 } "
+    "  field { name: 'i64' number: 2 label: LABEL_OPTIONAL type: TYPE_INT64 } "
+    "  field { name: 'u32' number: 3 label: LABEL_OPTIONAL type: TYPE_UINT32 } "
+    "  field { name: 'u64' number: 4 label: LABEL_OPTIONAL type: TYPE_UINT64 } "
+    "  field { name: 'd' number: 5 label: LABEL_OPTIONAL type: TYPE_DOUBLE } "
+    "  field { name: 'f' number: 6 label: LABEL_OPTIONAL type: TYPE_FLOAT } "
+    "  field { name: 'b' number: 7 label: LABEL_OPTIONAL type: TYPE_BOOL } "
+    "  field { name: 'color' number: 8 label: LABEL_OPTIONAL type: TYPE_ENUM "
+    "          type_name: '.pjconv.test.Types.Color' default_value: 'GREEN' } "
+    "  field { name: 's' number: 9 label: LABEL_OPTIONAL type: TYPE_STRING } "
+    "  field { name: 'inner' number: 10 label: LABEL_OPTIONAL type: TYPE_MESSAGE "
+    "          type_name: '.pjconv.test.Inner' } "
+    "  field { name: 'si32' number: 11 label: LABEL_OPTIONAL type: TYPE_SINT32 } "
+    "  field { name: 'fx64' number: 12 label: LABEL_OPTIONAL type: TYPE_FIXED64 } "
+    "  field { name: 'by' number: 13 label: LABEL_OPTIONAL type: TYPE_BYTES } "
+    "  field { name: 'r_i32' number: 21 label: LABEL_REPEATED type: TYPE_INT32 } "
+    "  field { name: 'r_i64' number: 22 label: LABEL_REPEATED type: TYPE_INT64 } "
+    "  field { name: 'r_u32' number: 23 label: LABEL_REPEATED type: TYPE_UINT32 } "
+    "  field { name: 'r_u64' number: 24 label: LABEL_REPEATED type: TYPE_UINT64 } "
+    "  field { name: 'r_d' number: 25 label: LABEL_REPEATED type: TYPE_DOUBLE } "
+    "  field { name: 'r_f' number: 26 label: LABEL_REPEATED type: TYPE_FLOAT } "
+    "  field { name: 'r_b' number: 27 label: LABEL_REPEATED type: TYPE_BOOL } "
+    "  field { name: 'r_color' number: 28 label: LABEL_REPEATED type: TYPE_ENUM "
+    "          type_name: '.pjconv.test.Types.Color' } "
+    "  field { name: 'r_s' number: 29 label: LABEL_REPEATED type: TYPE_STRING } "
+    "  field { name: 'r_inner' number: 30 label: LABEL_REPEATED type: TYPE_MESSAGE "
+    "          type_name: '.pjconv.test.Inner' } "
+    "  field { name: 'packed_i32' number: 31 label: LABEL_REPEATED type: TYPE_INT32 "
+    "          options { packed: true } } "
+    "  enum_type { name: 'Color' value { name: 'RED' number: 0 } "
+    "    value { name: 'GREEN' number: 1 } value { name: 'BLUE' number: 2 } } "
+    "}";
+
+/**
+ * @return the descriptor of pjconv.test.Types
+ */
+inline const google::protobuf::Descriptor* TypesDescriptor() {
+  static google::protobuf::DescriptorPool* pool = NULL;
+  if (!pool) {
+    google::protobuf::FileDescriptorProto file;
+    google::protobuf::TextFormat::ParseFromString(kTypesProto, &file);
+    pool = new google::protobuf::DescriptorPool();
+    pool->BuildFile(file);
+  }
+  return pool->FindMessageTypeByName("pjconv.test.Types");
+}
+
+/**
+ * @return a new, empty pjconv.test.Types message owned by the caller
+ */
+inline google::protobuf::Message* NewTypes() {
+  static google::protobuf::DynamicMessageFactory factory;
+  return factory.GetPrototype(TypesDescriptor())->New();
+}
+
+/**
+ * @return a new pjconv.test.Types message with a few fields set, owned by the
+ * caller. It is dynamic, so conversions never take a generated writer
+ */
+inline google::protobuf::Message* NewSmallTypes() {
+  google::protobuf::Message* m = NewTypes();
+  const google::protobuf::Descriptor* desc = m->GetDescriptor();
+  const google::protobuf::Reflection* ref = m->GetReflection();
+  ref->SetInt32(m, desc->FindFieldByName("i32"), 5);
+  ref->SetString(m, desc->FindFieldByName("s"), "text");
+  google::protobuf::Message* inner = ref->MutableMessage(m, desc->FindFieldByName("inner"));
+  inner->GetReflection()->SetInt32(inner, inner->GetDescriptor()->FindFieldByName("x"), 7);
+  return m;
+}
+
+/**
+ * A proto3 file: fields without presence, an open enum and a oneof
+ */
+static const char kEventProto[] =
+    "name: 'pjconv_test_event.proto' package: 'pjconv.test3' syntax: 'proto3' "
+    "message_type { name: 'Event' "
+    "  field { name: 'id' number: 1 label: LABEL_OPTIONAL type: TYPE_INT64 } "
+    "  field { name: 'name' number: 2 label: LABEL_OPTIONAL type: TYPE_STRING } "
+    "  field { name: 'level' number: 3 label: LABEL_OPTIONAL type: TYPE_ENUM "
+    "          type_name: '.pjconv.test3.Level' } "
+    "  field { name: 'text' number: 4 label: LABEL_OPTIONAL type: TYPE_STRING oneof_index: 0 } "
+    "  field { name: 'child' number: 5 label: LABEL_OPTIONAL type: TYPE_MESSAGE "
+    "          type_name: '.pjconv.test3.Child' oneof_index: 0 } "
+    "  field { name: 'score' number: 6 label: LABEL_OPTIONAL type: TYPE_DOUBLE } "
+    "  field { name: 'codes' number: 7 label: LABEL_REPEATED type: TYPE_SINT32 } "
+    "  oneof_decl { name: 'body' } "
+    "} "
+    "message_type { name: 'Child' "
+    "  field { name: 'id' number: 1 label: LABEL_OPTIONAL type: TYPE_INT64 } "
+    "  field { name: 'score' number: 6 label: LABEL_OPTIONAL type: TYPE_DOUBLE } "
+    "} "
+    "enum_type { name: 'Level' value { name: 'LOW' number: 0 } value { name: 'HIGH' number: 1 } }";
+
+/**
+ * @return the descriptor of pjconv.test3.Event
+ */
+inline const google::protobuf::Descriptor* EventDescriptor() {
+  static google::protobuf::DescriptorPool* pool = NULL;
+  if (!pool) {
+    google::protobuf::FileDescriptorProto file;
+    google::protobuf::TextFormat::ParseFromString(kEventProto, &file);
+    pool = new google::protobuf::DescriptorPool();
+    pool->BuildFile(file);
+  }
+  return pool->FindMessageTypeByName("pjconv.test3.Event");
+}
+
+/**
+ * @return a new, empty pjconv.test3.Event message owned by the caller
+ */
+inline google::protobuf::Message* NewEvent() {
+  static google::protobuf::DynamicMessageFactory factory;
+  return factory.GetPrototype(EventDescriptor())->New();
+}
+
+/**
+ * Fill every field of a pjconv.test.Types message, including the edge values
+ */
+inline void BuildTypes(google::protobuf::Message* m) {
+  namespace pb = google::protobuf;
+  const pb::Descriptor* desc = m->GetDescriptor();
+  const pb::Reflection* ref = m->GetReflection();
+  ref->SetInt32(m, desc->FindFieldByName("i32"), -42);
+  ref->SetInt64(m, desc->FindFieldByName("i64"), std::numeric_limits<pb::int64>::min());
+  ref->SetUInt32(m, desc->FindFieldByName("u32"), std::numeric_limits<pb::uint32>::max());
+  ref->SetUInt64(m, desc->FindFieldByName("u64"), std::numeric_limits<pb::uint64>::max());
+  ref->SetDouble(m, desc->FindFieldByName("d"), 2.5);
+  ref->SetFloat(m, desc->FindFieldByName("f"), 0.25f);
+  ref->SetBool(m, desc->FindFieldByName("b"), true);
+  const pb::FieldDescriptor* color = desc->FindFieldByName("color");
+  ref->SetEnum(m, color, color->enum_type()->FindValueByName("BLUE"));
+  ref->SetString(m, desc->FindFieldByName("s"), std::string("q\"b\\s/\b\f\n\r\t\x01\x1f\0", 14));
+  pb::Message* inner = ref->MutableMessage(m, desc->FindFieldByName("inner"));
+  inner->GetReflection()->SetInt32(inner, inner->GetDescriptor()->FindFieldByName("x"), 7);
+  ref->SetInt32(m, desc->FindFieldByName("si32"), -3);
+  ref->SetUInt64(m, desc->FindFieldByName("fx64"), 1234567890123ULL);
+
+  const pb::FieldDescriptor* field = desc->FindFieldByName("r_i32");
+  ref->AddInt32(m, field, std::numeric_limits<pb::int32>::min());
+  ref->AddInt32(m, field, 0);
+  ref->AddInt32(m, field, std::numeric_limits<pb::int32>::max());
+  field = desc->FindFieldByName("r_i64");
+  ref->AddInt64(m, field, -1);
+  ref->AddInt64(m, field, std::numeric_limits<pb::int64>::max());
+  field = desc->FindFieldByName("r_u32");
+  ref->AddUInt32(m, field, 0);
+  ref->AddUInt32(m, field, 100);
+  field = desc->FindFieldByName("r_u64");
+  ref->AddUInt64(m, field, 9);
+  ref->AddUInt64(m, field, 10000000000ULL);
+  field = desc->FindFieldByName("r_d");
+  ref->AddDouble(m, field, -1.0);
+  ref->AddDouble(m, field, 1e300);
+  ref->AddDouble(m, field, 0.5);
+  field = desc->FindFieldByName("r_f");
+  ref->AddFloat(m, field, 3.0f);
+  ref->AddFloat(m, field, -0.125f);
+  field = desc->FindFieldByName("r_b");
+  ref->AddBool(m, field, false);
+  ref->AddBool(m, field, true);
+  field = desc->FindFieldByName("r_color");
+  ref->AddEnum(m, field, field->enum_type()->FindValueByName("RED"));
+  ref->AddEnum(m, field, field->enum_type()->FindValueByName("GREEN"));
+  field = desc->FindFieldByName("r_s");
+  ref->AddString(m, field, "");
+  ref->AddString(m, field, "plain text");
+  field = desc->FindFieldByName("r_inner");
+  inner = ref->AddMessage(m, field);
+  inner->GetReflection()->SetString(inner, inner->GetDescriptor()->FindFieldByName("tag"), "a");
+  ref->AddMessage(m, field);
+  field = desc->FindFieldByName("packed_i32");
+  ref->AddInt32(m, field, 1);
+  ref->AddInt32(m, field, 300);
+}
+
+/**
+ * Build the address book used across the tests
+ */
+inline void BuildAddressBook(tutorial::AddressBook* ab) {
+  tutorial::Person* person = ab->add_person();
+  person->set_name("bin3");
+  person->set_id(0);
+  person->set_email("bin3@gmail.com");
+  tutorial::Person::PhoneNumber* number = person->add_phone();
+  number->set_number("10000");
+  number->set_type(tutorial::Person::HOME);
+  number = person->add_phone();
+  number->set_number("10001");
+  number->set_type(tutorial::Person::WORK);
+
+  person = ab->add_person();
+  person->set_name("pb");
+}
+
+/**
+ * A sink collecting the written JSON and counting the chunks it was given
+ */
+class StringSink : public JsonSink {
+ public:
+  StringSink() : chunks(0) {
+  }
+
+  virtual bool Append(const char* data, size_t size) {
+    text.append(data, size);
+    ++chunks;
+    return true;
+  }
+
+  std::string text;
+  size_t chunks;
+};
+
+}  // namespace test
+}  // namespace pjconv
+#endif  // PJCONV_TEST_UTIL_H_
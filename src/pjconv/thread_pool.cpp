@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-17
+ */
+
+
+#include <algorithm>
+
+#include "pjconv/thread_pool.h"
+
+namespace pjconv {
+
+namespace {
+
+// Chunks per worker when the caller does not choose a grain; more chunks
+// balance better, fewer cost less to queue
+const size_t kChunksPerWorker = 16;
+
+// The pool whose worker the thread is, and the index of the worker
+thread_local const ThreadPool* t_pool = NULL;
+thread_local int t_worker = -1;
+
+}  // namespace
+
+struct ThreadPool::Batch {
+  const RangeTask* task;
+  /** The chunks not yet run, guarded by mutex */
+  size_t remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+ThreadPool::ThreadPool(int threads) : queued_(0), stop_(false) {
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < threads; ++i) {
+    workers_.push_back(new Worker());
+  }
+  for (int i = 0; i < threads; ++i) {
+    workers_[i]->thread = std::thread(&ThreadPool::Loop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wakeup_.notify_all();
+  // Workers steal from each other until they exit, so join them all first
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread.join();
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    delete workers_[i];
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const RangeTask& task) {
+  if (count == 0) return;
+  size_t workers = workers_.size();
+  if (grain == 0) {
+    grain = std::max<size_t>(1, count / (workers * kChunksPerWorker));
+  }
+  size_t chunks = (count + grain - 1) / grain;
+
+  if (t_pool == this) {
+    // The other workers may all be waiting on the chunks of this one
+    for (size_t begin = 0; begin < count; begin += grain) {
+      task(begin, std::min(count, begin + grain), t_worker);
+    }
+    return;
+  }
+
+  Batch batch;
+  batch.task = &task;
+  batch.remaining = chunks;
+  // Count the chunks before queueing them, so the count never drops below zero
+  queued_.fetch_add(chunks);
+  // Worker w gets the chunks [w * chunks / workers, (w + 1) * chunks / workers)
+  for (size_t w = 0; w < workers; ++w) {
+    size_t first = w * chunks / workers;
+    size_t last = (w + 1) * chunks / workers;
+    if (first == last) continue;
+    Worker* worker = workers_[w];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    for (size_t c = first; c < last; ++c) {
+      Chunk chunk = { &batch, c * grain, std::min(count, (c + 1) * grain) };
+      worker->chunks.push_back(chunk);
+    }
+  }
+  {
+    // Idle workers check the count under the lock before they sleep
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wakeup_.notify_all();
+
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  while (batch.remaining > 0) {
+    batch.done.wait(lock);
+  }
+}
+
+void ThreadPool::Loop(int index) {
+  t_pool = this;
+  t_worker = index;
+  for (;;) {
+    Chunk chunk;
+    if (Pop(index, &chunk) || Steal(index, &chunk)) {
+      Run(chunk, index);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_ && queued_.load() == 0) {
+      wakeup_.wait(lock);
+    }
+    if (stop_ && queued_.load() == 0) return;
+  }
+}
+
+bool ThreadPool::Pop(int index, Chunk* chunk) {
+  Worker* worker = workers_[index];
+  std::lock_guard<std::mutex> lock(worker->mutex);
+  if (worker->chunks.empty()) return false;
+  *chunk = worker->chunks.back();
+  worker->chunks.pop_back();
+  queued_.fetch_sub(1);
+  return true;
+}
+
+bool ThreadPool::Steal(int index, Chunk* chunk) {
+  int n = size();
+  for (int i = 1; i < n; ++i) {
+    Worker* victim = workers_[(index + i) % n];
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (victim->chunks.empty()) continue;
+    *chunk = victim->chunks.front();
+    victim->chunks.pop_front();
+    queued_.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Run(const Chunk& chunk, int worker) {
+  Batch* batch = chunk.batch;
+  (*batch->task)(chunk.begin, chunk.end, worker);
+  // The waiter destroys the batch once it sees zero, so count under the lock
+  std::lock_guard<std::mutex> lock(batch->mutex);
+  if (--batch->remaining == 0) {
+    batch->done.notify_one();
+  }
+}
+
+}  // namespace pjconv
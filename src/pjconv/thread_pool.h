@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-17
+ */
+
+
+#ifndef PJCONV_THREAD_POOL_H_
+#define PJCONV_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pjconv {
+
+/**
+ * A fixed set of worker threads that run index ranges in parallel.
+ *
+ * ParallelFor cuts a range into chunks and deals out contiguous runs of
+ * chunks to the workers' own queues. A worker takes chunks from the back of
+ * its queue and, once it is empty, steals from the front of the others', so
+ * uneven items still keep every worker busy. Any number of threads may call
+ * ParallelFor at once; their chunks share the workers.
+ *
+ * A task may call ParallelFor on the pool that runs it. As the calling
+ * worker cannot wait for chunks that may be queued behind its own, it runs
+ * the nested chunks itself, one after another, under its own index.
+ */
+class ThreadPool {
+ public:
+  /**
+   * Run the items [begin, end) on the worker with the given index
+   */
+  typedef std::function<void(size_t begin, size_t end, int worker)> RangeTask;
+
+  /**
+   * @param threads the number of workers, or 0 for one per hardware thread
+   */
+  explicit ThreadPool(int threads = 0);
+  ~ThreadPool();
+
+  /**
+   * @return the number of workers; worker indexes are below it
+   */
+  int size() const {
+    return static_cast<int>(workers_.size());
+  }
+
+  /**
+   * Run a task over the items [0, count) and wait for it to finish. Called
+   * from a worker of this pool, run it on the calling thread instead.
+   *
+   * @param count the number of items
+   * @param grain the least number of items in a chunk, or 0 to choose one
+   * @param task the task, called once per chunk
+   */
+  void ParallelFor(size_t count, size_t grain, const RangeTask& task);
+
+ private:
+  struct Batch;
+
+  struct Chunk {
+    Batch* batch;
+    size_t begin;
+    size_t end;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Chunk> chunks;
+    std::thread thread;
+  };
+
+  ThreadPool(const ThreadPool&);
+  void operator=(const ThreadPool&);
+
+  void Loop(int index);
+  bool Pop(int index, Chunk* chunk);
+  bool Steal(int index, Chunk* chunk);
+  void Run(const Chunk& chunk, int worker);
+
+  std::vector<Worker*> workers_;
+  /** Guards stop_ and the sleeping of idle workers */
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  /** The number of chunks in all the queues */
+  std::atomic<size_t> queued_;
+  bool stop_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_THREAD_POOL_H_
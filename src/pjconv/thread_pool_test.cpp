@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2013-11-17
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pjconv/thread_pool.h"
+
+namespace pjconv {
+
+TEST(ThreadPool, RunsEveryItemOnce) {
+  ThreadPool pool(4);
+  ASSERT_EQ(4, pool.size());
+  const size_t kCounts[] = { 0, 1, 3, 64, 1000, 12345 };
+  const size_t kGrains[] = { 0, 1, 7, 100000 };
+  for (size_t c = 0; c < sizeof(kCounts) / sizeof(kCounts[0]); ++c) {
+    for (size_t g = 0; g < sizeof(kGrains) / sizeof(kGrains[0]); ++g) {
+      std::vector<int> runs(kCounts[c], 0);
+      std::atomic<bool> bad_worker(false);
+      pool.ParallelFor(kCounts[c], kGrains[g], [&runs, &bad_worker, &pool](
+          size_t begin, size_t end, int worker) {
+        if (worker < 0 || worker >= pool.size()) bad_worker = true;
+        for (size_t i = begin; i < end; ++i) {
+          ++runs[i];
+        }
+      });
+      EXPECT_FALSE(bad_worker.load());
+      for (size_t i = 0; i < runs.size(); ++i) {
+        ASSERT_EQ(1, runs[i]) << "count " << kCounts[c] << " grain " << kGrains[g]
+                              << " item " << i;
+      }
+    }
+  }
+}
+
+TEST(ThreadPool, StealsFromBusyWorkers) {
+  ThreadPool pool(4);
+  // The first quarter of the items, dealt to worker 0, are slow
+  std::vector<int> ran_on(400, -1);
+  pool.ParallelFor(400, 1, [&ran_on](size_t begin, size_t end, int worker) {
+    if (begin < 100) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    ran_on[begin] = worker;
+  });
+  int on_zero = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_NE(-1, ran_on[i]);
+    if (ran_on[i] == 0) ++on_zero;
+  }
+  EXPECT_LT(on_zero, 100);
+}
+
+TEST(ThreadPool, SharedByConcurrentCallers) {
+  ThreadPool pool(3);
+  const int kCallers = 4;
+  std::vector<long> sums(kCallers, 0);
+  std::vector<std::thread> callers;
+  for (int t = 0; t < kCallers; ++t) {
+    callers.push_back(std::thread([&pool, &sums, t]() {
+      for (int round = 0; round < 20; ++round) {
+        std::atomic<long> sum(0);
+        pool.ParallelFor(1000, 0, [&sum](size_t begin, size_t end, int worker) {
+          for (size_t i = begin; i < end; ++i) {
+            sum += i;
+          }
+        });
+        sums[t] += sum.load();
+      }
+    }));
+  }
+  for (int t = 0; t < kCallers; ++t) {
+    callers[t].join();
+    EXPECT_EQ(20L * 999 * 1000 / 2, sums[t]);
+  }
+}
+
+TEST(ThreadPool, RunsNestedCallsOnTheCallingWorker) {
+  ThreadPool pool(2);
+  // Every worker blocks in a nested call at once
+  std::vector<long> sums(16, 0);
+  std::atomic<bool> moved(false);
+  pool.ParallelFor(sums.size(), 1, [&pool, &sums, &moved](size_t begin, size_t end, int worker) {
+    pool.ParallelFor(1000, 10, [&sums, &moved, begin, worker](
+        size_t inner_begin, size_t inner_end, int inner_worker) {
+      if (inner_worker != worker) moved = true;
+      for (size_t i = inner_begin; i < inner_end; ++i) {
+        sums[begin] += i;
+      }
+    });
+  });
+  EXPECT_FALSE(moved.load());
+  for (size_t i = 0; i < sums.size(); ++i) {
+    EXPECT_EQ(999L * 1000 / 2, sums[i]);
+  }
+}
+
+}  // namespace pjconv
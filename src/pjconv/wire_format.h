@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-12
+ */
+
+#ifndef PJCONV_WIRE_FORMAT_H_
+#define PJCONV_WIRE_FORMAT_H_
+
+#include <string>
+#include <google/protobuf/descriptor.h>
+
+namespace pjconv {
+
+/**
+ * The protobuf wire types
+ */
+enum WireType {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kStartGroup = 3,
+  kEndGroup = 4,
+  kFixed32 = 5
+};
+
+/**
+ * @return the wire type of an unpacked value of a field type
+ */
+inline int WireTypeOf(google::protobuf::FieldDescriptor::Type type) {
+  switch (type) {
+    case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+      return kFixed64;
+    case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+      return kFixed32;
+    case google::protobuf::FieldDescriptor::TYPE_STRING:
+    case google::protobuf::FieldDescriptor::TYPE_BYTES:
+    case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+      return kLengthDelimited;
+    case google::protobuf::FieldDescriptor::TYPE_GROUP:
+      return kStartGroup;
+    default:
+      return kVarint;
+  }
+}
+
+/**
+ * Read a varint of at most ten bytes
+ *
+ * @return false if the input ends first or the varint is longer
+ */
+inline bool ReadVarint(const char** p, const char* end, google::protobuf::uint64* value) {
+  google::protobuf::uint64 result = 0;
+  for (int shift = 0; shift < 70 && *p < end; shift += 7) {
+    google::protobuf::uint8 byte = static_cast<google::protobuf::uint8>(*(*p)++);
+    result |= static_cast<google::protobuf::uint64>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Write a varint into a buffer of at least ten bytes
+ *
+ * @return the end of the written bytes
+ */
+inline char* EncodeVarint(google::protobuf::uint64 value, char* buffer) {
+  while (value >= 0x80) {
+    *buffer++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *buffer++ = static_cast<char>(value);
+  return buffer;
+}
+
+inline void AppendVarint(google::protobuf::uint64 value, std::string* output) {
+  char buffer[10];
+  output->append(buffer, EncodeVarint(value, buffer) - buffer);
+}
+
+/**
+ * Append the low size bytes of a value, little-endian whatever the host is
+ */
+inline void AppendFixed(google::protobuf::uint64 value, int size, std::string* output) {
+  char buffer[8];
+  for (int i = 0; i < size; ++i) {
+    buffer[i] = static_cast<char>(value >> (8 * i));
+  }
+  output->append(buffer, size);
+}
+
+}  // namespace pjconv
+#endif  // PJCONV_WIRE_FORMAT_H_
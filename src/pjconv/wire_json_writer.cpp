@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-05
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "pjconv/wire_json_writer.h"
+#include "pjconv/json_scan.h"
+#include "pjconv/json_writer.h"
+#include "pjconv/number_format.h"
+#include "pjconv/stats_scope.h"
+#include "pjconv/wire_format.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+// The nesting protobuf's parser allows by default
+const size_t kMaxDepth = 100;
+
+const pb::uint64 kMaxFieldNumber = (1 << 29) - 1;
+
+const size_t kNone = static_cast<size_t>(-1);
+
+bool ReadFixed(const char** p, const char* end, int size, pb::uint64* value) {
+  if (end - *p < size) return false;
+  // Little-endian whatever the host is
+  pb::uint64 result = 0;
+  for (int i = size - 1; i >= 0; --i) {
+    result = (result << 8) | static_cast<pb::uint8>((*p)[i]);
+  }
+  *p += size;
+  *value = result;
+  return true;
+}
+
+// Read the value of a field whose tag has been read. Length-delimited
+// values and groups are returned as their bytes, without the end tag.
+bool ReadField(const char** p, const char* end, int wire, pb::uint64 number, size_t depth,
+               const char** data, pb::uint64* value) {
+  switch (wire) {
+    case kVarint:
+      return ReadVarint(p, end, value);
+    case kFixed64:
+      return ReadFixed(p, end, 8, value);
+    case kFixed32:
+      return ReadFixed(p, end, 4, value);
+    case kLengthDelimited:
+      if (!ReadVarint(p, end, value) || *value > static_cast<pb::uint64>(end - *p)) return false;
+      *data = *p;
+      *p += *value;
+      return true;
+    case kStartGroup: {
+      if (depth >= kMaxDepth) return false;
+      const char* start = *p;
+      for (;;) {
+        const char* tag_start = *p;
+        pb::uint64 tag;
+        if (!ReadVarint(p, end, &tag)) return false;
+        if ((tag & 7) == kEndGroup) {
+          if ((tag >> 3) != number) return false;
+          *data = start;
+          *value = tag_start - start;
+          return true;
+        }
+        const char* inner_data;
+        pb::uint64 inner_value;
+        if (!ReadField(p, end, tag & 7, tag >> 3, depth + 1, &inner_data, &inner_value)) {
+          return false;
+        }
+      }
+    }
+    default:
+      // A stray end of group or an undefined wire type
+      return false;
+  }
+}
+
+// The bits of the C++ value a wire value stands for: signed 32-bit values
+// are sign-extended, unsigned ones truncated and zigzag undone
+pb::uint64 Decode(pb::FieldDescriptor::Type type, pb::uint64 raw) {
+  switch (type) {
+    case pb::FieldDescriptor::TYPE_INT32:
+    case pb::FieldDescriptor::TYPE_SFIXED32:
+    case pb::FieldDescriptor::TYPE_ENUM:
+      return static_cast<pb::uint64>(static_cast<pb::int64>(static_cast<pb::int32>(raw)));
+    case pb::FieldDescriptor::TYPE_UINT32:
+    case pb::FieldDescriptor::TYPE_FIXED32:
+      return static_cast<pb::uint32>(raw);
+    case pb::FieldDescriptor::TYPE_SINT32: {
+      pb::uint32 n = static_cast<pb::uint32>(raw);
+      pb::int32 value = static_cast<pb::int32>((n >> 1) ^ (0 - (n & 1)));
+      return static_cast<pb::uint64>(static_cast<pb::int64>(value));
+    }
+    case pb::FieldDescriptor::TYPE_SINT64:
+      return (raw >> 1) ^ (0 - (raw & 1));
+    case pb::FieldDescriptor::TYPE_BOOL:
+      return raw != 0;
+    default:
+      return raw;
+  }
+}
+
+bool IsProto3(const pb::FieldDescriptor* field) {
+  return field->file()->syntax() == pb::FileDescriptor::SYNTAX_PROTO3;
+}
+
+}  // namespace
+
+WireJsonWriter::WireJsonWriter(PlanCache* plans, const ConvertOptions& options)
+    : plans_(plans), options_(options), output_(NULL), depth_(0) {
+}
+
+WireJsonWriter::~WireJsonWriter() {
+}
+
+bool WireJsonWriter::Write(const char* data, size_t size, const pb::Descriptor* desc,
+                           std::string* output) {
+  output_ = output;
+  depth_ = 0;
+  size_t start = output->size();
+  const MessagePlan* plan = plans_->Get(desc, options_.projection);
+  if (!plan) return false;
+  Entry chunk = {0, 0, data, size};
+  if (!WriteMessage(*plan, &chunk, 1)) {
+    output->resize(start);
+    return false;
+  }
+  return true;
+}
+
+bool WireJsonWriter::WriteMessage(const MessagePlan& plan, const Entry* chunks, size_t count) {
+  if (depth_ >= kMaxDepth) return false;
+  if (levels_.size() == depth_) levels_.push_back(std::unique_ptr<Level>(new Level()));
+  Level& level = *levels_[depth_++];
+  level.entries.clear();
+  Oneof none = {kNone, 0};
+  level.oneofs.assign(plan.descriptor->oneof_decl_count(), none);
+  // Merging occurrences of a message is the same as parsing their concatenation
+  bool ok = true;
+  for (size_t i = 0; ok && i < count; ++i) {
+    ok = Scan(plan, chunks[i].data, chunks[i].data + chunks[i].value, &level);
+  }
+  if (ok) {
+    std::sort(level.entries.begin(), level.entries.end());
+    ok = WriteFields(plan, level, count > 0);
+  }
+  --depth_;
+  return ok;
+}
+
+bool WireJsonWriter::Scan(const MessagePlan& plan, const char* p, const char* end, Level* level) {
+  while (p < end) {
+    pb::uint64 tag;
+    if (!ReadVarint(&p, end, &tag)) return false;
+    int wire = static_cast<int>(tag & 7);
+    pb::uint64 number = tag >> 3;
+    if (number == 0 || number > kMaxFieldNumber) return false;
+    const char* data = NULL;
+    pb::uint64 value;
+    if (!ReadField(&p, end, wire, number, depth_, &data, &value)) return false;
+
+    const FieldPlan* field = plan.FindByNumber(static_cast<int>(number));
+    if (!field) continue;
+    size_t pos = field - &plan.fields[0];
+    pb::FieldDescriptor::Type type = field->field->type();
+    int expected = WireTypeOf(type);
+    if (wire == expected) {
+      if (!AddValue(*field, pos, data, Decode(type, value), level)) return false;
+    } else if (wire == kLengthDelimited && field->field->is_packable()) {
+      // Packed and unpacked repeated scalars are accepted either way
+      const char* packed = data;
+      const char* packed_end = data + value;
+      while (packed < packed_end) {
+        pb::uint64 element;
+        if (!ReadField(&packed, packed_end, expected, number, depth_, NULL, &element) ||
+            !AddValue(*field, pos, NULL, Decode(type, element), level)) {
+          return false;
+        }
+      }
+    }
+    // Any other wire type makes the value an unknown field
+  }
+  return true;
+}
+
+bool WireJsonWriter::AddValue(const FieldPlan& field, size_t pos, const char* data,
+                              pb::uint64 value, Level* level) {
+  const pb::FieldDescriptor* desc = field.field;
+  if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_ENUM && !IsProto3(desc) &&
+      !field.enums->FindByNumber(static_cast<int>(value))) {
+    // A closed enum keeps unknown values among the unknown fields
+    return true;
+  }
+  if (desc->type() == pb::FieldDescriptor::TYPE_STRING && IsProto3(desc) &&
+      !ValidateUtf8(data, value)) {
+    return false;
+  }
+  const pb::OneofDescriptor* oneof = desc->containing_oneof();
+  if (oneof) {
+    Oneof& current = level->oneofs[oneof->index()];
+    if (current.pos != pos) {
+      current.pos = pos;
+      current.since = level->entries.size();
+    }
+  }
+  Entry entry = {pos, level->entries.size(), data, value};
+  level->entries.push_back(entry);
+  return true;
+}
+
+bool WireJsonWriter::WriteFields(const MessagePlan& plan, const Level& level, bool present) {
+  const std::vector<Entry>& entries = level.entries;
+  bool empty = true;
+  size_t fields = 0;
+  size_t end = 0;
+  for (size_t i = 0; i < plan.fields.size(); ++i) {
+    const FieldPlan& field = plan.fields[i];
+    size_t begin = end;
+    while (end < entries.size() && entries[end].pos == i) ++end;
+    const pb::OneofDescriptor* oneof = field.field->containing_oneof();
+    if (oneof) {
+      // Only the values since the member was last set count
+      const Oneof& current = level.oneofs[oneof->index()];
+      if (current.pos != i) begin = end;
+      while (begin < end && entries[begin].seq < current.since) ++begin;
+    }
+    bool has = begin < end;
+    if (present && !has && field.field->is_required()) return false;
+    if (has && !field.repeated && field.cpp_type != pb::FieldDescriptor::CPPTYPE_MESSAGE &&
+        !field.field->has_presence() && entries[end - 1].value == 0) {
+      // A field without presence is unset when it holds zero or ""
+      has = false;
+    }
+    if (field.repeated) {
+      if (!has) continue;
+    } else if (!has && !options_.convert_unset_fields) {
+      continue;
+    }
+
+    output_->push_back(empty ? '{' : ',');
+    empty = false;
+    ++fields;
+    output_->append(field.key);
+    if (field.repeated) {
+      output_->push_back('[');
+      for (size_t j = begin; j < end; ++j) {
+        if (j > begin) output_->push_back(',');
+        if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+          if (!WriteMessage(*field.message, &entries[j], 1)) return false;
+        } else {
+          WriteValue(field, entries[j]);
+        }
+      }
+      output_->push_back(']');
+    } else if (field.cpp_type == pb::FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (!WriteMessage(*field.message, entries.data() + begin, end - begin)) return false;
+    } else if (has) {
+      WriteValue(field, entries[end - 1]);
+    } else {
+      WriteDefault(field);
+    }
+  }
+  StatsScope::CountFields(fields);
+  if (empty) {
+    // A Json::Value that never got a member stays null
+    output_->append("null", 4);
+  } else {
+    output_->push_back('}');
+  }
+  return true;
+}
+
+void WireJsonWriter::WriteValue(const FieldPlan& field, const Entry& entry) {
+  char buf[kMaxNumberSize];
+  switch (field.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      output_->append(buf, FormatInt64(static_cast<pb::int64>(entry.value), buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      output_->append(buf, FormatUInt64(entry.value, buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE: {
+      double value;
+      memcpy(&value, &entry.value, sizeof(value));
+      AppendJsonDouble(value, output_);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_FLOAT: {
+      pb::uint32 bits = static_cast<pb::uint32>(entry.value);
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      AppendJsonFloat(value, output_);
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      if (entry.value) {
+        output_->append("true", 4);
+      } else {
+        output_->append("false", 5);
+      }
+      break;
+    case pb::FieldDescriptor::CPPTYPE_ENUM: {
+      int number = static_cast<int>(entry.value);
+      const pb::EnumValueDescriptor* value = field.enums->FindByNumber(number);
+      if (value) {
+        AppendJsonEnum(*field.enums, value, output_);
+      } else {
+        AppendJsonUnknownEnum(field.enums->descriptor->name(), number, output_);
+      }
+      break;
+    }
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      AppendJsonString(entry.data, entry.value, output_);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+void WireJsonWriter::WriteDefault(const FieldPlan& field) {
+  const pb::FieldDescriptor* desc = field.field;
+  char buf[kMaxNumberSize];
+  switch (field.cpp_type) {
+    case pb::FieldDescriptor::CPPTYPE_INT32:
+      output_->append(buf, FormatInt64(desc->default_value_int32(), buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_INT64:
+      output_->append(buf, FormatInt64(desc->default_value_int64(), buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT32:
+      output_->append(buf, FormatUInt64(desc->default_value_uint32(), buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_UINT64:
+      output_->append(buf, FormatUInt64(desc->default_value_uint64(), buf) - buf);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_DOUBLE:
+      AppendJsonDouble(desc->default_value_double(), output_);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_FLOAT:
+      AppendJsonFloat(desc->default_value_float(), output_);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_BOOL:
+      if (desc->default_value_bool()) {
+        output_->append("true", 4);
+      } else {
+        output_->append("false", 5);
+      }
+      break;
+    case pb::FieldDescriptor::CPPTYPE_ENUM:
+      AppendJsonEnum(*field.enums, desc->default_value_enum(), output_);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_STRING:
+      AppendJsonString(desc->default_value_string().data(), desc->default_value_string().size(),
+                       output_);
+      break;
+    case pb::FieldDescriptor::CPPTYPE_MESSAGE:
+      break;
+  }
+}
+
+}  // namespace pjconv
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-05
+ */
+
+#ifndef PJCONV_WIRE_JSON_WRITER_H_
+#define PJCONV_WIRE_JSON_WRITER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+
+#include "pjconv/options.h"
+#include "pjconv/plan.h"
+
+namespace pjconv {
+
+/**
+ * Writes serialized protobuf bytes as compact JSON text, decoding the wire
+ * format against the descriptor without building a Message.
+ *
+ * Each message is scanned once into a list of the values it holds, which
+ * point into the input, and the list is then written in JSON member order.
+ * The output is the text JsonWriter writes for the message the bytes parse
+ * into: the last value of a singular field wins, the occurrences of an
+ * embedded message are merged, setting a member of a oneof clears the
+ * others, and unknown fields and unknown values of closed enums are dropped.
+ * Map entries are written in the order they appear on the wire.
+ *
+ * A writer keeps scratch buffers between calls, so reusing one instance
+ * avoids allocations; an instance must not be used by two threads at once.
+ */
+class WireJsonWriter {
+ public:
+  /**
+   * @param plans the cache of conversion plans
+   * @param options the options of the conversion
+   */
+  WireJsonWriter(PlanCache* plans, const ConvertOptions& options);
+  ~WireJsonWriter();
+
+  /**
+   * Append a serialized message as a JSON object
+   *
+   * @param data the serialized message
+   * @param size the length of the serialized message
+   * @param desc the type of the message
+   * @param output the string the JSON text is appended to
+   * @return false if the bytes do not parse as a message of the type, in
+   *     which case the output is left as it was, or the projection of the
+   *     options is of another type
+   */
+  bool Write(const char* data, size_t size, const google::protobuf::Descriptor* desc,
+             std::string* output);
+
+ private:
+  /**
+   * A value on the wire. Numbers are decoded into the bits of their C++
+   * type; strings, embedded messages and groups point at their bytes.
+   */
+  struct Entry {
+    /** The index of the field in MessagePlan::fields */
+    size_t pos;
+    /** The order of the value within its message */
+    size_t seq;
+    const char* data;
+    /** The number, or the length of data */
+    google::protobuf::uint64 value;
+
+    bool operator<(const Entry& other) const {
+      return pos < other.pos || (pos == other.pos && seq < other.seq);
+    }
+  };
+
+  /** The member of a oneof set last, and the first value it got since */
+  struct Oneof {
+    size_t pos;
+    size_t since;
+  };
+
+  /** The scratch space of one level of nesting */
+  struct Level {
+    std::vector<Entry> entries;
+    std::vector<Oneof> oneofs;
+  };
+
+  WireJsonWriter(const WireJsonWriter&);
+  void operator=(const WireJsonWriter&);
+
+  bool WriteMessage(const MessagePlan& plan, const Entry* chunks, size_t count);
+  bool WriteFields(const MessagePlan& plan, const Level& level, bool present);
+  bool Scan(const MessagePlan& plan, const char* p, const char* end, Level* level);
+  bool AddValue(const FieldPlan& field, size_t pos, const char* data,
+                google::protobuf::uint64 value, Level* level);
+  void WriteValue(const FieldPlan& field, const Entry& entry);
+  void WriteDefault(const FieldPlan& field);
+
+  PlanCache* plans_;
+  const ConvertOptions& options_;
+  std::string* output_;
+  /** One per level of nesting, kept in place while deeper levels are added */
+  std::vector<std::unique_ptr<Level> > levels_;
+  size_t depth_;
+};
+
+}  // namespace pjconv
+#endif  // PJCONV_WIRE_JSON_WRITER_H_
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2013 Binson Zhang.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @author	Binson Zhang <bin183cs@gmail.com>
+ * @date		2014-01-05
+ */
+
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "pjconv/wire_json_writer.h"
+#include "pjconv/json_writer.h"
+#include "pjconv/test_util.h"
+
+namespace pjconv {
+
+namespace pb = google::protobuf;
+
+namespace {
+
+// Parsing the bytes and writing the message, which transcoding must reproduce
+std::string ParseAndWrite(const pb::Message& prototype, const std::string& bytes,
+                          bool convert_unset_fields) {
+  std::unique_ptr<pb::Message> message(prototype.New());
+  EXPECT_TRUE(message->ParseFromString(bytes));
+  PlanCache plans;
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  std::string json;
+  JsonWriter(&plans, options, &json).WriteMessage(*message);
+  return json;
+}
+
+std::string Transcode(const pb::Message& prototype, const std::string& bytes,
+                      bool convert_unset_fields) {
+  PlanCache plans;
+  ConvertOptions options;
+  options.convert_unset_fields = convert_unset_fields;
+  std::string json;
+  WireJsonWriter writer(&plans, options);
+  EXPECT_TRUE(writer.Write(bytes.data(), bytes.size(), prototype.GetDescriptor(), &json));
+  return json;
+}
+
+void ExpectSame(const pb::Message& prototype, const std::string& bytes) {
+  EXPECT_EQ(ParseAndWrite(prototype, bytes, true), Transcode(prototype, bytes, true));
+  EXPECT_EQ(ParseAndWrite(prototype, bytes, false), Transcode(prototype, bytes, false));
+}
+
+std::string Tag(int number, int wire) {
+  std::string bytes;
+  pb::uint32 tag = (number << 3) | wire;
+  while (tag >= 0x80) {
+    bytes.push_back(static_cast<char>(tag | 0x80));
+    tag >>= 7;
+  }
+  bytes.push_back(static_cast<char>(tag));
+  return bytes;
+}
+
+}  // namespace
+
+TEST(WireJsonWriter, MatchesParsedMessages) {
+  tutorial::AddressBook ab;
+  test::BuildAddressBook(&ab);
+  ab.mutable_person(1)->set_id(2);
+  ExpectSame(ab, ab.SerializeAsString());
+
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  ExpectSame(*m, "");
+  test::BuildTypes(m.get());
+  ExpectSame(*m, m->SerializeAsString());
+}
+
+TEST(WireJsonWriter, MergesLikeTheParser) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  test::BuildTypes(m.get());
+  std::unique_ptr<pb::Message> other(test::NewTypes());
+  const pb::Descriptor* desc = other->GetDescriptor();
+  const pb::Reflection* ref = other->GetReflection();
+  ref->SetInt32(other.get(), desc->FindFieldByName("i32"), 5);
+  pb::Message* inner = ref->MutableMessage(other.get(), desc->FindFieldByName("inner"));
+  inner->GetReflection()->SetString(inner, inner->GetDescriptor()->FindFieldByName("tag"), "t");
+  ref->AddInt32(other.get(), desc->FindFieldByName("packed_i32"), 9);
+  // Singular values are replaced, embedded messages merged, repeated values appended
+  ExpectSame(*m, m->SerializeAsString() + other->SerializeAsString());
+
+  // Repeated scalars are read packed or not, whatever the field says
+  std::string bytes = Tag(21, 2) + "\x03\x01\x02\x03" + Tag(31, 0) + "\x07";
+  ExpectSame(*m, bytes);
+  EXPECT_EQ("{\"packed_i32\":[7],\"r_i32\":[1,2,3]}", Transcode(*m, bytes, false));
+}
+
+TEST(WireJsonWriter, SkipsUnknownFields) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  // An unknown varint, an unknown group holding a field, a known field with
+  // the wrong wire type and an unknown value of a closed enum
+  std::string bytes = Tag(100, 0) + "\x96\x01" +
+                      Tag(101, 3) + Tag(1, 2) + "\x01x" + Tag(101, 4) +
+                      Tag(1, 5) + "abcd" +
+                      Tag(8, 0) + "\x09" +
+                      Tag(28, 0) + "\x02" + Tag(28, 0) + "\x05" +
+                      Tag(9, 2) + "\x02ok";
+  ExpectSame(*m, bytes);
+  EXPECT_EQ("{\"r_color\":[\"BLUE\"],\"s\":\"ok\"}", Transcode(*m, bytes, false));
+}
+
+TEST(WireJsonWriter, FollowsProto3Rules) {
+  std::unique_ptr<pb::Message> event(test::NewEvent());
+  const pb::Message& prototype = *event;
+  const pb::Descriptor* desc = event->GetDescriptor();
+  const pb::Reflection* ref = event->GetReflection();
+  ref->SetString(event.get(), desc->FindFieldByName("name"), "e");
+  ref->SetEnumValue(event.get(), desc->FindFieldByName("level"), 7);
+  ref->SetDouble(event.get(), desc->FindFieldByName("score"), -0.0);
+  ref->AddInt32(event.get(), desc->FindFieldByName("codes"), -2);
+  pb::Message* child = ref->MutableMessage(event.get(), desc->FindFieldByName("child"));
+  child->GetReflection()->SetInt64(child, child->GetDescriptor()->FindFieldByName("id"), 3);
+  ExpectSame(prototype, event->SerializeAsString());
+
+  // Zero values written explicitly stay unset, and the last member of a oneof wins
+  std::string bytes = Tag(1, 0) + std::string("\x00", 1) + Tag(2, 2) + std::string("\x00", 1) +
+                      Tag(5, 2) + "\x02" + Tag(1, 0) + "\x01" +
+                      Tag(4, 2) + "\x01t" +
+                      Tag(5, 2) + "\x09" + Tag(6, 1) + std::string(8, '\0');
+  ExpectSame(prototype, bytes);
+  EXPECT_EQ("{\"child\":null}", Transcode(prototype, bytes, false));
+}
+
+TEST(WireJsonWriter, RejectsMalformedInput) {
+  std::unique_ptr<pb::Message> m(test::NewTypes());
+  const char* bad[] = {
+    "\x08",              // a truncated varint
+    "\x4a\x05" "ab",     // a string longer than the input
+    "\x29" "abc",        // a truncated fixed64
+    "\x0c",              // a stray end of group
+    "\x0e",              // an undefined wire type
+    "\x52\x03\x08",      // an embedded message cut short
+  };
+  PlanCache plans;
+  ConvertOptions options;
+  WireJsonWriter writer(&plans, options);
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+    std::string json = "[";
+    EXPECT_FALSE(writer.Write(bad[i], strlen(bad[i]), m->GetDescriptor(), &json)) << i;
+    EXPECT_EQ("[", json);
+  }
+
+  // A person without the required id
+  std::string json;
+  std::string bytes;
+  tutorial::AddressBook ab;
+  ab.add_person()->set_name("x");
+  bytes = ab.SerializePartialAsString();
+  EXPECT_FALSE(writer.Write(bytes.data(), bytes.size(), ab.GetDescriptor(), &json));
+
+  // Invalid UTF-8 in a proto3 string
+  bytes = Tag(2, 2) + "\x01\xff";
+  EXPECT_FALSE(writer.Write(bytes.data(), bytes.size(), test::EventDescriptor(), &json));
+}
+
+}  // namespace pjconv